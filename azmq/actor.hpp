@@ -10,11 +10,13 @@
 #define AZMQ_ACTOR_HPP_
 
 #include "socket.hpp"
+#include "pipe.hpp"
 #include "detail/actor_service.hpp"
 
 #include <boost/asio/io_service.hpp>
 
 #include <functional>
+#include <type_traits>
 
 namespace azmq { namespace actor {
 AZMQ_V1_INLINE_NAMESPACE_BEGIN
@@ -23,6 +25,7 @@ AZMQ_V1_INLINE_NAMESPACE_BEGIN
     using detached = detail::actor_service::detached;
     using start = detail::actor_service::start;
     using last_error = detail::actor_service::last_error;
+    using pool = detail::actor_pool;
 
     /** \brief create an actor bound to one end of a pipe (pair of inproc sockets)
      *  \param peer io_service to associate the peer (caller) end of the pipe
@@ -74,6 +77,86 @@ AZMQ_V1_INLINE_NAMESPACE_BEGIN
                                             std::forward<Args>(args)...));
     }
 
+    /** \brief create an actor scheduled on a shared worker pool, bound to one
+     *  end of a pipe (pair of inproc sockets)
+     *  \param peer io_service to associate the peer (caller) end of the pipe
+     *  \param p pool on which to schedule the actor
+     *  \param defer_start bool, if true the actor is not started until the
+     *  'start' option is set on the returned socket
+     *  \param f Function accepting socket& as the first parameter and a
+     *           number of additional args
+     *  \returns peer socket
+     *
+     *  \remark Rather than running on a dedicated thread and io_service, the
+     *  actor's socket is created on the pool's io_service and the supplied
+     *  function is invoked through a strand on one of the pool's threads.
+     *  The function must not block or call run() on the socket's io_service;
+     *  it should initiate async operations on the supplied socket and return.
+     *  Completions of operations on that socket run on the pool's threads
+     *  through the same strand, so an actor's handlers never run
+     *  concurrently with one another and need no further synchronization.
+     *
+     *  \remark Destroying the returned socket shuts the actor's socket down
+     *  and cancels any operations outstanding on it, unless the 'detached'
+     *  option has been set; operations the actor starts afterwards fail with
+     *  operation_not_permitted. The 'is_alive' option reports false once the
+     *  actor has been stopped or has thrown, from its function or from the
+     *  handler of an async send or receive on its socket, in which case the
+     *  exception is available through the 'last_error' option.
+     *
+     *  \remark The pool must outlive the returned socket.
+     */
+    template<typename Function, typename... Args>
+    socket spawn(boost::asio::io_service & peer, pool & p, bool defer_start,
+                 Function && f, Args&&... args) {
+        return detail::actor_service::make_pipe(peer, p, defer_start,
+                                                std::bind(std::forward<Function>(f),
+                                                          std::placeholders::_1,
+                                                          std::forward<Args>(args)...));
+    }
+
+    template<typename Function, typename... Args>
+    socket spawn(boost::asio::io_service & peer, pool & p, Function && f, Args&&... args) {
+        return detail::actor_service::make_pipe(peer, p, false,
+                                                std::bind(std::forward<Function>(f),
+                                                          std::placeholders::_1,
+                                                          std::forward<Args>(args)...));
+    }
+
+#if ! defined BOOST_ASIO_WINDOWS
+    /** \brief create an actor bound to one end of an azmq::pipe
+     *  \param peer io_service to associate the peer (caller) end of the pipe
+     *  \param capacity maximum number of messages queued in each direction
+     *  \param f Function accepting pipe& as the first parameter and a
+     *           number of additional args
+     *  \returns peer end of the pipe
+     *
+     *  \remark As with spawn(), the actor runs in its own thread and io_service
+     *  and should ultimately call run() on the io_service associated with the
+     *  supplied pipe. Messages between the actor and its peer travel over a
+     *  pair of in-process rings rather than a pair of inproc sockets, see
+     *  azmq::pipe.
+     *
+     *  \remark Destroying the returned pipe closes it, stops the actor's
+     *  io_service and joins its thread. If the actor's function throws, its
+     *  end of the pipe is closed and the peer's operations complete with
+     *  boost::asio::error::broken_pipe.
+     */
+    template<typename Function, typename... Args>
+    pipe spawn_pipe(boost::asio::io_service & peer, size_t capacity, Function && f, Args&&... args) {
+        return detail::actor_service::make_inproc_pipe(peer, capacity,
+                                                       std::bind(std::forward<Function>(f),
+                                                                 std::placeholders::_1,
+                                                                 std::forward<Args>(args)...));
+    }
+
+    template<typename Function, typename... Args>
+    auto spawn_pipe(boost::asio::io_service & peer, Function && f, Args&&... args) ->
+        typename std::enable_if<!std::is_integral<typename std::decay<Function>::type>::value, pipe>::type {
+        return spawn_pipe(peer, 1024, std::forward<Function>(f), std::forward<Args>(args)...);
+    }
+#endif // ! defined BOOST_ASIO_WINDOWS
+
 AZMQ_V1_INLINE_NAMESPACE_END
 } // namespace actor
 } // namespace azmq
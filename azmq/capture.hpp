@@ -0,0 +1,227 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_CAPTURE_HPP_
+#define AZMQ_CAPTURE_HPP_
+
+#include "socket.hpp"
+#include "detail/capture_ext.hpp"
+#include "detail/capture_log.hpp"
+#include "detail/socket_service.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace azmq {
+namespace detail {
+    template<typename Handler>
+    class replay_op : public std::enable_shared_from_this<replay_op<Handler>> {
+    public:
+        replay_op(socket & s, std::shared_ptr<capture_reader> reader,
+                  bool paced, unsigned directions, Handler handler)
+            : socket_(s)
+            , reader_(std::move(reader))
+            , paced_(paced)
+            , directions_(directions)
+            , timer_(s.get_io_service())
+            , handler_(std::move(handler))
+        { }
+
+        void next() {
+            if (!read()) {
+                complete(boost::system::error_code());
+                return;
+            }
+            if (paced_ && !in_message_) {
+                auto due = start_ + (record_.time - first_);
+                if (due > std::chrono::steady_clock::now()) {
+                    auto self = this->shared_from_this();
+                    timer_.expires_at(due);
+                    timer_.async_wait([self](boost::system::error_code const& ec) {
+                        if (ec)
+                            self->handler_(ec, self->frames_);
+                        else
+                            self->send();
+                    });
+                    return;
+                }
+            }
+            send();
+        }
+
+    private:
+        socket & socket_;
+        std::shared_ptr<capture_reader> reader_;
+        bool const paced_;
+        unsigned const directions_;
+        boost::asio::steady_timer timer_;
+        Handler handler_;
+        capture_reader::record record_;
+        std::chrono::steady_clock::time_point start_;
+        std::chrono::nanoseconds first_;
+        bool started_ = false;
+        bool in_message_ = false;
+        size_t frames_ = 0;
+
+        // posted, as next() is first called from async_replay
+        void complete(boost::system::error_code const& ec) {
+            auto self = this->shared_from_this();
+            socket_.get_io_service().post([self, ec] { self->handler_(ec, self->frames_); });
+        }
+
+        bool read() {
+            while (reader_->next(record_)) {
+                if (directions_ & (record_.sent ? capture_sent : capture_received)) {
+                    if (!started_) {
+                        started_ = true;
+                        start_ = std::chrono::steady_clock::now();
+                        first_ = record_.time;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void send() {
+            auto self = this->shared_from_this();
+            in_message_ = record_.more;
+            // the op refers to the buffer sequence, which record_ holds until
+            // the send completes
+            socket_.async_send(record_.data, [self](boost::system::error_code const& ec, size_t) {
+                if (ec) {
+                    self->handler_(ec, self->frames_);
+                    return;
+                }
+                ++self->frames_;
+                self->next();
+            }, record_.more ? ZMQ_SNDMORE : 0);
+        }
+    };
+} // namespace detail
+
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+    /** \brief append only, memory mapped log of captured frames
+     *  \remark Each frame is recorded with a nanosecond timestamp, its
+     *  direction, and whether more parts of its message follow. Recording
+     *  copies the frame into the mapping and does not allocate; the file is
+     *  grown geometrically from an initial reservation (64MiB by default).
+     *  A writer may be shared by several sockets.
+     */
+    using capture_writer = detail::capture_writer;
+
+    /** \brief reads a log written by capture_writer, record by record */
+    using capture_reader = detail::capture_reader;
+
+    using capture_direction = detail::capture_direction;
+    using detail::capture_received;
+    using detail::capture_sent;
+    using detail::capture_both;
+
+    /** \brief replay frames with the spacing they were captured with, or as
+     *  fast as the socket will accept them
+     */
+    enum class replay_pace { original, fastest };
+
+    /** \brief record frames sent and/or received on a socket
+     *  \param s socket to tap
+     *  \param writer log to record to
+     *  \param directions capture_direction mask of frames to record
+     *  \return true if capture was enabled, false if the socket is already
+     *  being captured
+     *  \remark Frames passing through the message overloads of send() and
+     *  receive(), and of async_send() and async_receive(), are recorded;
+     *  frames sent or received through the buffer sequence overloads are
+     *  not. A sent frame is recorded once it has been sent, so a send which
+     *  fails, would block, is cancelled or times out records nothing.
+     */
+    inline bool enable_capture(socket & s, std::shared_ptr<capture_writer> writer,
+                               unsigned directions = capture_both) {
+        return detail::associate_ext(s, detail::capture_ext(std::move(writer), directions));
+    }
+
+    /** \brief stop recording frames on a socket
+     *  \return false if the socket was not being captured
+     */
+    inline bool disable_capture(socket & s) {
+        return detail::remove_ext<socket, detail::capture_ext>(s);
+    }
+
+    /** \brief send the frames in a log on a socket, blocking until done
+     *  \param s socket to send on
+     *  \param reader log to replay from its current position
+     *  \param pace replay_pace
+     *  \param directions capture_direction mask of frames to replay
+     *  \param ec set to the first send error
+     *  \return number of frames sent
+     */
+    inline size_t replay(socket & s, capture_reader & reader, replay_pace pace,
+                         unsigned directions, boost::system::error_code & ec) {
+        capture_reader::record r;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::nanoseconds first{ 0 };
+        size_t res = 0;
+        bool in_message = false;
+        while (reader.next(r)) {
+            if (!(directions & (r.sent ? capture_sent : capture_received)))
+                continue;
+            if (!res) {
+                start = std::chrono::steady_clock::now();
+                first = r.time;
+            }
+            if (pace == replay_pace::original && !in_message)
+                std::this_thread::sleep_until(start + (r.time - first));
+            in_message = r.more;
+            s.send(boost::asio::buffer(r.data), r.more ? ZMQ_SNDMORE : 0, ec);
+            if (ec)
+                break;
+            ++res;
+        }
+        return res;
+    }
+
+    /** \brief send the frames in a log on a socket, blocking until done
+     *  \throw boost::system::system_error
+     */
+    inline size_t replay(socket & s, capture_reader & reader,
+                         replay_pace pace = replay_pace::fastest,
+                         unsigned directions = capture_sent) {
+        boost::system::error_code ec;
+        auto res = replay(s, reader, pace, directions, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+    /** \brief send the frames in a log on a socket asynchronously
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept,
+     *  and is passed the number of frames sent
+     *  \param s socket to send on, which must outlive the replay
+     *  \param reader log to replay from its current position
+     *  \param handler WriteHandler
+     *  \param pace replay_pace, original spacing is kept with a steady_timer
+     *  \param directions capture_direction mask of frames to replay
+     */
+    template<typename WriteHandler>
+    void async_replay(socket & s, std::shared_ptr<capture_reader> reader, WriteHandler && handler,
+                      replay_pace pace = replay_pace::fastest, unsigned directions = capture_sent) {
+        using type = detail::replay_op<typename std::decay<WriteHandler>::type>;
+        std::make_shared<type>(s, std::move(reader), pace == replay_pace::original, directions,
+                               std::forward<WriteHandler>(handler))->next();
+    }
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_CAPTURE_HPP_
@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_CODEC_HPP_
+#define AZMQ_CODEC_HPP_
+
+#include "socket.hpp"
+#include "detail/codec_ext.hpp"
+#include "detail/socket_service.hpp"
+
+#include <boost/system/system_error.hpp>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+    using codec_type = detail::codec_type;
+    using codec_stats = detail::codec_stats;
+
+    /** \brief socket option selecting the codec used to encode frames sent on
+     *  a socket with enable_codec(), received frames are decoded whichever
+     *  codec the sender chose
+     */
+    using codec = detail::codec_ext::codec;
+
+    /** \brief socket option setting the minimum size of a frame to encode */
+    using codec_threshold = detail::codec_ext::threshold;
+
+    /** \brief socket option yielding the codec's counters, setting it resets
+     *  them
+     */
+    using codec_counters = detail::codec_ext::counters;
+
+    /** \brief socket option setting the largest size a received frame may
+     *  decode to, larger frames fail the receive with protocol_error
+     *  \remark Defaults to the socket's ZMQ_MAXMSGSIZE when the codec is
+     *  enabled, if set, otherwise 64 MiB. Zero lifts the limit.
+     */
+    using codec_max_size = detail::codec_ext::max_size;
+
+    /** \brief transparently compress frames sent on a socket and decompress
+     *  frames received on it
+     *  \param s socket
+     *  \param type codec used for frames sent, codec_type::none to only decode
+     *  \param threshold minimum size of a frame to compress
+     *  \param ec error_code to set on error, protocol_not_supported if type is
+     *  not available in this build
+     *  \return true if the codec was installed, false if the socket already
+     *  has one; use the codec and codec_threshold options to change it
+     *
+     *  \remark Both ends of a connection must enable a codec. Only the message
+     *  overloads of send() and receive(), and async_send() and async_receive()
+     *  taking a message or MessageReadHandler, pass through the codec. Bytes
+     *  transferred report the encoded size on send and the decoded size on
+     *  receive.
+     *  \remark The last (or only) frame of each message is encoded, frames
+     *  sent with ZMQ_SNDMORE pass unchanged.
+     */
+    inline bool enable_codec(socket & s, codec_type type, size_t threshold,
+                             boost::system::error_code & ec) {
+        if (!detail::codec_ext::is_supported(type)) {
+            ec = make_error_code(boost::system::errc::protocol_not_supported);
+            return false;
+        }
+        return detail::associate_ext(s, detail::codec_ext(type, threshold));
+    }
+
+    /** \brief transparently compress frames sent on a socket and decompress
+     *  frames received on it
+     *  \throw boost::system::system_error
+     */
+    inline bool enable_codec(socket & s, codec_type type = codec_type::lz, size_t threshold = 512) {
+        boost::system::error_code ec;
+        auto res = enable_codec(s, type, threshold, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_CODEC_HPP_
@@ -16,11 +16,124 @@
 #include <boost/asio/io_service.hpp>
 #include <zmq.h>
 
+#include <vector>
+
 namespace azmq {
 AZMQ_V1_INLINE_NAMESPACE_BEGIN
     using io_threads = detail::context_ops::io_threads;
     using max_sockets = detail::context_ops::max_sockets;
     using ipv6 = detail::context_ops::ipv6;
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+    using thread_affinity_cpu_add = detail::context_ops::thread_affinity_cpu_add;
+    using thread_affinity_cpu_remove = detail::context_ops::thread_affinity_cpu_remove;
+#endif
+#ifdef ZMQ_THREAD_SCHED_POLICY
+    using thread_sched_policy = detail::context_ops::thread_sched_policy;
+    using thread_priority = detail::context_ops::thread_priority;
+#endif
+#ifdef ZMQ_THREAD_NAME_PREFIX
+    using thread_name_prefix = detail::context_ops::thread_name_prefix;
+#endif
+    using context_type = detail::context_ops::context_type;
+    using context_policy = detail::context_ops::context_policy;
+
+    /** \brief create a new, unshared zeromq context
+     *  \param io_threads number of libzmq io threads, 0 leaves the default
+     *  \param ec boost::system::error_code
+     */
+    inline context_type make_context(int io_threads, boost::system::error_code & ec) {
+        return detail::context_ops::get_context(context_policy::per_io_service, io_threads, -1, ec);
+    }
+
+    /** \brief the zeromq context used by sockets created on an io_service
+     *  \param io_service io_service
+     */
+    inline context_type get_context(boost::asio::io_service & io_service) {
+        return boost::asio::use_service<detail::socket_service>(io_service).context();
+    }
+
+    /** \brief attach an explicitly created zeromq context to an io_service
+     *  \param io_service io_service
+     *  \param ctx context to use for sockets subsequently created on io_service
+     *  \remark Sockets already created on io_service are unaffected, and keep
+     *  their original context alive until they are closed.
+     */
+    inline void set_context(boost::asio::io_service & io_service, context_type ctx) {
+        boost::asio::use_service<detail::socket_service>(io_service).set_context(std::move(ctx));
+    }
+
+    /** \brief service the sockets of an io_service through one aggregated
+     *  poller
+     *  \param io_service io_service
+     *  \param ec boost::system::error_code, set to not_supported on platforms
+     *  without a poller backend
+     *  \remark By default each socket registers its own ZMQ_FD with the
+     *  io_service's reactor and arms a separate wait on it. With the poller,
+     *  all ZMQ_FDs are gathered behind a single descriptor and one wakeup
+     *  services every ready socket in a batch, which scales to much larger
+     *  socket counts per thread. Call before starting operations on sockets;
+     *  sockets with operations already pending keep their own registration.
+     */
+    inline boost::system::error_code use_poller(boost::asio::io_service & io_service,
+                                                boost::system::error_code & ec) {
+        return boost::asio::use_service<detail::socket_service>(io_service).use_poller(ec);
+    }
+
+    /** \brief service the sockets of an io_service through one aggregated
+     *  poller
+     *  \param io_service io_service
+     *  \throw boost::system::system_error
+     */
+    inline void use_poller(boost::asio::io_service & io_service) {
+        boost::system::error_code ec;
+        if (use_poller(io_service, ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief choose how the zeromq context used by an io_service is obtained
+     *  \param io_service io_service
+     *  \param policy context_policy::global shares the process wide context,
+     *  context_policy::per_io_service creates a private context and
+     *  context_policy::per_numa_node shares a context between all io_services
+     *  using the same NUMA node, with its io threads pinned to that node's CPUs
+     *  \param io_threads number of libzmq io threads for a newly created
+     *  context, 0 leaves the libzmq default. For context_policy::global this
+     *  only takes effect if no socket has yet been created on the global
+     *  context.
+     *  \param numa_node node for context_policy::per_numa_node, -1 selects the
+     *  node of the calling thread, which should be the thread that will run
+     *  io_service
+     *  \param ec boost::system::error_code
+     *  \remark Sockets already created on io_service are unaffected.
+     */
+    inline boost::system::error_code set_context_policy(boost::asio::io_service & io_service,
+                                                        context_policy policy,
+                                                        int io_threads,
+                                                        int numa_node,
+                                                        boost::system::error_code & ec) {
+        auto ctx = detail::context_ops::get_context(policy, io_threads, numa_node, ec);
+        if (!ec)
+            set_context(io_service, std::move(ctx));
+        return ec;
+    }
+
+    /** \brief choose how the zeromq context used by an io_service is obtained
+     *  \param io_service io_service
+     *  \param policy context_policy
+     *  \param io_threads number of libzmq io threads for a newly created
+     *  context, 0 leaves the libzmq default
+     *  \param numa_node node for context_policy::per_numa_node, -1 selects the
+     *  node of the calling thread
+     *  \throw boost::system::system_error
+     */
+    inline void set_context_policy(boost::asio::io_service & io_service,
+                                   context_policy policy,
+                                   int io_threads = 0,
+                                   int numa_node = -1) {
+        boost::system::error_code ec;
+        if (set_context_policy(io_service, policy, io_threads, numa_node, ec))
+            throw boost::system::system_error(ec);
+    }
 
     /** \brief set options on the zeromq context.
      *  \tparam Option option type
@@ -66,7 +179,43 @@ AZMQ_V1_INLINE_NAMESPACE_BEGIN
     template<typename Option>
     void get_option(boost::asio::io_service & io_service, Option & option) {
         boost::system::error_code ec;
-        if (get_option(io_service, option))
+        if (get_option(io_service, option, ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief dedicate a set of CPUs to the sockets of an io_service
+     *  \param io_service io_service
+     *  \param cpus CPUs to which the new context's io threads are pinned
+     *  \param io_threads number of io threads, 0 starts one per cpu
+     *  \param ec boost::system::error_code
+     *  \remark attaches a new context to io_service, sockets subsequently
+     *  created on io_service are serviced only by io threads running on cpus.
+     *  libzmq applies a context's CPU affinity to all of its io threads, use
+     *  io_thread_affinity() to further spread hot sockets across those threads.
+     */
+    inline boost::system::error_code dedicate_cpus(boost::asio::io_service & io_service,
+                                                   std::vector<int> const& cpus,
+                                                   int io_threads,
+                                                   boost::system::error_code & ec) {
+        if (!io_threads)
+            io_threads = static_cast<int>(cpus.size());
+        auto ctx = detail::context_ops::get_pinned_context(cpus, io_threads, ec);
+        if (!ec)
+            set_context(io_service, std::move(ctx));
+        return ec;
+    }
+
+    /** \brief dedicate a set of CPUs to the sockets of an io_service
+     *  \param io_service io_service
+     *  \param cpus CPUs to which the new context's io threads are pinned
+     *  \param io_threads number of io threads, 0 starts one per cpu
+     *  \throw boost::system::system_error
+     */
+    inline void dedicate_cpus(boost::asio::io_service & io_service,
+                              std::vector<int> const& cpus,
+                              int io_threads = 0) {
+        boost::system::error_code ec;
+        if (dedicate_cpus(io_service, cpus, io_threads, ec))
             throw boost::system::system_error(ec);
     }
 AZMQ_V1_INLINE_NAMESPACE_END
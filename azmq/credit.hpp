@@ -0,0 +1,405 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_CREDIT_HPP_
+#define AZMQ_CREDIT_HPP_
+
+#include "socket.hpp"
+#include "message.hpp"
+#include "error.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace azmq {
+namespace detail {
+    struct credit_ops {
+        // a grant is a single frame holding two native endian uint64_t values,
+        // a request for the initial window is an empty frame
+        struct grant {
+            uint64_t messages = 0;
+            uint64_t bytes = 0;
+        };
+
+        static bool decode(message const& msg, grant & g) {
+            if (msg.size() != sizeof(grant) || msg.more())
+                return false;
+            std::memcpy(&g, boost::asio::buffer_cast<void const*>(msg.cbuffer()), sizeof(grant));
+            return true;
+        }
+    };
+
+    class credit_op {
+    public:
+        message msg_;
+
+        explicit credit_op(message msg) : msg_(std::move(msg)) { }
+        virtual ~credit_op() = default;
+
+        virtual void start(socket & s) = 0;
+        virtual void abort(boost::asio::io_service & ios, boost::system::error_code const& ec) = 0;
+    };
+
+    template<typename WriteHandler>
+    class credit_send_op : public credit_op {
+    public:
+        credit_send_op(message msg, WriteHandler handler)
+            : credit_op(std::move(msg))
+            , handler_(std::move(handler))
+        { }
+
+        void start(socket & s) override {
+            s.async_send(std::move(msg_), std::move(handler_));
+        }
+
+        void abort(boost::asio::io_service & ios, boost::system::error_code const& ec) override {
+            ios.post([h = std::move(handler_), ec]() mutable {
+                h(ec, 0);
+            });
+        }
+
+    private:
+        WriteHandler handler_;
+    };
+} // namespace detail
+
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief Sending side of a credit based flow control link
+ *  \remark Wraps a DEALER (or PAIR) socket connected to a credit_receiver. On
+ *  construction the sender asks the receiver for its window; thereafter the
+ *  receiver grants credit, in messages and bytes, as it consumes messages.
+ *  async_send() only hands a message to the socket while both credits are
+ *  positive, otherwise it is held until a grant arrives, so at most one
+ *  window (plus one message) is ever buffered in libzmq's pipes and in the
+ *  socket's op queue, regardless of HWM.
+ *  \remark The socket must not be used to receive anything other than grants.
+ *  Empty messages are reserved for the protocol and may not be sent.
+ *  \remark A failed receive of a grant is retried, unless it was cancelled,
+ *  the socket shut down, its context terminated or the error repeats the
+ *  previous receive's.
+ *  Grants then stop, so sends held for credit and any started afterwards
+ *  complete with that error.
+ *  \remark credit_sender is not thread safe and is neither copyable nor
+ *  movable.
+ */
+class credit_sender {
+public:
+    /** \brief construct a sender and request the initial window
+     *  \param s connected (or connecting) DEALER or PAIR socket
+     */
+    explicit credit_sender(socket s)
+        : state_(std::make_shared<state>(std::move(s)))
+    {
+        state::start(state_);
+        state_->socket_.async_send(message(), [](boost::system::error_code const&, size_t) { });
+    }
+
+    credit_sender(credit_sender const&) = delete;
+    credit_sender & operator=(credit_sender const&) = delete;
+
+    ~credit_sender() {
+        auto & ios = state_->socket_.get_io_service();
+        for (auto & op : state_->pending_)
+            op->abort(ios, boost::asio::error::operation_aborted);
+        state_->pending_.clear();
+        boost::system::error_code ec;
+        state_->socket_.cancel(ec);
+    }
+
+    socket & get_socket() { return state_->socket_; }
+
+    /** \brief Initiate an async send operation, which completes once credit
+     *  is available and the message has been written to the socket
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept
+     *  \param msg message to send, must not be empty
+     *  \param handler WriteHandler
+     */
+    template<typename WriteHandler>
+    void async_send(message msg, WriteHandler && handler) {
+        using type = detail::credit_send_op<typename std::decay<WriteHandler>::type>;
+        std::unique_ptr<detail::credit_op> op{ new type(std::move(msg), std::forward<WriteHandler>(handler)) };
+        if (state_->failed_) {
+            op->abort(state_->socket_.get_io_service(), state_->failed_);
+            return;
+        }
+        state_->pending_.push_back(std::move(op));
+        state_->drain();
+    }
+
+    /** \brief messages which may be sent before the next grant */
+    int64_t message_credit() const { return state_->messages_; }
+
+    /** \brief bytes which may be sent before the next grant */
+    int64_t byte_credit() const { return state_->bytes_; }
+
+    /** \brief number of sends waiting for credit */
+    size_t pending() const { return state_->pending_.size(); }
+
+private:
+    struct state {
+        using ptr = std::shared_ptr<state>;
+        using weak_ptr = std::weak_ptr<state>;
+
+        socket socket_;
+        int64_t messages_ = 0;
+        int64_t bytes_ = 0;
+        std::deque<std::unique_ptr<detail::credit_op>> pending_;
+        boost::system::error_code last_error_; // of the previous receive
+        boost::system::error_code failed_; // which ended grants
+
+        explicit state(socket s) : socket_(std::move(s)) { }
+
+        static void start(ptr const& p) {
+            weak_ptr w = p;
+            p->socket_.async_receive([w](boost::system::error_code const& ec, message & msg, size_t) {
+                auto p = w.lock();
+                if (!p)
+                    return;
+                if (ec) {
+                    if (detail::socket_ops::ends_receive(ec) || ec == p->last_error_)
+                        p->fail(ec);
+                    else
+                        start(p);
+                    p->last_error_ = ec;
+                    return;
+                }
+                p->last_error_.clear();
+                detail::credit_ops::grant g;
+                if (detail::credit_ops::decode(msg, g)) {
+                    p->messages_ += g.messages;
+                    p->bytes_ += g.bytes;
+                    p->drain();
+                }
+                start(p);
+            });
+        }
+
+        // no more credit will arrive
+        void fail(boost::system::error_code const& ec) {
+            failed_ = ec;
+            auto & ios = socket_.get_io_service();
+            for (auto & op : pending_)
+                op->abort(ios, ec);
+            pending_.clear();
+        }
+
+        void drain() {
+            while (!pending_.empty() && messages_ > 0 && bytes_ > 0) {
+                auto op = std::move(pending_.front());
+                pending_.pop_front();
+                messages_ -= 1;
+                bytes_ -= op->msg_.size();
+                op->start(socket_);
+            }
+        }
+    };
+
+    std::shared_ptr<state> state_;
+};
+
+/** \brief Receiving side of a credit based flow control link
+ *  \remark Wraps a DEALER, PAIR or ROUTER socket. Each credit_sender is
+ *  granted a window of window_messages and window_bytes when it connects, and
+ *  credit is returned for each message once the handler that received it
+ *  returns. Grants are batched, a peer is sent a grant once a quarter of
+ *  either window has been consumed. A grant the socket cannot take at once
+ *  is queued and written asynchronously, in order.
+ *  \remark On a ROUTER socket credit is tracked per peer and the identity
+ *  frame is stripped before the message is handed to the handler.
+ *  \remark credit_receiver is not thread safe and is neither copyable nor
+ *  movable.
+ */
+class credit_receiver {
+public:
+    /** \brief construct a receiver
+     *  \param s DEALER, PAIR or ROUTER socket
+     *  \param window_messages maximum number of messages in flight per peer
+     *  \param window_bytes maximum number of bytes in flight per peer
+     */
+    credit_receiver(socket s, uint64_t window_messages, uint64_t window_bytes)
+        : state_(std::make_shared<state>(std::move(s), window_messages, window_bytes))
+    { }
+
+    credit_receiver(credit_receiver const&) = delete;
+    credit_receiver & operator=(credit_receiver const&) = delete;
+
+    ~credit_receiver() {
+        boost::system::error_code ec;
+        state_->socket_.cancel(ec);
+    }
+
+    socket & get_socket() { return state_->socket_; }
+
+    /** \brief Initiate an async receive operation
+     *  \tparam MessageReadHandler must conform to the MessageReadHandler
+     *  concept described for azmq::socket::async_receive
+     *  \param handler MessageReadHandler, credit for the message is returned
+     *  to its sender when the handler returns
+     */
+    template<typename MessageReadHandler>
+    void async_receive(MessageReadHandler && handler) {
+        state::receive(state_, std::forward<MessageReadHandler>(handler));
+    }
+
+private:
+    struct state {
+        using ptr = std::shared_ptr<state>;
+        using weak_ptr = std::weak_ptr<state>;
+
+        socket socket_;
+        bool const routed_;
+        detail::credit_ops::grant const window_;
+        // credit consumed but not yet returned, per peer identity
+        std::unordered_map<std::string, detail::credit_ops::grant> owed_;
+        std::string peer_;
+
+        struct unsent_grant {
+            std::string peer;
+            detail::credit_ops::grant credit;
+        };
+        // grants which would have blocked, the front one being written
+        std::deque<unsent_grant> unsent_;
+        std::vector<boost::asio::const_buffer> writing_;
+
+        state(socket s, uint64_t window_messages, uint64_t window_bytes)
+            : socket_(std::move(s))
+            , routed_(is_router(socket_))
+            , window_{ window_messages, window_bytes }
+        { }
+
+        static bool is_router(socket & s) {
+            socket::type t;
+            s.get_option(t);
+            return t.value() == ZMQ_ROUTER;
+        }
+
+        template<typename MessageReadHandler>
+        static void receive(ptr const& p, MessageReadHandler && handler) {
+            weak_ptr w = p;
+            p->socket_.async_receive(
+                [w, handler = std::forward<MessageReadHandler>(handler)](boost::system::error_code const& ec,
+                                                                         message & msg, size_t bytes_transferred) mutable {
+                    auto p = w.lock();
+                    if (ec || !p) {
+                        handler(ec, msg, bytes_transferred);
+                        return;
+                    }
+                    boost::system::error_code rec;
+                    if (p->routed_) {
+                        p->peer_.assign(boost::asio::buffer_cast<char const*>(msg.cbuffer()), msg.size());
+                        bytes_transferred = p->socket_.receive(msg, 0, rec);
+                    }
+                    if (!rec && !msg.size()) {
+                        // a sender asking for its initial window, any credit
+                        // still owed to it or waiting to be written is void
+                        p->owed_.erase(p->peer_);
+                        p->forget_unsent(p->peer_);
+                        send_grant(p, p->window_);
+                        receive(p, std::move(handler));
+                        return;
+                    }
+                    auto size = msg.size();
+                    handler(rec, msg, bytes_transferred);
+                    if (!rec)
+                        consumed(p, size);
+                });
+        }
+
+        static void consumed(ptr const& p, size_t size) {
+            auto & g = p->owed_[p->peer_];
+            g.messages += 1;
+            g.bytes += size;
+            if (g.messages * 4 >= p->window_.messages || g.bytes * 4 >= p->window_.bytes) {
+                send_grant(p, g);
+                g = detail::credit_ops::grant();
+            }
+        }
+
+        // grants are written without blocking; one which would block is
+        // queued, as are any after it, and the queue written in order by
+        // async sends
+        static void send_grant(ptr const& p, detail::credit_ops::grant const& g) {
+            if (p->unsent_.empty() && p->try_send_grant(g))
+                return;
+            // credit for a peer already waiting, other than in the send in
+            // progress, is added to rather than queued again
+            if (p->unsent_.size() > 1) {
+                auto it = std::find_if(std::next(std::begin(p->unsent_)), std::end(p->unsent_),
+                                       [&](unsent_grant const& u) { return u.peer == p->peer_; });
+                if (it != std::end(p->unsent_)) {
+                    it->credit.messages += g.messages;
+                    it->credit.bytes += g.bytes;
+                    return;
+                }
+            }
+            p->unsent_.push_back(unsent_grant{ p->peer_, g });
+            if (p->unsent_.size() == 1)
+                write_unsent(p);
+        }
+
+        bool try_send_grant(detail::credit_ops::grant const& g) {
+            boost::system::error_code ec;
+            if (routed_) {
+                socket_.send(boost::asio::buffer(peer_), ZMQ_SNDMORE | ZMQ_DONTWAIT, ec);
+                if (ec)
+                    return false;
+            }
+            socket_.send(boost::asio::buffer(&g, sizeof(g)), ZMQ_DONTWAIT, ec);
+            return !ec;
+        }
+
+        // the send refers to the buffer sequence, which writing_ holds, and
+        // to the front of unsent_, which stays put until the send completes
+        static void write_unsent(ptr const& p) {
+            auto & u = p->unsent_.front();
+            p->writing_.clear();
+            if (p->routed_)
+                p->writing_.push_back(boost::asio::buffer(u.peer));
+            p->writing_.push_back(boost::asio::buffer(&u.credit, sizeof(u.credit)));
+            weak_ptr w = p;
+            p->socket_.async_send(p->writing_, [w](boost::system::error_code const& ec, size_t) {
+                auto p = w.lock();
+                if (!p || ec == boost::asio::error::operation_aborted)
+                    return;
+                // on any other error the grant is dropped, as the peer is
+                // gone or the socket broken
+                p->unsent_.pop_front();
+                if (!p->unsent_.empty())
+                    write_unsent(p);
+            });
+        }
+
+        void forget_unsent(std::string const& peer) {
+            if (unsent_.size() < 2)
+                return;
+            unsent_.erase(std::remove_if(std::next(std::begin(unsent_)), std::end(unsent_),
+                                         [&](unsent_grant const& u) { return u.peer == peer; }),
+                          std::end(unsent_));
+        }
+    };
+
+    std::shared_ptr<state> state_;
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_CREDIT_HPP_
@@ -11,6 +11,7 @@
 
 #include "../error.hpp"
 #include "../socket.hpp"
+#include "../pipe.hpp"
 #include "../option.hpp"
 #include "service_base.hpp"
 #include "socket_service.hpp"
@@ -22,6 +23,7 @@
 #include <boost/version.hpp>
 #include <boost/assert.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/container/flat_map.hpp>
 
 #if BOOST_VERSION < 10700
@@ -37,6 +39,57 @@
 
 namespace azmq {
 namespace detail {
+    /** \brief fixed size pool of worker threads on which pooled actors are
+     *  scheduled
+     *  \remark The pool must outlive any actors spawned on it.
+     */
+    class actor_pool {
+    public:
+        explicit actor_pool(size_t threads = thread_t::hardware_concurrency())
+            : work_(new boost::asio::io_service::work(io_service_))
+        {
+            if (!threads) threads = 1;
+            threads_.reserve(threads);
+            for (size_t i = 0; i != threads; ++i)
+                threads_.emplace_back([this] { run(); });
+        }
+
+        ~actor_pool() { stop(); }
+
+        actor_pool(actor_pool const&) = delete;
+        actor_pool & operator=(actor_pool const&) = delete;
+
+        boost::asio::io_service & get_io_service() { return io_service_; }
+
+        size_t size() const { return threads_.size(); }
+
+        void stop() {
+            work_.reset();
+            io_service_.stop();
+            for (auto& t : threads_) {
+                if (t.joinable())
+                    t.join();
+            }
+        }
+
+    private:
+        boost::asio::io_service io_service_;
+        std::unique_ptr<boost::asio::io_service::work> work_;
+        std::vector<thread_t> threads_;
+
+        // an exception can only escape a handler which is not bound to an
+        // actor (see handler_binding), it is dropped so that the other
+        // actors are still serviced
+        void run() {
+            for (;;) {
+                try {
+                    io_service_.run();
+                    return;
+                } catch (...) { }
+            }
+        }
+    };
+
     class actor_service
         : public azmq::detail::service_base<actor_service> {
     public:
@@ -72,13 +125,106 @@ namespace detail {
 #else
         static socket make_pipe(boost::asio::io_context & ios, bool defer_start, T&& data) {
 #endif	  
-            auto p = std::make_shared<model<T>>(std::forward<T>(data));
+            auto p = std::make_shared<model<concept, T>>(std::forward<T>(data));
+            auto res = p->peer_socket(ios);
+            associate_ext(res, handler<concept>(std::move(p), defer_start));
+            return std::move(res);
+        }
+
+        template<typename T>
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+        static socket make_pipe(boost::asio::io_service & ios, actor_pool & pool,
+#else
+        static socket make_pipe(boost::asio::io_context & ios, actor_pool & pool,
+#endif
+                                bool defer_start, T&& data) {
+            auto p = std::make_shared<model<pooled_concept, T>>(std::forward<T>(data),
+                                                                pool.get_io_service());
             auto res = p->peer_socket(ios);
-            associate_ext(res, handler(std::move(p), defer_start));
+            associate_ext(res, handler<pooled_concept>(std::move(p), defer_start));
             return std::move(res);
         }
 
+#if ! defined BOOST_ASIO_WINDOWS
+        template<typename T>
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+        static pipe make_inproc_pipe(boost::asio::io_service & ios, size_t capacity, T&& data) {
+#else
+        static pipe make_inproc_pipe(boost::asio::io_context & ios, size_t capacity, T&& data) {
+#endif
+            auto p = std::make_shared<pipe_model<T>>(std::forward<T>(data), ios, capacity);
+            auto res = std::move(p->peer_);
+            pipe_concept::run(p);
+            // the peer end releases this after closing, which stops the actor
+            res.set_companion(std::shared_ptr<void>(nullptr, [p](void*) { p->stop(); }));
+            return res;
+        }
+#endif // ! defined BOOST_ASIO_WINDOWS
+
     private:
+#if ! defined BOOST_ASIO_WINDOWS
+        // an actor running on a dedicated thread and io_service, which talks
+        // to its peer over an azmq::pipe rather than a pair of inproc sockets
+        struct pipe_concept {
+            boost::asio::io_service io_service_;
+            boost::asio::signal_set signals_;
+            std::pair<pipe, pipe> pipes_;
+            pipe & pipe_;
+            pipe & peer_;
+            thread_t thread_;
+
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            pipe_concept(boost::asio::io_service & peer, size_t capacity)
+#else
+            pipe_concept(boost::asio::io_context & peer, size_t capacity)
+#endif
+                : signals_(io_service_, SIGINT, SIGTERM)
+                , pipes_(pipe::create(io_service_, peer, capacity))
+                , pipe_(pipes_.first)
+                , peer_(pipes_.second)
+            { }
+
+            virtual ~pipe_concept() = default;
+
+            void stop() {
+                if (!thread_.joinable()) return;
+                io_service_.stop();
+                thread_.join();
+            }
+
+            virtual void run() = 0;
+
+            static void run(std::shared_ptr<pipe_concept> const& p) {
+                auto pp = p.get();
+                pp->signals_.async_wait([pp](boost::system::error_code const& ec, int) {
+                    if (!ec)
+                        pp->io_service_.stop();
+                });
+                pp->thread_ = thread_t([pp] {
+                    try {
+                        pp->run();
+                    } catch (...) {
+                        // report the failure to the peer as broken_pipe
+                        pp->pipe_.close();
+                    }
+                });
+            }
+        };
+
+        template<typename Function>
+        struct pipe_model : pipe_concept {
+            Function data_;
+
+            template<typename... Args>
+            pipe_model(Function data, Args&&... args)
+                : pipe_concept(std::forward<Args>(args)...)
+                , data_(std::move(data))
+            { }
+
+            void run() override { data_(pipe_); }
+        };
+#endif // ! defined BOOST_ASIO_WINDOWS
+
         struct concept {
             using ptr = std::shared_ptr<concept>;
 
@@ -180,22 +326,128 @@ namespace detail {
             }
         };
 
-        template<typename Function>
-        struct model : concept {
+        // an actor scheduled as a strand on an actor_pool rather than on
+        // a dedicated thread and io_service, the completions of its socket's
+        // ops run through the strand
+        struct pooled_concept : handler_binding {
+            using ptr = std::shared_ptr<pooled_concept>;
+
+            pair_socket socket_;
+
+            using lock_type = unique_lock_t<mutex_t>;
+            mutable lock_type::mutex_type mutex_;
+            bool stopped_;
+            bool detached_;
+            std::exception_ptr last_error_;
+
+            explicit pooled_concept(boost::asio::io_service & pool)
+                : handler_binding(pool)
+                , socket_(pool)
+                , stopped_(true)
+                , detached_(false)
+            {
+                socket_.bind(get_uri("pipe"));
+            }
+
+            virtual ~pooled_concept() = default;
+
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            pair_socket peer_socket(boost::asio::io_service & peer) {
+#else
+            pair_socket peer_socket(boost::asio::io_context & peer) {
+#endif
+                pair_socket res(peer);
+                auto uri = socket_.endpoint();
+                BOOST_ASSERT_MSG(!uri.empty(), "uri empty");
+                res.connect(uri);
+                return res;
+            }
+
+            bool joinable() const {
+                lock_type l{ mutex_ };
+                return !detached_;
+            }
+
+            // shuts the actor's socket down, so that the actor can start no
+            // further operations, and cancels those outstanding. Never waits
+            // on the pool, so is safe from the pool's threads and once the
+            // pool has stopped
+            void stop() {
+                if (!joinable()) return;
+                boost::system::error_code ec;
+                socket_.shutdown(pair_socket::shutdown_type::receive, ec);
+                socket_.cancel(ec);
+                stopped();
+            }
+
+            void stopped() {
+                lock_type l{ mutex_ };
+                stopped_ = true;
+            }
+
+            bool is_stopped() const {
+                lock_type l{ mutex_ };
+                return stopped_;
+            }
+
+            void detach() {
+                lock_type l{ mutex_ };
+                detached_ = true;
+            }
+
+            void set_last_error(std::exception_ptr last_error) {
+                lock_type l { mutex_ };
+                last_error_ = last_error;
+            }
+
+            std::exception_ptr last_error() const {
+                lock_type l { mutex_ };
+                return last_error_;
+            }
+
+            void failed(std::exception_ptr e) override {
+                set_last_error(e);
+                stopped();
+            }
+
+            virtual void run() = 0;
+
+            static void run(ptr p) {
+                {
+                    lock_type l { p->mutex_ };
+                    p->stopped_ = false;
+                }
+                bind_handlers(p->socket_, p);
+                p->strand_.post([p] {
+                    try {
+                        p->run();
+                    } catch (...) {
+                        p->set_last_error(std::current_exception());
+                        p->stopped();
+                    }
+                });
+            }
+        };
+
+        template<typename Concept, typename Function>
+        struct model : Concept {
             Function data_;
 
-            model(Function data)
-                : data_(std::move(data))
+            template<typename... Args>
+            model(Function data, Args&&... args)
+                : Concept(std::forward<Args>(args)...)
+                , data_(std::move(data))
             { }
 
-            void run() override { data_(socket_); }
+            void run() override { data_(this->socket_); }
         };
 
+        template<typename Concept>
         struct handler {
-            concept::ptr p_;
+            typename Concept::ptr p_;
             bool defer_start_;
 
-            handler(concept::ptr p, bool defer_start)
+            handler(typename Concept::ptr p, bool defer_start)
                 : p_(std::move(p))
                 , defer_start_(defer_start)
             { }
@@ -203,7 +455,7 @@ namespace detail {
             void on_install(boost::asio::io_service&, void*) {
                 if (defer_start_) return;
                 defer_start_ = false;
-                concept::run(p_);
+                Concept::run(p_);
             }
 
             void on_remove() {
@@ -228,7 +480,7 @@ namespace detail {
                     {
                         if (*static_cast<start::value_t const*>(opt.data()) && defer_start_) {
                             defer_start_ = false;
-                            concept::run(p_);
+                            Concept::run(p_);
                         }
                     }
                     break;
@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_CAPTURE_EXT_HPP_
+#define AZMQ_DETAIL_CAPTURE_EXT_HPP_
+
+#include "../error.hpp"
+#include "../message.hpp"
+#include "capture_log.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <zmq.h>
+
+#include <memory>
+
+namespace azmq {
+namespace detail {
+    enum capture_direction : unsigned {
+        capture_received = 1,
+        capture_sent = 2,
+        capture_both = capture_received | capture_sent
+    };
+
+    /** \brief socket extension recording the frames passing through a socket
+     *  to a capture_writer
+     *  \remark Sent frames are recorded once sent, so frames whose send fails,
+     *  would block, is cancelled or times out are not recorded, and a retried
+     *  send is recorded once.
+     */
+    class capture_ext {
+    public:
+        capture_ext(std::shared_ptr<capture_writer> writer, unsigned directions)
+            : writer_(std::move(writer))
+            , directions_(directions)
+        { }
+
+        void on_install(boost::asio::io_service &, void *) { }
+        void on_remove() { }
+
+        template<typename Option>
+        boost::system::error_code set_option(Option const&, boost::system::error_code & ec) {
+            return ec = make_error_code(boost::system::errc::not_supported);
+        }
+
+        template<typename Option>
+        boost::system::error_code get_option(Option &, boost::system::error_code & ec) {
+            return ec = make_error_code(boost::system::errc::not_supported);
+        }
+
+        void on_sent(message const& msg, int flags) {
+            if (directions_ & capture_sent)
+                writer_->write(true, (flags & ZMQ_SNDMORE) != 0,
+                               boost::asio::buffer_cast<void const*>(msg.cbuffer()), msg.size());
+        }
+
+        boost::system::error_code on_receive(message & msg, boost::system::error_code & ec) {
+            if (directions_ & capture_received)
+                writer_->write(false, msg.more(),
+                               boost::asio::buffer_cast<void const*>(msg.cbuffer()), msg.size());
+            return ec;
+        }
+
+    private:
+        std::shared_ptr<capture_writer> writer_;
+        unsigned directions_;
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_CAPTURE_EXT_HPP_
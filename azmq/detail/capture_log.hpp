@@ -0,0 +1,264 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_CAPTURE_LOG_HPP_
+#define AZMQ_DETAIL_CAPTURE_LOG_HPP_
+
+#include "../error.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace azmq {
+namespace detail {
+    struct capture_format {
+        // a file is a file_header followed by records, each a record_header
+        // and the frame padded to a multiple of 8 bytes. A record is only
+        // complete once its flags have the valid bit set, so a reader stops
+        // cleanly at the end of a log whose writer did not close it.
+        struct file_header {
+            uint32_t magic;
+            uint32_t version;
+            int64_t start_time;     // system_clock nanoseconds since the epoch
+        };
+
+        struct record_header {
+            uint64_t time;          // steady_clock nanoseconds since start_time
+            uint32_t size;
+            uint32_t flags;
+        };
+
+        enum : uint32_t {
+            magic_value = 0x4c435a41u,  // "AZCL"
+            version_value = 1,
+            more = 1,               // frame is followed by another part
+            sent = 2,               // frame was sent, otherwise received
+            valid = 1u << 31
+        };
+
+        static size_t padded(size_t n) {
+            return (n + 7) & ~static_cast<size_t>(7);
+        }
+    };
+
+    /** \brief appends frames to a memory mapped log file
+     *  \remark The file is grown geometrically and remapped, so the cost of
+     *  recording a frame is a timestamp and a copy into the mapping. The file
+     *  is truncated to the length of the log when the writer is destroyed.
+     */
+    class capture_writer {
+    public:
+        explicit capture_writer(std::string const& path, size_t reserve = 64 * 1024 * 1024)
+            : start_(std::chrono::steady_clock::now())
+        {
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd_ < 0)
+                throw boost::system::system_error(make_error_code());
+            if (!grow(std::max(reserve, sizeof(capture_format::file_header)))) {
+                auto ec = make_error_code();
+                ::close(fd_);
+                throw boost::system::system_error(ec);
+            }
+            capture_format::file_header h;
+            h.magic = capture_format::magic_value;
+            h.version = capture_format::version_value;
+            h.start_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            std::memcpy(base_, &h, sizeof(h));
+            used_ = sizeof(h);
+        }
+
+        capture_writer(capture_writer const&) = delete;
+        capture_writer & operator=(capture_writer const&) = delete;
+
+        ~capture_writer() {
+            if (base_)
+                ::munmap(base_, mapped_);
+            // should this fail the log is followed by zeroes, which readers
+            // take as its end
+            auto rc = ::ftruncate(fd_, static_cast<off_t>(used_));
+            static_cast<void>(rc);
+            ::close(fd_);
+        }
+
+        // returns false, and counts the frame as dropped, if the log could not
+        // be grown to hold it
+        bool write(bool sent, bool more, void const* data, size_t size) {
+            capture_format::record_header h;
+            h.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_).count();
+            h.size = static_cast<uint32_t>(size);
+            auto need = sizeof(h) + capture_format::padded(size);
+
+            std::lock_guard<std::mutex> l{ mutex_ };
+            if (size > UINT32_MAX || (used_ + need > mapped_ && !grow(std::max(mapped_ * 2, used_ + need)))) {
+                ++dropped_;
+                return false;
+            }
+            auto p = base_ + used_;
+            std::memcpy(p, &h, sizeof(h));
+            std::memcpy(p + sizeof(h), data, size);
+            // mark the record valid only once its contents are in place, so a
+            // log cut short by a crash ends at the last complete record
+            std::atomic_signal_fence(std::memory_order_release);
+            uint32_t flags = capture_format::valid
+                           | (sent ? uint32_t(capture_format::sent) : 0u)
+                           | (more ? uint32_t(capture_format::more) : 0u);
+            std::memcpy(p + offsetof(capture_format::record_header, flags), &flags, sizeof(flags));
+            used_ += need;
+            ++frames_;
+            return true;
+        }
+
+        // schedules the log written so far to be written back to the file
+        void flush() {
+            std::lock_guard<std::mutex> l{ mutex_ };
+            ::msync(base_, used_, MS_ASYNC);
+        }
+
+        uint64_t frames() const {
+            std::lock_guard<std::mutex> l{ mutex_ };
+            return frames_;
+        }
+
+        uint64_t dropped() const {
+            std::lock_guard<std::mutex> l{ mutex_ };
+            return dropped_;
+        }
+
+        // length of the log in bytes
+        size_t size() const {
+            std::lock_guard<std::mutex> l{ mutex_ };
+            return used_;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point const start_;
+        mutable std::mutex mutex_;
+        int fd_ = -1;
+        char * base_ = nullptr;
+        size_t mapped_ = 0;
+        size_t used_ = 0;
+        uint64_t frames_ = 0;
+        uint64_t dropped_ = 0;
+
+        bool grow(size_t size) {
+            auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            size = (size + page - 1) / page * page;
+            if (::ftruncate(fd_, static_cast<off_t>(size)) < 0)
+                return false;
+            auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (p == MAP_FAILED)
+                return false;
+            if (base_)
+                ::munmap(base_, mapped_);
+            base_ = static_cast<char*>(p);
+            mapped_ = size;
+            return true;
+        }
+    };
+
+    /** \brief iterates over the frames of a log written by capture_writer */
+    class capture_reader {
+    public:
+        struct record {
+            std::chrono::nanoseconds time;      // since the start of the capture
+            bool sent;
+            bool more;
+            boost::asio::const_buffer data;     // valid while the reader exists
+        };
+
+        explicit capture_reader(std::string const& path) {
+            fd_ = ::open(path.c_str(), O_RDONLY);
+            if (fd_ < 0)
+                throw boost::system::system_error(make_error_code());
+            struct stat st;
+            if (::fstat(fd_, &st) < 0) {
+                auto ec = make_error_code();
+                ::close(fd_);
+                throw boost::system::system_error(ec);
+            }
+            size_ = static_cast<size_t>(st.st_size);
+            capture_format::file_header h;
+            if (size_ < sizeof(h)) {
+                ::close(fd_);
+                throw boost::system::system_error(make_error_code(boost::system::errc::illegal_byte_sequence));
+            }
+            auto p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+            if (p == MAP_FAILED) {
+                auto ec = make_error_code();
+                ::close(fd_);
+                throw boost::system::system_error(ec);
+            }
+            base_ = static_cast<char const*>(p);
+            std::memcpy(&h, base_, sizeof(h));
+            if (h.magic != capture_format::magic_value || h.version != capture_format::version_value) {
+                ::munmap(const_cast<char*>(base_), size_);
+                ::close(fd_);
+                throw boost::system::system_error(make_error_code(boost::system::errc::illegal_byte_sequence));
+            }
+            start_time_ = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::nanoseconds(h.start_time)));
+            rewind();
+        }
+
+        capture_reader(capture_reader const&) = delete;
+        capture_reader & operator=(capture_reader const&) = delete;
+
+        ~capture_reader() {
+            ::munmap(const_cast<char*>(base_), size_);
+            ::close(fd_);
+        }
+
+        // wall clock time the capture started
+        std::chrono::system_clock::time_point start_time() const { return start_time_; }
+
+        // returns false at the end of the log
+        bool next(record & r) {
+            capture_format::record_header h;
+            if (size_ - pos_ < sizeof(h))
+                return false;
+            std::memcpy(&h, base_ + pos_, sizeof(h));
+            auto len = capture_format::padded(h.size);
+            if (!(h.flags & capture_format::valid) || size_ - pos_ - sizeof(h) < len)
+                return false;
+            r.time = std::chrono::nanoseconds(h.time);
+            r.sent = (h.flags & capture_format::sent) != 0;
+            r.more = (h.flags & capture_format::more) != 0;
+            r.data = boost::asio::buffer(base_ + pos_ + sizeof(h), h.size);
+            pos_ += sizeof(h) + len;
+            return true;
+        }
+
+        void rewind() { pos_ = sizeof(capture_format::file_header); }
+
+    private:
+        int fd_ = -1;
+        char const* base_ = nullptr;
+        size_t size_ = 0;
+        size_t pos_ = 0;
+        std::chrono::system_clock::time_point start_time_;
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_CAPTURE_LOG_HPP_
@@ -0,0 +1,295 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_CODEC_EXT_HPP_
+#define AZMQ_DETAIL_CODEC_EXT_HPP_
+
+#include "../error.hpp"
+#include "../message.hpp"
+#include "../option.hpp"
+#include "lz_codec.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <zmq.h>
+
+#ifdef AZMQ_USE_ZLIB
+#   include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace azmq {
+namespace detail {
+    enum class codec_type : int {
+        none = 0,
+        lz = 1,     // built in LZ77 block codec
+        zlib = 2    // deflate, only if built with AZMQ_USE_ZLIB
+    };
+
+    struct codec_stats {
+        using duration = std::chrono::steady_clock::duration;
+
+        uint64_t frames_encoded = 0;    // frames sent compressed
+        uint64_t frames_skipped = 0;    // frames above the threshold which did not compress
+        uint64_t frames_decoded = 0;    // compressed frames received
+        uint64_t bytes_in = 0;          // size of encoded frames before compression
+        uint64_t bytes_out = 0;         // size of encoded frames after compression
+        duration encode_time = duration::zero();
+        duration decode_time = duration::zero();
+
+        // compressed size as a fraction of the original, for encoded frames
+        double ratio() const {
+            return bytes_in ? static_cast<double>(bytes_out) / bytes_in : 1.0;
+        }
+    };
+
+    /** \brief socket extension compressing frames on send and decompressing
+     *  them on receive
+     *  \remark Compressed frames carry an 8 byte header, a three byte magic
+     *  number, the codec, and the original size as a little endian uint32_t.
+     *  Frames below the threshold, or which do not shrink, are sent unchanged;
+     *  a frame which happens to begin with the magic number is escaped with a
+     *  header naming codec_type::none.
+     *  \remark Only the last (or only) frame of a message is encoded, so that
+     *  a decoded message's more() flag, which cannot be set on a new message,
+     *  is correct.
+     *  \remark Compression goes through a scratch buffer owned by the
+     *  extension and reused for every frame; decompression writes directly into
+     *  the received message.
+     *  \remark The original size in a received header is untrusted, frames
+     *  which claim to decode to more than max_size are rejected with
+     *  protocol_error before anything is allocated.
+     */
+    class codec_ext {
+    public:
+        using codec = opt::integer<static_cast<int>(opt::limits::lib_socket_min) + 5>;
+        using threshold = opt::integer<static_cast<int>(opt::limits::lib_socket_min) + 6>;
+        using counters = opt::base<codec_stats, static_cast<int>(opt::limits::lib_socket_min) + 7>;
+        using max_size = opt::integer<static_cast<int>(opt::limits::lib_socket_min) + 8>;
+
+        enum : size_t {
+            header_size = 8,
+            default_max_size = 64 * 1024 * 1024
+        };
+
+        codec_ext(codec_type type, size_t threshold_size)
+            : type_(type)
+            , threshold_(threshold_size)
+            , max_size_(default_max_size)
+        { }
+
+        static bool is_supported(codec_type type) {
+            switch (type) {
+            case codec_type::none:
+            case codec_type::lz:
+                return true;
+#ifdef AZMQ_USE_ZLIB
+            case codec_type::zlib:
+                return true;
+#endif
+            default:
+                return false;
+            }
+        }
+
+        // a socket's ZMQ_MAXMSGSIZE, if set, also limits decoded frames
+        void on_install(boost::asio::io_service &, void * socket) {
+            int64_t maxmsgsize = -1;
+            size_t len = sizeof(maxmsgsize);
+            if (socket && zmq_getsockopt(socket, ZMQ_MAXMSGSIZE, &maxmsgsize, &len) == 0
+                    && maxmsgsize >= 0)
+                max_size_ = static_cast<size_t>(std::min<int64_t>(maxmsgsize, UINT32_MAX));
+        }
+
+        void on_remove() { }
+
+        template<typename Option>
+        boost::system::error_code set_option(Option const& opt, boost::system::error_code & ec) {
+            switch (opt.name()) {
+            case codec::static_name::value: {
+                auto t = static_cast<codec_type>(*static_cast<int const*>(opt.data()));
+                if (!is_supported(t))
+                    ec = make_error_code(boost::system::errc::protocol_not_supported);
+                else
+                    type_ = t;
+                break;
+            }
+            case threshold::static_name::value:
+                threshold_ = static_cast<size_t>(std::max(0, *static_cast<int const*>(opt.data())));
+                break;
+            case counters::static_name::value:
+                stats_ = codec_stats();
+                break;
+            case max_size::static_name::value: {
+                // zero lifts the limit
+                auto v = *static_cast<int const*>(opt.data());
+                max_size_ = v > 0 ? static_cast<size_t>(v) : UINT32_MAX;
+                break;
+            }
+            default:
+                ec = make_error_code(boost::system::errc::not_supported);
+            }
+            return ec;
+        }
+
+        template<typename Option>
+        boost::system::error_code get_option(Option & opt, boost::system::error_code & ec) {
+            switch (opt.name()) {
+            case codec::static_name::value:
+                *static_cast<int*>(opt.data()) = static_cast<int>(type_);
+                break;
+            case threshold::static_name::value:
+                *static_cast<int*>(opt.data()) = static_cast<int>(threshold_);
+                break;
+            case counters::static_name::value:
+                *static_cast<codec_stats*>(opt.data()) = stats_;
+                break;
+            case max_size::static_name::value:
+                *static_cast<int*>(opt.data()) = static_cast<int>(std::min<size_t>(max_size_, INT_MAX));
+                break;
+            default:
+                ec = make_error_code(boost::system::errc::not_supported);
+            }
+            return ec;
+        }
+
+        boost::system::error_code on_send(message & msg, int flags, boost::system::error_code & ec) {
+            if (flags & ZMQ_SNDMORE)
+                return ec;
+            auto size = msg.size();
+            auto data = boost::asio::buffer_cast<uint8_t const*>(msg.cbuffer());
+            if (type_ != codec_type::none && size >= threshold_ && size <= UINT32_MAX) {
+                auto start = std::chrono::steady_clock::now();
+                auto n = compress(data, size);
+                if (n && n + header_size < size) {
+                    encode_header(type_, size);
+                    msg = message(boost::asio::buffer(scratch_.data(), header_size + n));
+                    ++stats_.frames_encoded;
+                    stats_.bytes_in += size;
+                    stats_.bytes_out += header_size + n;
+                    stats_.encode_time += std::chrono::steady_clock::now() - start;
+                    return ec;
+                }
+                ++stats_.frames_skipped;
+                stats_.encode_time += std::chrono::steady_clock::now() - start;
+            }
+            if (has_magic(data, size) && size <= UINT32_MAX) {
+                scratch_.resize(header_size + size);
+                encode_header(codec_type::none, size);
+                std::memcpy(scratch_.data() + header_size, data, size);
+                msg = message(boost::asio::buffer(scratch_.data(), scratch_.size()));
+            }
+            return ec;
+        }
+
+        boost::system::error_code on_receive(message & msg, boost::system::error_code & ec) {
+            if (msg.more())
+                return ec;
+            auto size = msg.size();
+            auto data = boost::asio::buffer_cast<uint8_t const*>(msg.cbuffer());
+            if (size < header_size || !has_magic(data, size))
+                return ec;
+            auto type = static_cast<codec_type>(data[3]);
+            size_t original = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<size_t>(data[7]) << 24);
+            if (original > max_size_) {
+                ec = make_error_code(boost::system::errc::protocol_error);
+                return ec;
+            }
+            auto start = std::chrono::steady_clock::now();
+            message res(original);
+            auto out = boost::asio::buffer_cast<void*>(res.buffer());
+            auto ok = false;
+            switch (type) {
+            case codec_type::none:
+                ok = original == size - header_size;
+                if (ok)
+                    std::memcpy(out, data + header_size, original);
+                break;
+            case codec_type::lz:
+                ok = lz_codec::decompress(data + header_size, size - header_size, out, original);
+                break;
+#ifdef AZMQ_USE_ZLIB
+            case codec_type::zlib: {
+                uLongf len = original;
+                ok = ::uncompress(static_cast<Bytef*>(out), &len, data + header_size,
+                                  static_cast<uLong>(size - header_size)) == Z_OK && len == original;
+                break;
+            }
+#endif
+            default:
+                ec = make_error_code(boost::system::errc::protocol_not_supported);
+                return ec;
+            }
+            if (!ok) {
+                ec = make_error_code(boost::system::errc::illegal_byte_sequence);
+                return ec;
+            }
+            msg = std::move(res);
+            if (type != codec_type::none) {
+                ++stats_.frames_decoded;
+                stats_.decode_time += std::chrono::steady_clock::now() - start;
+            }
+            return ec;
+        }
+
+    private:
+        codec_type type_;
+        size_t threshold_;
+        size_t max_size_;
+        codec_stats stats_;
+        std::vector<uint8_t> scratch_;
+
+        static bool has_magic(uint8_t const* data, size_t size) {
+            return size >= 3 && data[0] == 0x89 && data[1] == 'A' && data[2] == 'Z';
+        }
+
+        void encode_header(codec_type type, size_t size) {
+            auto p = scratch_.data();
+            p[0] = 0x89;
+            p[1] = 'A';
+            p[2] = 'Z';
+            p[3] = static_cast<uint8_t>(type);
+            for (auto i = 0; i != 4; ++i)
+                p[4 + i] = static_cast<uint8_t>(size >> (8 * i));
+        }
+
+        // compresses into scratch_ after the header, returns the compressed
+        // size or zero if it did not fit
+        size_t compress(uint8_t const* data, size_t size) {
+            switch (type_) {
+            case codec_type::lz: {
+                auto cap = lz_codec::bound(size);
+                scratch_.resize(header_size + cap);
+                return lz_codec::compress(data, size, scratch_.data() + header_size, cap);
+            }
+#ifdef AZMQ_USE_ZLIB
+            case codec_type::zlib: {
+                auto cap = ::compressBound(static_cast<uLong>(size));
+                scratch_.resize(header_size + cap);
+                uLongf len = cap;
+                if (::compress2(scratch_.data() + header_size, &len, data,
+                                static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK)
+                    return 0;
+                return len;
+            }
+#endif
+            default:
+                return 0;
+            }
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_CODEC_EXT_HPP_
@@ -19,7 +19,18 @@
 
 #include <zmq.h>
 
+#if defined(__linux__)
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
 #include <memory>
+#include <map>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
 
 namespace azmq {
 namespace detail {
@@ -28,13 +39,68 @@ namespace detail {
         using lock_type = boost::lock_guard<boost::mutex>;
 
         using io_threads = opt::integer<ZMQ_IO_THREADS>;
-        using max_sockets = opt::integer<ZMQ_MAXMSGSIZE>;
+        using max_sockets = opt::integer<ZMQ_MAX_SOCKETS>;
         using ipv6 = opt::boolean<ZMQ_IPV6>;
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+        using thread_affinity_cpu_add = opt::integer<ZMQ_THREAD_AFFINITY_CPU_ADD>;
+        using thread_affinity_cpu_remove = opt::integer<ZMQ_THREAD_AFFINITY_CPU_REMOVE>;
+#endif
+#ifdef ZMQ_THREAD_SCHED_POLICY
+        using thread_sched_policy = opt::integer<ZMQ_THREAD_SCHED_POLICY>;
+        using thread_priority = opt::integer<ZMQ_THREAD_PRIORITY>;
+#endif
+#ifdef ZMQ_THREAD_NAME_PREFIX
+        using thread_name_prefix = opt::integer<ZMQ_THREAD_NAME_PREFIX>;
+#endif
+
+        /** \brief how a socket_service obtains its zeromq context */
+        enum class context_policy {
+            global,         // one context shared by the whole process (default)
+            per_io_service, // a private context per io_service
+            per_numa_node   // one context per NUMA node, io threads pinned to that node
+        };
 
         static context_type ctx_new() {
             return context_type(zmq_ctx_new(), zmq_ctx_term);
         }
 
+        // NUMA node of the CPU the calling thread is running on, 0 if unknown
+        static int current_numa_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+            unsigned cpu = 0;
+            unsigned node = 0;
+            if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+                return static_cast<int>(node);
+#endif
+            return 0;
+        }
+
+        // CPUs belonging to a NUMA node, empty if unknown
+        static std::vector<int> numa_node_cpus(int node) {
+            std::vector<int> res;
+#if defined(__linux__)
+            std::ostringstream path;
+            path << "/sys/devices/system/node/node" << node << "/cpulist";
+            std::ifstream f(path.str());
+            std::string range;
+            // cpulist is of the form "0-3,8-11"
+            while (std::getline(f, range, ',')) {
+                int lo = 0;
+                int hi = 0;
+                char dash = 0;
+                std::istringstream r(range);
+                if (!(r >> lo))
+                    continue;
+                hi = lo;
+                if (r >> dash >> hi && dash != '-')
+                    continue;
+                for (auto cpu = lo; cpu <= hi; ++cpu)
+                    res.push_back(cpu);
+            }
+#endif
+            return res;
+        }
+
         static context_type get_context(bool create_new = false) {
             static boost::mutex mtx;
             static std::weak_ptr<void> ctx;
@@ -47,13 +113,74 @@ namespace detail {
             return p;
         }
 
+        static context_type get_numa_context(int node, int io_threads,
+                                             boost::system::error_code & ec) {
+            static boost::mutex mtx;
+            static std::map<int, std::weak_ptr<void>> ctxs;
+
+            if (node < 0) node = current_numa_node();
+
+            lock_type l{ mtx };
+            auto & ctx = ctxs[node];
+            auto p = ctx.lock();
+            if (p) return p;
+
+            p = ctx_new();
+            if (!configure(p, io_threads, numa_node_cpus(node), ec))
+                return context_type();
+            ctx = p;
+            return p;
+        }
+
+        // a new context whose io threads are restricted to cpus
+        static context_type get_pinned_context(std::vector<int> const& cpus, int io_threads,
+                                               boost::system::error_code & ec) {
+            auto p = ctx_new();
+            if (!configure(p, io_threads, cpus, ec))
+                return context_type();
+            return p;
+        }
+
+        // socket affinity bitmask selecting a single libzmq io thread
+        static uint64_t io_thread_mask(unsigned io_thread) {
+            BOOST_ASSERT_MSG(io_thread < 64, "io thread index out of range for ZMQ_AFFINITY");
+            return uint64_t(1) << io_thread;
+        }
+
+        /** \brief obtain a context according to policy
+         *  \param io_threads number of libzmq io threads for a newly created
+         *  context, 0 leaves the libzmq default
+         *  \param numa_node node for per_numa_node, -1 selects the node of the
+         *  calling thread
+         */
+        static context_type get_context(context_policy policy, int io_threads, int numa_node,
+                                        boost::system::error_code & ec) {
+            switch (policy) {
+            case context_policy::per_io_service:
+                {
+                    auto p = ctx_new();
+                    if (!configure(p, io_threads, std::vector<int>(), ec))
+                        return context_type();
+                    return p;
+                }
+            case context_policy::per_numa_node:
+                return get_numa_context(numa_node, io_threads, ec);
+            default:
+                break;
+            }
+            auto p = get_context();
+            if (io_threads > 0 && zmq_ctx_set(p.get(), ZMQ_IO_THREADS, io_threads) < 0)
+                ec = make_error_code();
+            return p;
+        }
+
         template<typename Option>
         static boost::system::error_code set_option(context_type & ctx,
                                                     Option const& option,
                                                     boost::system::error_code & ec) {
             BOOST_ASSERT_MSG(ctx, "context must not be null");
             auto rc = zmq_ctx_set(ctx.get(), option.name(), option.value());
-            if (!rc)
+            if (rc < 0)
                 ec = make_error_code();
             return ec;
         }
@@ -69,6 +196,28 @@ namespace detail {
             option.set(rc);
             return ec;
         }
+
+    private:
+        static bool configure(context_type & ctx, int io_threads, std::vector<int> const& cpus,
+                              boost::system::error_code & ec) {
+            if (!ctx) {
+                ec = make_error_code();
+                return false;
+            }
+            if (io_threads > 0 && zmq_ctx_set(ctx.get(), ZMQ_IO_THREADS, io_threads) < 0) {
+                ec = make_error_code();
+                return false;
+            }
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+            for (auto cpu : cpus) {
+                if (zmq_ctx_set(ctx.get(), ZMQ_THREAD_AFFINITY_CPU_ADD, cpu) < 0) {
+                    ec = make_error_code();
+                    return false;
+                }
+            }
+#endif
+            return true;
+        }
     };
 } // namespace detail
 } // namespace azmq
@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_EVENT_FD_HPP_
+#define AZMQ_DETAIL_EVENT_FD_HPP_
+
+#include "../error.hpp"
+
+#include <boost/asio/detail/config.hpp>
+#include <boost/system/error_code.hpp>
+
+#if defined BOOST_ASIO_WINDOWS
+#   error "azmq::detail::event_fd requires a POSIX platform"
+#endif
+
+#if defined(__linux__)
+#   include <sys/eventfd.h>
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+
+namespace azmq {
+namespace detail {
+    /** \brief non-blocking wakeup descriptor, an eventfd on Linux and a
+     *  self-pipe elsewhere
+     *  \remark notify() makes the descriptor readable until clear() is called,
+     *  multiple notifications collapse into one.
+     */
+    class event_fd {
+    public:
+        using native_handle_type = int;
+
+        explicit event_fd(boost::system::error_code & ec) {
+#if defined(__linux__)
+            fds_[0] = fds_[1] = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (fds_[0] < 0)
+                ec = make_error_code();
+#else
+            if (::pipe(fds_) < 0) {
+                fds_[0] = fds_[1] = -1;
+                ec = make_error_code();
+                return;
+            }
+            for (auto fd : fds_) {
+                ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+#endif
+        }
+
+        ~event_fd() {
+            if (fds_[0] >= 0)
+                ::close(fds_[0]);
+            if (fds_[1] != fds_[0] && fds_[1] >= 0)
+                ::close(fds_[1]);
+        }
+
+        event_fd(event_fd const&) = delete;
+        event_fd & operator=(event_fd const&) = delete;
+
+        // the readable end, suitable for registering with a reactor
+        native_handle_type native_handle() const { return fds_[0]; }
+
+        void notify() {
+#if defined(__linux__)
+            uint64_t v = 1;
+#else
+            uint8_t v = 1;
+#endif
+            ssize_t rc;
+            do {
+                rc = ::write(fds_[1], &v, sizeof(v));
+            } while (rc < 0 && errno == EINTR);
+            // EAGAIN means the descriptor is already signalled
+        }
+
+        void clear() {
+            uint64_t v;
+            ssize_t rc;
+            do {
+                rc = ::read(fds_[0], &v, sizeof(v));
+            } while (rc > 0 || (rc < 0 && errno == EINTR));
+        }
+
+    private:
+        native_handle_type fds_[2];
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_EVENT_FD_HPP_
@@ -0,0 +1,176 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_LAST_VALUE_TABLE_HPP_
+#define AZMQ_DETAIL_LAST_VALUE_TABLE_HPP_
+
+#include <boost/asio/error.hpp>
+#include <boost/assert.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace azmq {
+namespace detail {
+    /** \brief fixed capacity table of the latest value per key, with a single
+     *  writer and any number of concurrent readers
+     *  \remark Each entry is guarded by a seqlock; readers never block or
+     *  write shared state, they copy the value out and retry only if an update
+     *  raced with the copy. Keys are inserted into an open addressed index of
+     *  atomic pointers and are never removed, so lookups need no lock either.
+     *  \remark The value is held as relaxed atomic words, so the racing copy is
+     *  well defined; values longer than the configured maximum are rejected.
+     */
+    class last_value_table {
+    public:
+        last_value_table(size_t max_keys, size_t max_value_size)
+            : max_keys_(max_keys)
+            , max_words_((max_value_size + sizeof(word_type) - 1) / sizeof(word_type))
+            , mask_(round_up(max_keys * 2) - 1)
+            , index_(new std::atomic<entry*>[mask_ + 1])
+            , entries_(new entry[max_keys])
+        {
+            for (size_t i = 0; i <= mask_; ++i)
+                index_[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        last_value_table(last_value_table const&) = delete;
+        last_value_table & operator=(last_value_table const&) = delete;
+
+        size_t max_keys() const { return max_keys_; }
+        size_t max_value_size() const { return max_words_ * sizeof(word_type); }
+        size_t size() const { return used_.load(std::memory_order_acquire); }
+
+        // writer only, returns false if the value is too large or the table is
+        // full
+        bool update(std::string_view key, void const* data, size_t size) {
+            if (size > max_value_size())
+                return false;
+            auto e = find_or_insert(key);
+            if (!e)
+                return false;
+            auto seq = e->seq_.load(std::memory_order_relaxed);
+            e->seq_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            auto p = static_cast<char const*>(data);
+            for (size_t i = 0; i * sizeof(word_type) < size; ++i) {
+                word_type w = 0;
+                std::memcpy(&w, p + i * sizeof(word_type),
+                            std::min(sizeof(word_type), size - i * sizeof(word_type)));
+                e->value_[i].store(w, std::memory_order_relaxed);
+            }
+            e->size_.store(size, std::memory_order_relaxed);
+            e->seq_.store(seq + 2, std::memory_order_release);
+            return true;
+        }
+
+        // any thread, returns the size of the value, sets ec to not_found if
+        // the key has never been seen or to no_buffer_space if out is too small
+        size_t read(std::string_view key, void * out, size_t out_size,
+                    uint64_t & version, boost::system::error_code & ec) const {
+            auto e = find(key);
+            if (!e) {
+                ec = boost::asio::error::not_found;
+                return 0;
+            }
+            auto dst = static_cast<char*>(out);
+            for (;;) {
+                auto seq = e->seq_.load(std::memory_order_acquire);
+                if (seq & 1)
+                    continue;
+                auto size = e->size_.load(std::memory_order_relaxed);
+                auto n = std::min(size, out_size);
+                for (size_t i = 0; i * sizeof(word_type) < n; ++i) {
+                    auto w = e->value_[i].load(std::memory_order_relaxed);
+                    std::memcpy(dst + i * sizeof(word_type), &w,
+                                std::min(sizeof(word_type), n - i * sizeof(word_type)));
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (e->seq_.load(std::memory_order_relaxed) != seq)
+                    continue;
+                version = seq / 2;
+                if (size > out_size)
+                    ec = make_error_code(boost::system::errc::no_buffer_space);
+                return size;
+            }
+        }
+
+        // any thread, returns the number of updates applied to the key, zero
+        // if it has never been seen
+        uint64_t version(std::string_view key) const {
+            auto e = find(key);
+            return e ? e->seq_.load(std::memory_order_acquire) / 2 : 0;
+        }
+
+    private:
+        using word_type = uint64_t;
+
+        struct entry {
+            std::string key_;
+            std::unique_ptr<std::atomic<word_type>[]> value_;
+            std::atomic<size_t> size_{ 0 };
+            std::atomic<uint64_t> seq_{ 0 };
+        };
+
+        static size_t round_up(size_t n) {
+            BOOST_ASSERT_MSG(n, "capacity must be non-zero");
+            size_t res = 1;
+            while (res < n) res <<= 1;
+            return res;
+        }
+
+        static size_t hash(std::string_view key) {
+            return std::hash<std::string_view>()(key);
+        }
+
+        entry * find(std::string_view key) const {
+            for (auto i = hash(key);; ++i) {
+                auto e = index_[i & mask_].load(std::memory_order_acquire);
+                if (!e || e->key_ == key)
+                    return e;
+            }
+        }
+
+        entry * find_or_insert(std::string_view key) {
+            auto i = hash(key);
+            for (;; ++i) {
+                auto e = index_[i & mask_].load(std::memory_order_relaxed);
+                if (!e)
+                    break;
+                if (e->key_ == key)
+                    return e;
+            }
+            auto used = used_.load(std::memory_order_relaxed);
+            if (used == max_keys_)
+                return nullptr;
+            // the entry is fully initialized before it is published
+            auto e = &entries_[used];
+            e->key_.assign(key.data(), key.size());
+            e->value_.reset(new std::atomic<word_type>[max_words_]);
+            index_[i & mask_].store(e, std::memory_order_release);
+            used_.store(used + 1, std::memory_order_release);
+            return e;
+        }
+
+        size_t const max_keys_;
+        size_t const max_words_;
+        size_t const mask_;
+        std::unique_ptr<std::atomic<entry*>[]> const index_;
+        std::unique_ptr<entry[]> const entries_;
+        std::atomic<size_t> used_{ 0 };
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_LAST_VALUE_TABLE_HPP_
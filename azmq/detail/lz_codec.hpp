@@ -0,0 +1,175 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_LZ_CODEC_HPP_
+#define AZMQ_DETAIL_LZ_CODEC_HPP_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace azmq {
+namespace detail {
+    /** \brief minimal single pass LZ77 block codec
+     *  \remark The block format follows LZ4: a sequence of (token, literal
+     *  length extension, literals, 16 bit little endian offset, match length
+     *  extension) where the token holds the literal length and the match
+     *  length less four in its high and low nibbles, and a nibble of 15 is
+     *  extended by bytes summed until one is not 255. The final sequence has
+     *  literals only. Matches are found through a single hash table probe per
+     *  position, favouring speed over ratio.
+     */
+    struct lz_codec {
+        enum { min_match = 4, max_offset = 65535, hash_bits = 12 };
+
+        // worst case size of an incompressible input
+        static size_t bound(size_t size) {
+            return size + size / 255 + 16;
+        }
+
+        // returns the compressed size, zero if it would exceed capacity
+        static size_t compress(void const* src, size_t size, void * dst, size_t capacity) {
+            auto in = static_cast<uint8_t const*>(src);
+            auto out = static_cast<uint8_t*>(dst);
+            auto op = out;
+            auto oend = out + capacity;
+            std::array<uint32_t, 1 << hash_bits> table = { };
+
+            size_t ip = 0;
+            size_t anchor = 0;
+            if (size > min_match) {
+                auto limit = size - min_match;
+                while (ip < limit) {
+                    auto seq = read32(in + ip);
+                    auto & slot = table[hash(seq)];
+                    size_t ref = slot;  // position + 1, zero if empty
+                    slot = static_cast<uint32_t>(ip + 1);
+                    if (!ref || ip + 1 - ref > max_offset || read32(in + ref - 1) != seq) {
+                        // step faster through data which does not match
+                        ip += 1 + ((ip - anchor) >> 6);
+                        continue;
+                    }
+                    --ref;
+                    size_t len = min_match;
+                    while (ip + len < size && in[ref + len] == in[ip + len])
+                        ++len;
+                    op = emit(op, oend, in + anchor, ip - anchor, ip - ref, len);
+                    if (!op)
+                        return 0;
+                    ip += len;
+                    anchor = ip;
+                }
+            }
+            op = emit(op, oend, in + anchor, size - anchor, 0, 0);
+            return op ? static_cast<size_t>(op - out) : 0;
+        }
+
+        // returns false if src is not a valid block decompressing to exactly
+        // size bytes
+        static bool decompress(void const* src, size_t src_size, void * dst, size_t size) {
+            auto in = static_cast<uint8_t const*>(src);
+            auto iend = in + src_size;
+            auto out = static_cast<uint8_t*>(dst);
+            auto op = out;
+            auto oend = out + size;
+            while (in < iend) {
+                auto token = *in++;
+                size_t lit = token >> 4;
+                if (lit == 15 && !extend(in, iend, lit))
+                    return false;
+                if (static_cast<size_t>(iend - in) < lit || static_cast<size_t>(oend - op) < lit)
+                    return false;
+                std::memcpy(op, in, lit);
+                in += lit;
+                op += lit;
+                if (in == iend)
+                    break;
+                if (iend - in < 2)
+                    return false;
+                size_t offset = in[0] | (in[1] << 8);
+                in += 2;
+                size_t len = token & 15;
+                if (len == 15 && !extend(in, iend, len))
+                    return false;
+                len += min_match;
+                if (!offset || offset > static_cast<size_t>(op - out) || static_cast<size_t>(oend - op) < len)
+                    return false;
+                // matches may overlap their own output
+                auto ref = op - offset;
+                for (size_t i = 0; i != len; ++i)
+                    op[i] = ref[i];
+                op += len;
+            }
+            return op == oend;
+        }
+
+    private:
+        static uint32_t read32(uint8_t const* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static size_t hash(uint32_t v) {
+            return (v * 2654435761u) >> (32 - hash_bits);
+        }
+
+        static bool extend(uint8_t const*& in, uint8_t const* iend, size_t & len) {
+            uint8_t b;
+            do {
+                if (in == iend)
+                    return false;
+                b = *in++;
+                len += b;
+            } while (b == 255);
+            return true;
+        }
+
+        static uint8_t * put_length(uint8_t * op, uint8_t const* oend, size_t len) {
+            for (; len >= 255; len -= 255) {
+                if (op == oend)
+                    return nullptr;
+                *op++ = 255;
+            }
+            if (op == oend)
+                return nullptr;
+            *op++ = static_cast<uint8_t>(len);
+            return op;
+        }
+
+        // a sequence with a match length of zero carries literals only
+        static uint8_t * emit(uint8_t * op, uint8_t const* oend,
+                              uint8_t const* lit, size_t lit_len,
+                              size_t offset, size_t match_len) {
+            if (op == oend)
+                return nullptr;
+            auto token = op++;
+            *token = static_cast<uint8_t>((lit_len < 15 ? lit_len : 15) << 4);
+            if (lit_len >= 15 && !(op = put_length(op, oend, lit_len - 15)))
+                return nullptr;
+            if (static_cast<size_t>(oend - op) < lit_len)
+                return nullptr;
+            std::memcpy(op, lit, lit_len);
+            op += lit_len;
+            if (!match_len)
+                return op;
+            if (oend - op < 2)
+                return nullptr;
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            auto m = match_len - min_match;
+            *token |= static_cast<uint8_t>(m < 15 ? m : 15);
+            if (m >= 15 && !(op = put_length(op, oend, m - 15)))
+                return nullptr;
+            return op;
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_LZ_CODEC_HPP_
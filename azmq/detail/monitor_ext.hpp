@@ -0,0 +1,240 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_MONITOR_EXT_HPP_
+#define AZMQ_DETAIL_MONITOR_EXT_HPP_
+
+#include "../error.hpp"
+#include "../socket.hpp"
+#include "../option.hpp"
+#include "config/mutex.hpp"
+#include "config/unique_lock.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/container/flat_map.hpp>
+
+#include <zmq.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace azmq {
+namespace detail {
+    /** \brief decoded libzmq socket monitor event */
+    struct monitor_event {
+        uint16_t id = 0;        // ZMQ_EVENT_* value
+        int32_t value = 0;      // fd, errno or interval, depending on id
+        std::string endpoint;
+    };
+
+    /** \brief connection statistics for a single endpoint */
+    struct endpoint_stats {
+        using clock_type = std::chrono::steady_clock;
+        using duration = clock_type::duration;
+
+        uint64_t connects = 0;              // ZMQ_EVENT_CONNECTED
+        uint64_t connect_delays = 0;        // ZMQ_EVENT_CONNECT_DELAYED
+        uint64_t reconnects = 0;            // ZMQ_EVENT_CONNECT_RETRIED
+        uint64_t accepts = 0;               // ZMQ_EVENT_ACCEPTED
+        uint64_t accept_failures = 0;       // ZMQ_EVENT_ACCEPT_FAILED
+        uint64_t disconnects = 0;           // ZMQ_EVENT_DISCONNECTED
+        uint64_t handshakes = 0;            // ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+        uint64_t handshake_failures = 0;    // ZMQ_EVENT_HANDSHAKE_FAILED_*
+        uint64_t events = 0;                // all events for this endpoint
+
+        // time from the first ZMQ_EVENT_CONNECT_DELAYED/RETRIED to
+        // ZMQ_EVENT_CONNECTED, zero if the connect completed immediately
+        duration last_connect_latency = duration::zero();
+        duration max_connect_latency = duration::zero();
+
+        // time from ZMQ_EVENT_CONNECTED/ACCEPTED to the end of the ZMTP
+        // handshake
+        duration last_handshake_latency = duration::zero();
+        duration max_handshake_latency = duration::zero();
+
+        clock_type::time_point connect_started;
+        clock_type::time_point handshake_started;
+        clock_type::time_point last_event;
+    };
+
+    using endpoint_stats_map = boost::container::flat_map<std::string, endpoint_stats>;
+
+    /** \brief socket extension which consumes a socket's monitor stream,
+     *  decoding each event and accumulating per-endpoint statistics
+     */
+    class monitor_ext {
+    public:
+        using stats = opt::base<endpoint_stats_map, static_cast<int>(opt::limits::lib_socket_min) + 1>;
+        using handler_type = std::function<void(boost::system::error_code const&, monitor_event const&)>;
+
+        monitor_ext(socket monitor, handler_type handler)
+            : state_(std::make_shared<state>(std::move(monitor), std::move(handler)))
+        { }
+
+        void on_install(boost::asio::io_service &, void * socket) {
+            socket_ = socket;
+            state::start(state_);
+        }
+
+        void on_remove() {
+            if (!state_)
+                return;
+            if (socket_)
+                zmq_socket_monitor(socket_, nullptr, 0);
+            boost::system::error_code ec;
+            state_->monitor_.cancel(ec);
+            state_.reset();
+        }
+
+        template<typename Option>
+        boost::system::error_code set_option(Option const&, boost::system::error_code & ec) {
+            ec = make_error_code(boost::system::errc::not_supported);
+            return ec;
+        }
+
+        template<typename Option>
+        boost::system::error_code get_option(Option & opt, boost::system::error_code & ec) {
+            if (opt.name() != stats::static_name::value) {
+                ec = make_error_code(boost::system::errc::not_supported);
+                return ec;
+            }
+            auto v = static_cast<endpoint_stats_map*>(opt.data());
+            unique_lock_t<mutex_t> l{ state_->mutex_ };
+            *v = state_->stats_;
+            return ec;
+        }
+
+    private:
+        struct state {
+            using ptr = std::shared_ptr<state>;
+            using weak_ptr = std::weak_ptr<state>;
+
+            socket monitor_;
+            handler_type handler_;
+            std::array<uint8_t, 6> header_;
+            std::array<char, 256> addr_;
+            monitor_event event_;
+            mutex_t mutex_;
+            endpoint_stats_map stats_;
+
+            state(socket monitor, handler_type handler)
+                : monitor_(std::move(monitor))
+                , handler_(std::move(handler))
+            { }
+
+            static void start(ptr const& p) {
+                std::array<boost::asio::mutable_buffer, 2> bufs = {{
+                    boost::asio::buffer(p->header_),
+                    boost::asio::buffer(p->addr_)
+                }};
+                weak_ptr w = p;
+                p->monitor_.async_receive(bufs, [w](boost::system::error_code const& ec, size_t bytes_transferred) {
+                    auto p = w.lock();
+                    if (!p)
+                        return;
+                    if (ec) {
+                        if (ec != boost::asio::error::operation_aborted && p->handler_)
+                            p->handler_(ec, p->event_);
+                        return;
+                    }
+                    if (!p->decode(bytes_transferred))
+                        return;
+                    p->record();
+                    if (p->handler_)
+                        p->handler_(ec, p->event_);
+#ifdef ZMQ_EVENT_MONITOR_STOPPED
+                    if (p->event_.id == ZMQ_EVENT_MONITOR_STOPPED)
+                        return;
+#endif
+                    start(p);
+                });
+            }
+
+            bool decode(size_t bytes_transferred) {
+                if (bytes_transferred < header_.size())
+                    return false;
+                // v1 event frame: native endian uint16_t id, uint32_t value
+                std::memcpy(&event_.id, header_.data(), sizeof(event_.id));
+                std::memcpy(&event_.value, header_.data() + sizeof(event_.id), sizeof(event_.value));
+                auto len = std::min(bytes_transferred - header_.size(), addr_.size());
+                // assign reuses the string's capacity once it has grown
+                event_.endpoint.assign(addr_.data(), len);
+                return true;
+            }
+
+            void record() {
+                auto now = endpoint_stats::clock_type::now();
+                unique_lock_t<mutex_t> l{ mutex_ };
+                auto & s = stats_[event_.endpoint];
+                ++s.events;
+                s.last_event = now;
+                switch (event_.id) {
+                case ZMQ_EVENT_CONNECT_DELAYED:
+                    ++s.connect_delays;
+                    if (s.connect_started == endpoint_stats::clock_type::time_point())
+                        s.connect_started = now;
+                    break;
+                case ZMQ_EVENT_CONNECT_RETRIED:
+                    ++s.reconnects;
+                    if (s.connect_started == endpoint_stats::clock_type::time_point())
+                        s.connect_started = now;
+                    break;
+                case ZMQ_EVENT_CONNECTED:
+                    ++s.connects;
+                    if (s.connect_started != endpoint_stats::clock_type::time_point()) {
+                        s.last_connect_latency = now - s.connect_started;
+                        s.max_connect_latency = std::max(s.max_connect_latency, s.last_connect_latency);
+                        s.connect_started = endpoint_stats::clock_type::time_point();
+                    }
+                    s.handshake_started = now;
+                    break;
+                case ZMQ_EVENT_ACCEPTED:
+                    ++s.accepts;
+                    s.handshake_started = now;
+                    break;
+                case ZMQ_EVENT_ACCEPT_FAILED:
+                    ++s.accept_failures;
+                    break;
+                case ZMQ_EVENT_DISCONNECTED:
+                    ++s.disconnects;
+                    break;
+#ifdef ZMQ_EVENT_HANDSHAKE_SUCCEEDED
+                case ZMQ_EVENT_HANDSHAKE_SUCCEEDED:
+                    ++s.handshakes;
+                    if (s.handshake_started != endpoint_stats::clock_type::time_point()) {
+                        s.last_handshake_latency = now - s.handshake_started;
+                        s.max_handshake_latency = std::max(s.max_handshake_latency, s.last_handshake_latency);
+                        s.handshake_started = endpoint_stats::clock_type::time_point();
+                    }
+                    break;
+                case ZMQ_EVENT_HANDSHAKE_FAILED_NO_DETAIL:
+                case ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL:
+                case ZMQ_EVENT_HANDSHAKE_FAILED_AUTH:
+                    ++s.handshake_failures;
+                    s.handshake_started = endpoint_stats::clock_type::time_point();
+                    break;
+#endif
+                default:
+                    break;
+                }
+            }
+        };
+
+        state::ptr state_;
+        void * socket_ = nullptr;
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_MONITOR_EXT_HPP_
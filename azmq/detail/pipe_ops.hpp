@@ -0,0 +1,470 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_PIPE_OPS_HPP_
+#define AZMQ_DETAIL_PIPE_OPS_HPP_
+
+#include "../error.hpp"
+#include "../message.hpp"
+#include "socket_ops.hpp"
+#include "spsc_queue.hpp"
+#include "event_fd.hpp"
+#include "config/mutex.hpp"
+#include "config/unique_lock.hpp"
+#include "config/condition_variable.hpp"
+
+#include <boost/version.hpp>
+#include <boost/assert.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/intrusive/list.hpp>
+#include <boost/system/system_error.hpp>
+
+#if BOOST_VERSION < 10700
+#   define AZMQ_DETAIL_USE_IO_SERVICE 1
+#else
+#   include <boost/asio/post.hpp>
+#endif
+
+#include <zmq.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace azmq {
+namespace detail {
+    // one direction of an in-process pipe
+    struct pipe_channel {
+        using lock_type = unique_lock_t<mutex_t>;
+
+        spsc_queue<message> queue_;
+        // the eventfds wake the owning ends' reactors, blocking callers wait
+        // on the condition variables instead so that neither can consume a
+        // wakeup meant for the other
+        event_fd readable_;
+        event_fd writable_;
+        std::atomic<bool> consumer_waiting_;
+        std::atomic<bool> producer_waiting_;
+        std::atomic<bool> closed_;
+        mutex_t sync_mutex_;
+        condition_variable_t sync_readable_;
+        condition_variable_t sync_writable_;
+        std::atomic<unsigned> sync_consumers_;
+        std::atomic<unsigned> sync_producers_;
+
+        pipe_channel(size_t capacity, boost::system::error_code & ec)
+            : queue_(capacity)
+            , readable_(ec)
+            , writable_(ec)
+            , consumer_waiting_(false)
+            , producer_waiting_(false)
+            , closed_(false)
+            , sync_consumers_(0)
+            , sync_producers_(0)
+        { }
+
+        // msg is left untouched if the queue is full
+        bool push(message & msg) {
+            if (!queue_.try_push(std::move(msg)))
+                return false;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (consumer_waiting_.load(std::memory_order_relaxed)
+                    && consumer_waiting_.exchange(false))
+                readable_.notify();
+            if (sync_consumers_.load(std::memory_order_relaxed))
+                notify_sync(sync_readable_);
+            return true;
+        }
+
+        bool pop(message & msg) {
+            if (!queue_.try_pop(msg))
+                return false;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (producer_waiting_.load(std::memory_order_relaxed)
+                    && producer_waiting_.exchange(false))
+                writable_.notify();
+            if (sync_producers_.load(std::memory_order_relaxed))
+                notify_sync(sync_writable_);
+            return true;
+        }
+
+        // announce that the consumer is about to block, returns true if it
+        // should not because there is something to read
+        bool wait_readable() {
+            consumer_waiting_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!queue_.empty() || closed_.load()) {
+                consumer_waiting_.store(false);
+                return true;
+            }
+            return false;
+        }
+
+        bool wait_writable() {
+            producer_waiting_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!queue_.full() || closed_.load()) {
+                producer_waiting_.store(false);
+                return true;
+            }
+            return false;
+        }
+
+        // block the calling thread until there is something to read
+        void block_until_readable() {
+            lock_type l{ sync_mutex_ };
+            sync_consumers_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            sync_readable_.wait(l, [this] { return !queue_.empty() || closed_.load(); });
+            sync_consumers_.fetch_sub(1);
+        }
+
+        // block the calling thread until there is room to write
+        void block_until_writable() {
+            lock_type l{ sync_mutex_ };
+            sync_producers_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            sync_writable_.wait(l, [this] { return !queue_.full() || closed_.load(); });
+            sync_producers_.fetch_sub(1);
+        }
+
+        void close() {
+            closed_.store(true);
+            readable_.notify();
+            writable_.notify();
+            notify_sync(sync_readable_);
+            notify_sync(sync_writable_);
+        }
+
+    private:
+        // taking sync_mutex_ orders the notification after a blocking
+        // caller's check of the queue
+        void notify_sync(condition_variable_t & cv) {
+            { lock_type l{ sync_mutex_ }; }
+            cv.notify_all();
+        }
+    };
+
+    class pipe_op {
+    public:
+        boost::intrusive::list_member_hook<> member_hook_;
+        boost::system::error_code ec_;
+        size_t bytes_transferred_;
+
+        bool do_perform(pipe_channel & ch) { return perform_func_(this, ch); }
+        static void do_complete(pipe_op * op) { op->complete_func_(op); }
+
+    protected:
+        typedef bool (*perform_func_type)(pipe_op*, pipe_channel &);
+        typedef void (*complete_func_type)(pipe_op*);
+
+        perform_func_type perform_func_;
+        complete_func_type complete_func_;
+
+        pipe_op(perform_func_type perform_func,
+                complete_func_type complete_func)
+            : bytes_transferred_(0)
+            , perform_func_(perform_func)
+            , complete_func_(complete_func)
+        { }
+    };
+
+    struct pipe_ops {
+        using flags_type = message::flags_type;
+
+        static boost::system::error_code broken_pipe() {
+            return boost::asio::error::broken_pipe;
+        }
+
+        // false if the operation would block
+        static bool send(message & msg, pipe_channel & ch,
+                         size_t & bytes_transferred,
+                         boost::system::error_code & ec) {
+            if (ch.closed_.load()) {
+                ec = broken_pipe();
+                return true;
+            }
+            auto sz = msg.size();
+            if (!ch.push(msg))
+                return false;
+            bytes_transferred = sz;
+            return true;
+        }
+
+        static bool receive(message & msg, pipe_channel & ch,
+                            size_t & bytes_transferred,
+                            boost::system::error_code & ec) {
+            // closed must be sampled before the queue so that a message pushed
+            // just before the producer closed is not missed
+            auto closed = ch.closed_.load();
+            if (ch.pop(msg)) {
+                bytes_transferred = msg.size();
+                return true;
+            }
+            if (closed) {
+                ec = broken_pipe();
+                return true;
+            }
+            return false;
+        }
+    };
+
+    class pipe_send_op_base : public pipe_op {
+    public:
+        pipe_send_op_base(message msg, complete_func_type complete_func)
+            : pipe_op(&pipe_send_op_base::do_perform, complete_func)
+            , msg_(std::move(msg))
+        { }
+
+        static bool do_perform(pipe_op* base, pipe_channel & ch) {
+            auto o = static_cast<pipe_send_op_base*>(base);
+            return pipe_ops::send(o->msg_, ch, o->bytes_transferred_, o->ec_);
+        }
+
+    private:
+        message msg_;
+    };
+
+    template<typename Handler>
+    class pipe_send_op : public pipe_send_op_base {
+    public:
+        pipe_send_op(message msg, Handler handler)
+            : pipe_send_op_base(std::move(msg), &pipe_send_op::do_complete)
+            , handler_(std::move(handler))
+        { }
+
+        static void do_complete(pipe_op* base) {
+            auto o = static_cast<pipe_send_op*>(base);
+            auto h = std::move(o->handler_);
+            auto ec = o->ec_;
+            auto bt = o->bytes_transferred_;
+            delete o;
+            h(ec, bt);
+        }
+
+    private:
+        Handler handler_;
+    };
+
+    class pipe_receive_op_base : public pipe_op {
+    public:
+        explicit pipe_receive_op_base(complete_func_type complete_func)
+            : pipe_op(&pipe_receive_op_base::do_perform, complete_func)
+        { }
+
+        static bool do_perform(pipe_op* base, pipe_channel & ch) {
+            auto o = static_cast<pipe_receive_op_base*>(base);
+            return pipe_ops::receive(o->msg_, ch, o->bytes_transferred_, o->ec_);
+        }
+
+    protected:
+        message msg_;
+    };
+
+    template<typename Handler>
+    class pipe_receive_op : public pipe_receive_op_base {
+    public:
+        explicit pipe_receive_op(Handler handler)
+            : pipe_receive_op_base(&pipe_receive_op::do_complete)
+            , handler_(std::move(handler))
+        { }
+
+        static void do_complete(pipe_op* base) {
+            auto o = static_cast<pipe_receive_op*>(base);
+            auto h = std::move(o->handler_);
+            auto m = std::move(o->msg_);
+            auto ec = o->ec_;
+            auto bt = o->bytes_transferred_;
+            delete o;
+            h(ec, m, bt);
+        }
+
+    private:
+        Handler handler_;
+    };
+
+    // state of one end of an in-process pipe
+    class pipe_impl {
+    public:
+        using op_queue_type = boost::intrusive::list<pipe_op,
+                                    boost::intrusive::member_hook<
+                                        pipe_op,
+                                        boost::intrusive::list_member_hook<>,
+                                        &pipe_op::member_hook_
+                                    >>;
+        using ptr = std::shared_ptr<pipe_impl>;
+        using weak_ptr = std::weak_ptr<pipe_impl>;
+        using lock_type = unique_lock_t<mutex_t>;
+        using stream_descriptor = socket_ops::stream_descriptor;
+        using flags_type = pipe_ops::flags_type;
+
+        enum op_type : unsigned {
+            read_op = 0,
+            write_op = 1,
+            max_ops = 2
+        };
+
+        pipe_impl(boost::asio::io_service & ios,
+                  std::shared_ptr<pipe_channel> in,
+                  std::shared_ptr<pipe_channel> out)
+            : ios_(ios)
+            , in_(std::move(in))
+            , out_(std::move(out))
+            , sd_{{ stream_descriptor(new socket_ops::posix_sd_type(ios, in_->readable_.native_handle())),
+                    stream_descriptor(new socket_ops::posix_sd_type(ios, out_->writable_.native_handle())) }}
+            , armed_{{ false, false }}
+        { }
+
+        ~pipe_impl() {
+            close();
+            for (auto& q : ops_)
+                q.clear_and_dispose([](pipe_op* op) { delete op; });
+        }
+
+        boost::asio::io_service & get_io_service() { return ios_; }
+
+        void close() {
+            in_->close();
+            out_->close();
+        }
+
+        // mutex_ serializes the attempt with async ops on the same end, but
+        // is not held while blocked. Blocking callers leave the wakeup
+        // descriptors to the reactor
+        size_t send(message & msg, flags_type flags, boost::system::error_code & ec) {
+            size_t res = 0;
+            for (;;) {
+                {
+                    lock_type l{ mutex_ };
+                    if (pipe_ops::send(msg, *out_, res, ec))
+                        return res;
+                    if (flags & ZMQ_DONTWAIT) {
+                        ec = make_error_code(EAGAIN);
+                        return 0;
+                    }
+                }
+                out_->block_until_writable();
+            }
+        }
+
+        size_t receive(message & msg, flags_type flags, boost::system::error_code & ec) {
+            size_t res = 0;
+            for (;;) {
+                {
+                    lock_type l{ mutex_ };
+                    if (pipe_ops::receive(msg, *in_, res, ec))
+                        return res;
+                    if (flags & ZMQ_DONTWAIT) {
+                        ec = make_error_code(EAGAIN);
+                        return 0;
+                    }
+                }
+                in_->block_until_readable();
+            }
+        }
+
+        static void enqueue(ptr const& self, op_type o, std::unique_ptr<pipe_op> op) {
+            lock_type l{ self->mutex_ };
+            auto& ch = self->channel(o);
+            if (self->ops_[o].empty() && op->do_perform(ch)) {
+                l.unlock();
+                auto p = op.release();
+                self->post([p] { pipe_op::do_complete(p); });
+                return;
+            }
+            self->ops_[o].push_back(*op.release());
+            arm(self, o);
+        }
+
+        void cancel(boost::system::error_code & ec) {
+            op_queue_type ops;
+            {
+                lock_type l{ mutex_ };
+                for (auto& q : ops_) {
+                    while (!q.empty()) {
+                        q.front().ec_ = boost::asio::error::operation_aborted;
+                        q.pop_front_and_dispose([&ops](pipe_op* op) { ops.push_back(*op); });
+                    }
+                }
+                for (auto& sd : sd_)
+                    sd->cancel(ec);
+            }
+            while (!ops.empty())
+                ops.pop_front_and_dispose(pipe_op::do_complete);
+        }
+
+    private:
+        boost::asio::io_service & ios_;
+        std::shared_ptr<pipe_channel> in_;
+        std::shared_ptr<pipe_channel> out_;
+        std::array<stream_descriptor, max_ops> sd_;
+        mutable mutex_t mutex_;
+        std::array<op_queue_type, max_ops> ops_;
+        std::array<bool, max_ops> armed_;
+
+        pipe_channel & channel(op_type o) { return o == read_op ? *in_ : *out_; }
+
+        event_fd & wakeup(op_type o) { return o == read_op ? in_->readable_ : out_->writable_; }
+
+        template<typename F>
+        void post(F && f) {
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            ios_.post(std::forward<F>(f));
+#else
+            boost::asio::post(ios_, std::forward<F>(f));
+#endif
+        }
+
+        // must be called with mutex_ held
+        static void arm(ptr const& self, op_type o) {
+            if (self->armed_[o]) return;
+            self->armed_[o] = true;
+
+            auto& ch = self->channel(o);
+            auto ready = o == read_op ? ch.wait_readable()
+                                      : ch.wait_writable();
+            weak_ptr weak_self(self);
+            if (ready) {
+                self->post([weak_self, o] { on_ready(weak_self, o, boost::system::error_code()); });
+            } else {
+                self->sd_[o]->async_read_some(boost::asio::null_buffers(),
+                    [weak_self, o](boost::system::error_code const& ec, size_t) {
+                        on_ready(weak_self, o, ec);
+                    });
+            }
+        }
+
+        static void on_ready(weak_ptr const& weak_self, op_type o, boost::system::error_code ec) {
+            auto self = weak_self.lock();
+            if (!self)
+                return;
+
+            op_queue_type ops;
+            {
+                lock_type l{ self->mutex_ };
+                self->armed_[o] = false;
+                if (ec == boost::asio::error::operation_aborted)
+                    return;
+
+                self->wakeup(o).clear();
+                auto& q = self->ops_[o];
+                auto& ch = self->channel(o);
+                while (!q.empty() && q.front().do_perform(ch)) {
+                    q.pop_front_and_dispose([&ops](pipe_op* op) { ops.push_back(*op); });
+                }
+                if (!q.empty())
+                    arm(self, o);
+            }
+            while (!ops.empty())
+                ops.pop_front_and_dispose(pipe_op::do_complete);
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_PIPE_OPS_HPP_
@@ -11,13 +11,40 @@
 
 #include "../message.hpp"
 #include "socket_ops.hpp"
+#include "timer_wheel.hpp"
 
+#include <boost/version.hpp>
 #include <boost/optional.hpp>
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/intrusive/list.hpp>
 
+#if BOOST_VERSION >= 107700
+#   define AZMQ_DETAIL_HAS_CANCELLATION_SLOT 1
+#   include <boost/asio/associated_cancellation_slot.hpp>
+#   include <boost/asio/cancellation_signal.hpp>
+#endif
+
+#include <exception>
+#include <memory>
+
 namespace azmq {
 namespace detail {
+/** \brief routes the completions of a socket's ops through a strand, an
+ *  exception escaping a handler is passed to failed() rather than unwinding
+ *  the thread running the io_service
+ */
+struct handler_binding {
+    boost::asio::io_service::strand strand_;
+
+    explicit handler_binding(boost::asio::io_service & ios)
+        : strand_(ios)
+    { }
+
+    virtual ~handler_binding() = default;
+    virtual void failed(std::exception_ptr) = 0;
+};
+
 class reactor_op {
 public:
     using socket_type = socket_ops::socket_type;
@@ -25,10 +52,27 @@ public:
     boost::intrusive::list_member_hook<> member_hook_;
     boost::system::error_code ec_;
     size_t bytes_transferred_;
+    timer_wheel::entry * deadline_; // set while the op is queued with a deadline
+    std::shared_ptr<handler_binding> binding_; // the socket's, taken as the op is queued
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+    boost::asio::cancellation_slot slot_; // the handler's, if it has one
+#endif
 
     bool do_perform(socket_type & socket) { return perform_func_(this, socket); }
     static void do_complete(reactor_op * op) {
-        op->complete_func_(op, op->ec_, op->bytes_transferred_);
+        if (!op->binding_) {
+            op->complete_func_(op, op->ec_, op->bytes_transferred_);
+            return;
+        }
+        // the op may be freed, or requeued, by its completion
+        auto b = op->binding_;
+        b->strand_.dispatch([b, op] {
+            try {
+                op->complete_func_(op, op->ec_, op->bytes_transferred_);
+            } catch (...) {
+                b->failed(std::current_exception());
+            }
+        });
     }
 
     static boost::system::error_code canceled() { return boost::asio::error::operation_aborted; }
@@ -46,9 +90,19 @@ protected:
 
     bool is_canceled() const { return ec_ == canceled(); }
 
+    template<typename Handler>
+    void bind_slot(Handler const& handler) {
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+        slot_ = boost::asio::get_associated_cancellation_slot(handler, boost::asio::cancellation_slot());
+#else
+        static_cast<void>(handler);
+#endif
+    }
+
     reactor_op(perform_func_type perform_func,
                complete_func_type complete_func)
         : bytes_transferred_(0)
+        , deadline_(nullptr)
         , perform_func_(perform_func)
         , complete_func_(complete_func)
     { }
@@ -19,6 +19,7 @@
 #include <zmq.h>
 
 #include <iterator>
+#include <memory>
 
 namespace azmq {
 namespace detail {
@@ -63,7 +64,9 @@ public:
         : receive_buffer_op_base<MutableBufferSequence>(buffers, flags,
                                                         &receive_buffer_op::do_complete)
         , handler_(std::move(handler))
-        { }
+    {
+        this->bind_slot(handler_);
+    }
 
     static void do_complete(reactor_op* base,
                             const boost::system::error_code &,
@@ -90,7 +93,9 @@ public:
         : receive_buffer_op_base<MutableBufferSequence>(buffers, flags,
                                                         &receive_more_buffer_op::do_complete)
         , handler_(std::move(handler))
-        { }
+    {
+        this->bind_slot(handler_);
+    }
 
     static void do_complete(reactor_op* base,
                             const boost::system::error_code &,
@@ -138,7 +143,9 @@ public:
                socket_ops::flags_type flags)
         : receive_op_base(flags, &receive_op::do_complete)
         , handler_(std::move(handler))
-        { }
+    {
+        this->bind_slot(handler_);
+    }
 
     static void do_complete(reactor_op* base,
                             const boost::system::error_code &,
@@ -155,6 +162,85 @@ public:
 private:
     Handler handler_;
 };
+
+// a receive_op which is requeued, rather than freed, for as long as its
+// handler returns true, reusing the op and its message. Requeue is called
+// with the op and returns an error if the socket can no longer take it, the
+// handler is then called a last time with that error. A cancellation emitted
+// while the handler runs ends the loop the same way, with operation_aborted.
+template<typename Handler, typename Requeue>
+class receive_loop_op : public receive_op_base {
+public:
+    receive_loop_op(Requeue requeue,
+                    Handler handler,
+                    socket_ops::flags_type flags)
+        : receive_op_base(flags, &receive_loop_op::do_complete)
+        , requeue_(std::move(requeue))
+        , handler_(std::move(handler))
+    {
+        this->bind_slot(handler_);
+    }
+
+    static void do_complete(reactor_op* base,
+                            const boost::system::error_code &,
+                            size_t) {
+        std::unique_ptr<receive_loop_op> o{ static_cast<receive_loop_op*>(base) };
+        if (o->ec_) {
+            o->handler_(o->ec_, o->msg_, o->bytes_transferred_);
+            return;
+        }
+        o->latch_cancellation();
+        auto again = o->handler_(o->ec_, o->msg_, o->bytes_transferred_);
+        auto cancelled = o->unlatch_cancellation();
+        if (!again)
+            return;
+        // once requeued the op may be performed on another thread at once
+        auto ec = cancelled ? canceled() : o->requeue_(*o);
+        if (!ec) {
+            o.release();
+            return;
+        }
+        o->handler_(ec, o->msg_, 0);
+    }
+
+private:
+    Requeue requeue_;
+    Handler handler_;
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+    bool cancelled_ = false;
+
+    struct cancellation_latch {
+        bool & cancelled_;
+
+        explicit cancellation_latch(bool & cancelled) : cancelled_(cancelled) { }
+
+        void operator()(boost::asio::cancellation_type_t type) {
+            if (type != boost::asio::cancellation_type::none)
+                cancelled_ = true;
+        }
+    };
+#endif
+
+    // out of its queue the op's slot would otherwise have no handler, and a
+    // cancellation emitted from the handler would be lost
+    void latch_cancellation() {
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+        if (this->slot_.is_connected())
+            this->slot_.template emplace<cancellation_latch>(cancelled_);
+#endif
+    }
+
+    bool unlatch_cancellation() {
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+        if (this->slot_.is_connected())
+            this->slot_.clear();
+        return cancelled_;
+#else
+        return false;
+#endif
+    }
+};
 } // namespace detail
 } // namespace azmq
 #endif // AZMQ_DETAIL_RECEIVE_OP_HPP_
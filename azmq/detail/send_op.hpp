@@ -57,7 +57,9 @@ public:
         : send_buffer_op_base<ConstBufferSequence>(buffers, flags,
                                                    &send_buffer_op::do_complete)
         , handler_(std::move(handler))
-    { }
+    {
+        this->bind_slot(handler_);
+    }
 
     static void do_complete(reactor_op* base,
                             const boost::system::error_code &,
@@ -108,7 +110,9 @@ public:
             flags_type flags)
         : send_op_base(std::move(msg), flags, &send_op::do_complete)
         , handler_(std::move(handler))
-    { }
+    {
+        this->bind_slot(handler_);
+    }
 
     static void do_complete(reactor_op* base,
                             const boost::system::error_code &,
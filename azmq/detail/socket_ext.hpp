@@ -9,12 +9,15 @@
 #ifndef AZMQ_DETAIL_SOCKET_EXT_HPP__
 #define AZMQ_DETAIL_SOCKET_EXT_HPP__
 #include "../error.hpp"
+#include "../message.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/asio/io_service.hpp>
 
 #include <memory>
+#include <type_traits>
 #include <typeindex>
+#include <utility>
 
 namespace azmq {
 namespace detail {
@@ -55,7 +58,56 @@ namespace detail {
         template<typename Option>
         boost::system::error_code get_option(Option & opt, boost::system::error_code & ec) const {
             BOOST_ASSERT_MSG(ptr_, "reusing (re)moved instance of socket_ext");
-            return ptr_->set_option(opt_model<Option>(opt), ec);
+            opt_model<Option> model(opt);
+            return ptr_->get_option(model, ec);
+        }
+
+        // extensions may optionally provide any of the hooks
+        //   boost::system::error_code on_send(message &, int flags, boost::system::error_code &)
+        //   boost::system::error_code on_receive(message &, boost::system::error_code &)
+        //   void on_complete(hook_op, boost::system::error_code const&, size_t bytes_transferred)
+        //   void on_sent(message const&, int flags)
+        // on_send and on_receive are run on each message passed through the
+        // message overloads of send and receive. A hook may replace the message,
+        // which discards its more() flag, so it should leave frames other than
+        // the last part of a message (ZMQ_SNDMORE in flags, more() on receive)
+        // untouched. on_complete is run as every send or receive, synchronous or
+        // asynchronous, completes. on_sent is run once a message passed through
+        // the message overloads of send has been sent, with the message as
+        // every send hook left it.
+        enum class hook_op { receive, send };
+
+        enum hook_type : unsigned {
+            send_hook = 1,
+            receive_hook = 2,
+            complete_hook = 4,
+            sent_hook = 8
+        };
+
+        // mask of hook_type values for the hooks this extension provides
+        unsigned hooks() const {
+            BOOST_ASSERT_MSG(ptr_, "reusing (re)moved instance of socket_ext");
+            return ptr_->hooks();
+        }
+
+        boost::system::error_code on_send(message & msg, int flags, boost::system::error_code & ec) const {
+            BOOST_ASSERT_MSG(ptr_, "reusing (re)moved instance of socket_ext");
+            return ptr_->on_send(msg, flags, ec);
+        }
+
+        boost::system::error_code on_receive(message & msg, boost::system::error_code & ec) const {
+            BOOST_ASSERT_MSG(ptr_, "reusing (re)moved instance of socket_ext");
+            return ptr_->on_receive(msg, ec);
+        }
+
+        void on_complete(hook_op op, boost::system::error_code const& ec, size_t bytes_transferred) const {
+            BOOST_ASSERT_MSG(ptr_, "reusing (re)moved instance of socket_ext");
+            ptr_->on_complete(op, ec, bytes_transferred);
+        }
+
+        void on_sent(message const& msg, int flags) const {
+            BOOST_ASSERT_MSG(ptr_, "reusing (re)moved instance of socket_ext");
+            ptr_->on_sent(msg, flags);
         }
 
     private :
@@ -87,6 +139,11 @@ namespace detail {
             virtual void on_remove() = 0;
             virtual boost::system::error_code set_option(opt_concept const&, boost::system::error_code &) = 0;
             virtual boost::system::error_code get_option(opt_concept &, boost::system::error_code &) = 0;
+            virtual unsigned hooks() const = 0;
+            virtual boost::system::error_code on_send(message &, int, boost::system::error_code &) = 0;
+            virtual boost::system::error_code on_receive(message &, boost::system::error_code &) = 0;
+            virtual void on_complete(hook_op, boost::system::error_code const&, size_t) = 0;
+            virtual void on_sent(message const&, int) = 0;
         };
         std::unique_ptr<concept> ptr_;
 
@@ -105,6 +162,83 @@ namespace detail {
             boost::system::error_code get_option(opt_concept & opt, boost::system::error_code & ec) override {
                 return data_.get_option(opt, ec);
             }
+
+            template<typename U>
+            static auto has_send(int) -> decltype(std::declval<U&>().on_send(std::declval<message&>(), 0,
+                                                                             std::declval<boost::system::error_code&>()),
+                                                  std::true_type());
+            template<typename U>
+            static std::false_type has_send(...);
+
+            template<typename U>
+            static auto has_receive(int) -> decltype(std::declval<U&>().on_receive(std::declval<message&>(),
+                                                                                   std::declval<boost::system::error_code&>()),
+                                                     std::true_type());
+            template<typename U>
+            static std::false_type has_receive(...);
+
+            template<typename U>
+            static auto has_complete(int) -> decltype(std::declval<U&>().on_complete(hook_op::send,
+                                                                                     std::declval<boost::system::error_code const&>(),
+                                                                                     size_t()),
+                                                      std::true_type());
+            template<typename U>
+            static std::false_type has_complete(...);
+
+            template<typename U>
+            static auto has_sent(int) -> decltype(std::declval<U&>().on_sent(std::declval<message const&>(), 0),
+                                                  std::true_type());
+            template<typename U>
+            static std::false_type has_sent(...);
+
+            using send_tag = decltype(has_send<T>(0));
+            using receive_tag = decltype(has_receive<T>(0));
+            using complete_tag = decltype(has_complete<T>(0));
+            using sent_tag = decltype(has_sent<T>(0));
+
+            unsigned hooks() const override {
+                return (send_tag::value ? unsigned(send_hook) : 0u)
+                     | (receive_tag::value ? unsigned(receive_hook) : 0u)
+                     | (complete_tag::value ? unsigned(complete_hook) : 0u)
+                     | (sent_tag::value ? unsigned(sent_hook) : 0u);
+            }
+
+            boost::system::error_code on_send(message & msg, int flags, boost::system::error_code & ec) override {
+                return on_send(send_tag(), msg, flags, ec);
+            }
+
+            boost::system::error_code on_receive(message & msg, boost::system::error_code & ec) override {
+                return on_receive(receive_tag(), msg, ec);
+            }
+
+            void on_complete(hook_op op, boost::system::error_code const& ec, size_t bytes_transferred) override {
+                on_complete(complete_tag(), op, ec, bytes_transferred);
+            }
+
+            void on_sent(message const& msg, int flags) override {
+                on_sent(sent_tag(), msg, flags);
+            }
+
+            boost::system::error_code on_send(std::true_type, message & msg, int flags, boost::system::error_code & ec) {
+                return data_.on_send(msg, flags, ec);
+            }
+
+            boost::system::error_code on_receive(std::true_type, message & msg, boost::system::error_code & ec) {
+                return data_.on_receive(msg, ec);
+            }
+
+            void on_complete(std::true_type, hook_op op, boost::system::error_code const& ec, size_t bytes_transferred) {
+                data_.on_complete(op, ec, bytes_transferred);
+            }
+
+            void on_sent(std::true_type, message const& msg, int flags) {
+                data_.on_sent(msg, flags);
+            }
+
+            boost::system::error_code on_send(std::false_type, message &, int, boost::system::error_code & ec) { return ec; }
+            boost::system::error_code on_receive(std::false_type, message &, boost::system::error_code & ec) { return ec; }
+            void on_complete(std::false_type, hook_op, boost::system::error_code const&, size_t) { }
+            void on_sent(std::false_type, message const&, int) { }
         };
     };
 } // namespace detail
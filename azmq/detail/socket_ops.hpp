@@ -17,6 +17,7 @@
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
+#include <boost/asio/error.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/socket_base.hpp>
 #if ! defined BOOST_ASIO_WINDOWS
@@ -52,6 +53,15 @@ namespace detail {
             }
         };
 
+        // true for an error which a receive re-armed after a failure should
+        // end on: cancellation, or a socket shut down or whose context has
+        // terminated, which every later receive would fail with too
+        static bool ends_receive(boost::system::error_code const& ec) {
+            return ec == boost::asio::error::operation_aborted
+                || ec == boost::system::errc::operation_not_permitted
+                || ec == make_error_code(ETERM);
+        }
+
         enum class dynamic_port : uint16_t {
             first = 0xc000,
             last = 0xffff
@@ -77,6 +87,10 @@ namespace detail {
         using flags_type = message::flags_type;
         using more_result_type = std::pair<size_t, bool>;
 
+        // azmq specific flag, outside the range of ZMQ_DONTWAIT/ZMQ_SNDMORE,
+        // gathering a buffer sequence into (or scattering it from) one frame
+        enum : flags_type { single_frame = 0x10000 };
+
         static socket_type create_socket(context_ops::context_type context,
                                          int type,
                                          boost::system::error_code & ec) {
@@ -99,19 +113,67 @@ namespace detail {
             auto rc = zmq_getsockopt(socket.get(), ZMQ_FD, &handle, &size);
             if (rc < 0)
                 ec = make_error_code();
-            else {
+            else
+                res = get_stream_descriptor(io_service, handle);
+            return res;
+        }
+
+        static stream_descriptor get_stream_descriptor(boost::asio::io_service & io_service,
+                                                       native_handle_type handle) {
+            stream_descriptor res;
 #if ! defined BOOST_ASIO_WINDOWS
-                res.reset(new boost::asio::posix::stream_descriptor(io_service, handle));
+            res.reset(new boost::asio::posix::stream_descriptor(io_service, handle));
 #else
-                // Use duplicated SOCKET, because ASIO socket takes ownership over it so destroys one in dtor.
-                ::WSAPROTOCOL_INFO pi;
-                ::WSADuplicateSocket(handle, ::GetCurrentProcessId(), &pi);
-                handle = ::WSASocket(pi.iAddressFamily/*AF_INET*/, pi.iSocketType/*SOCK_STREAM*/, pi.iProtocol/*IPPROTO_TCP*/, &pi, 0, 0);
-                res.reset(new boost::asio::ip::tcp::socket(io_service, boost::asio::ip::tcp::v4(), handle));
+            // Use duplicated SOCKET, because ASIO socket takes ownership over it so destroys one in dtor.
+            ::WSAPROTOCOL_INFO pi;
+            ::WSADuplicateSocket(handle, ::GetCurrentProcessId(), &pi);
+            handle = ::WSASocket(pi.iAddressFamily/*AF_INET*/, pi.iSocketType/*SOCK_STREAM*/, pi.iProtocol/*IPPROTO_TCP*/, &pi, 0, 0);
+            res.reset(new boost::asio::ip::tcp::socket(io_service, boost::asio::ip::tcp::v4(), handle));
 #endif
+            return res;
+        }
+
+        // thread-safe (draft) socket types do not support ZMQ_FD
+        static bool is_thread_safe(socket_type & socket) {
+            BOOST_ASSERT_MSG(socket, "invalid socket");
+#ifdef ZMQ_THREAD_SAFE
+            int v = 0;
+            auto size = sizeof(v);
+            if (zmq_getsockopt(socket.get(), ZMQ_THREAD_SAFE, &v, &size) == 0)
+                return v != 0;
+#endif
+            return false;
+        }
+
+#if defined(ZMQ_BUILD_DRAFT_API) && defined(ZMQ_HAVE_POLLER)
+#   define AZMQ_DETAIL_HAS_THREAD_SAFE_SOCKETS 1
+        struct poller_close {
+            void operator()(void* poller) {
+                zmq_poller_destroy(&poller);
+            }
+        };
+        using poller_type = std::unique_ptr<void, poller_close>;
+
+        /** \brief readiness for a thread-safe socket is signalled through a
+         *  zmq_poller's descriptor rather than ZMQ_FD
+         */
+        static poller_type get_socket_poller(socket_type & socket,
+                                             native_handle_type & handle,
+                                             boost::system::error_code & ec) {
+            BOOST_ASSERT_MSG(socket, "invalid socket");
+            poller_type res(zmq_poller_new());
+            if (!res) {
+                ec = make_error_code();
+                return res;
+            }
+            if (zmq_poller_add(res.get(), socket.get(), nullptr, ZMQ_POLLIN | ZMQ_POLLOUT) < 0
+                    || zmq_poller_fd(res.get(), &handle) < 0) {
+                ec = make_error_code();
+                res.reset();
             }
             return res;
         }
+#endif
 
         static boost::system::error_code cancel_stream_descriptor(stream_descriptor & sd,
                                                                   boost::system::error_code & ec) {
@@ -273,6 +335,13 @@ namespace detail {
                          boost::system::error_code & ec) ->
             typename boost::enable_if<boost::has_range_const_iterator<ConstBufferSequence>, size_t>::type
         {
+            if (flags & single_frame) {
+                // one allocation and one copy for the whole sequence
+                message msg(boost::asio::buffer_size(buffers));
+                boost::asio::buffer_copy(msg.buffer(), buffers);
+                return send(msg, socket, flags & ~single_frame, ec);
+            }
+
             size_t res = 0;
             auto last = std::distance(std::begin(buffers), std::end(buffers)) - 1;
             auto index = 0u;
@@ -307,6 +376,17 @@ namespace detail {
         {
             size_t res = 0;
             message msg;
+            if (flags & single_frame) {
+                res = receive(msg, socket, flags & ~single_frame, ec);
+                if (ec)
+                    return 0;
+                if (boost::asio::buffer_copy(buffers, msg.cbuffer()) < res || msg.more()) {
+                    ec = make_error_code(boost::system::errc::no_buffer_space);
+                    return 0;
+                }
+                return res;
+            }
+
             auto it = std::begin(buffers);
             do {
                 auto sz = receive(msg, socket, flags, ec);
@@ -359,6 +439,26 @@ namespace detail {
             return res;
         }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+        static boost::system::error_code join(socket_type & socket,
+                                              std::string const& group,
+                                              boost::system::error_code & ec) {
+            BOOST_ASSERT_MSG(socket, "invalid socket");
+            if (zmq_join(socket.get(), group.c_str()) < 0)
+                ec = make_error_code();
+            return ec;
+        }
+
+        static boost::system::error_code leave(socket_type & socket,
+                                               std::string const& group,
+                                               boost::system::error_code & ec) {
+            BOOST_ASSERT_MSG(socket, "invalid socket");
+            if (zmq_leave(socket.get(), group.c_str()) < 0)
+                ec = make_error_code();
+            return ec;
+        }
+#endif
+
         static std::string monitor(socket_type & socket,
                                    int events,
                                    boost::system::error_code & ec) {
@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_SOCKET_POLLER_HPP_
+#define AZMQ_DETAIL_SOCKET_POLLER_HPP_
+
+#include "../error.hpp"
+#include "config/mutex.hpp"
+#include "config/unique_lock.hpp"
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/system/error_code.hpp>
+
+#if defined(__linux__)
+#   include <sys/epoll.h>
+#   include <unistd.h>
+#   define AZMQ_DETAIL_HAS_SOCKET_POLLER 1
+#endif
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cerrno>
+
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+namespace azmq {
+namespace detail {
+    /** \brief aggregates the ZMQ_FDs of many sockets behind one descriptor
+     *  \tparam Descriptor per socket state, held weakly
+     *  \tparam Handler callable as handler(std::shared_ptr<Descriptor>&) for
+     *  each ready socket
+     *  \remark The ZMQ_FDs are registered, edge triggered, in a private epoll
+     *  set and only the epoll descriptor is registered with the io_service.
+     *  A single wakeup drains every ready socket in a batch, so there is one
+     *  outstanding asio operation regardless of the number of sockets.
+     *  \remark libzmq's zmq_poller offers the same aggregation, but its
+     *  descriptor accessor is only present in draft API builds.
+     */
+    template<typename Descriptor, typename Handler>
+    class socket_poller
+        : public std::enable_shared_from_this<socket_poller<Descriptor, Handler>> {
+    public:
+        using descriptor_ptr = std::shared_ptr<Descriptor>;
+        using weak_descriptor_ptr = std::weak_ptr<Descriptor>;
+        using native_handle_type = int;
+
+        socket_poller(boost::asio::io_service & ios, Handler handler,
+                      boost::system::error_code & ec)
+            : handler_(std::move(handler))
+            , sd_(ios)
+        {
+            auto fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (fd < 0) {
+                ec = make_error_code();
+                return;
+            }
+            sd_.assign(fd, ec);
+            if (ec)
+                ::close(fd);
+        }
+
+        socket_poller(socket_poller const&) = delete;
+        socket_poller & operator=(socket_poller const&) = delete;
+
+        bool add(native_handle_type fd, descriptor_ptr const& d,
+                 boost::system::error_code & ec) {
+            unique_lock_t<mutex_t> l{ mutex_ };
+            epoll_event ev = { };
+            ev.events = EPOLLIN | EPOLLET;
+            ev.data.fd = fd;
+            auto rc = ::epoll_ctl(sd_.native_handle(), EPOLL_CTL_ADD, fd, &ev);
+            if (rc < 0 && errno == EEXIST)
+                rc = ::epoll_ctl(sd_.native_handle(), EPOLL_CTL_MOD, fd, &ev);
+            if (rc < 0) {
+                ec = make_error_code();
+                return false;
+            }
+            // a descriptor number may be reused once its socket is closed
+            map_[fd] = d;
+            if (!armed_) {
+                armed_ = true;
+                arm();
+            }
+            return true;
+        }
+
+        void remove(native_handle_type fd) {
+            unique_lock_t<mutex_t> l{ mutex_ };
+            do_remove(fd);
+        }
+
+        void cancel() {
+            boost::system::error_code ec;
+            sd_.cancel(ec);
+        }
+
+        size_t size() const {
+            unique_lock_t<mutex_t> l{ mutex_ };
+            return map_.size();
+        }
+
+    private:
+        enum { max_batch = 256 };
+
+        Handler handler_;
+        boost::asio::posix::stream_descriptor sd_;
+        mutable mutex_t mutex_;
+        bool armed_ = false;
+        boost::container::flat_map<native_handle_type, weak_descriptor_ptr> map_;
+        std::array<epoll_event, max_batch> events_;
+        std::vector<descriptor_ptr> ready_;
+
+        void do_remove(native_handle_type fd) {
+            ::epoll_ctl(sd_.native_handle(), EPOLL_CTL_DEL, fd, nullptr);
+            map_.erase(fd);
+        }
+
+        void arm() {
+            std::weak_ptr<socket_poller> w = this->shared_from_this();
+            sd_.async_read_some(boost::asio::null_buffers(),
+                                [w](boost::system::error_code const& ec, size_t) {
+                                    if (ec)
+                                        return;
+                                    if (auto p = w.lock())
+                                        p->on_ready();
+                                });
+        }
+
+        void on_ready() {
+            int n;
+            do {
+                // only the (single) outstanding wakeup runs here, so events_
+                // and ready_ need no further synchronization
+                n = ::epoll_wait(sd_.native_handle(), events_.data(), max_batch, 0);
+                if (n <= 0)
+                    break;
+                {
+                    unique_lock_t<mutex_t> l{ mutex_ };
+                    for (auto i = 0; i != n; ++i) {
+                        auto fd = events_[i].data.fd;
+                        auto it = map_.find(fd);
+                        if (it == std::end(map_))
+                            continue;
+                        if (auto d = it->second.lock())
+                            ready_.push_back(std::move(d));
+                        else
+                            do_remove(fd);
+                    }
+                }
+                for (auto& d : ready_)
+                    handler_(d);
+                ready_.clear();
+            } while (n == max_batch);
+            arm();
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_HAS_SOCKET_POLLER
+#endif // AZMQ_DETAIL_SOCKET_POLLER_HPP_
@@ -23,11 +23,15 @@
 #include "reactor_op.hpp"
 #include "send_op.hpp"
 #include "receive_op.hpp"
+#include "wait_op.hpp"
+#include "timer_wheel.hpp"
+#include "socket_poller.hpp"
 
 #include <boost/version.hpp>
 #include <boost/assert.hpp>
 #include <boost/optional.hpp>
 #include <boost/intrusive/list.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/system/system_error.hpp>
 #include <boost/container/flat_map.hpp>
 #include <boost/thread/mutex.hpp>
@@ -39,6 +43,9 @@
 #endif
 
 #include <memory>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
 #include <typeindex>
 #include <string>
 #include <vector>
@@ -47,6 +54,14 @@
 
 namespace azmq {
 namespace detail {
+    /** \brief busy poll counters for a socket, see socket_service::busy_poll_spins */
+    struct busy_poll_stats {
+        uint64_t polls = 0;     // times the service spun rather than arming the reactor
+        uint64_t hits = 0;      // spins which found the socket ready
+        uint64_t misses = 0;    // spins which exhausted their budget
+        uint64_t probes = 0;    // ZMQ_EVENTS queries made while spinning
+    };
+
     class socket_service
         : public azmq::detail::service_base<socket_service> {
     public:
@@ -65,6 +80,11 @@ namespace detail {
                                     >>;
         using exts_type = boost::container::flat_map<std::type_index, socket_ext>;
         using allow_speculative = opt::boolean<static_cast<int>(opt::limits::lib_socket_min)>;
+        // lib_socket_min + 1 is used by the monitor extension and
+        // lib_socket_min + 5 .. 7 by the codec extension
+        using busy_poll_spins = opt::integer<static_cast<int>(opt::limits::lib_socket_min) + 2>;
+        using busy_poll_usec = opt::integer<static_cast<int>(opt::limits::lib_socket_min) + 3>;
+        using busy_poll_counters = opt::base<busy_poll_stats, static_cast<int>(opt::limits::lib_socket_min) + 4>;
 
         enum class shutdown_type {
             none = 0,
@@ -72,6 +92,11 @@ namespace detail {
             receive
         };
 
+        enum class wait_type {
+            read,
+            write
+        };
+
         enum op_type : unsigned {
             read_op = 0,
             write_op = 1,
@@ -80,15 +105,30 @@ namespace detail {
 
         struct per_descriptor_data {
             bool optimize_single_threaded_ = false;
+            context_type ctx_; // keeps the context alive while socket_ is open
             socket_type socket_;
+#ifdef AZMQ_DETAIL_HAS_THREAD_SAFE_SOCKETS
+            socket_ops::poller_type ts_poller_; // readiness source for thread-safe sockets
+#endif
             stream_descriptor sd_;
+            bool thread_safe_ = false;
             mutable boost::mutex mutex_;
             bool in_speculative_completion_ = false;
-            bool scheduled_ = false;
+            std::atomic<bool> scheduled_{ false };
+            unsigned reactor_gen_ = 0; // bumped to orphan a pending reactor_handler
+            unsigned cancel_gen_ = 0; // bumped when every queued op is cancelled
             bool missed_events_found_ = false;
             bool allow_speculative_ = true;
-            shutdown_type shutdown_ = shutdown_type::none;
+            bool polled_ = false; // registered with the service's socket_poller
+            int busy_poll_spins_ = 0;
+            int busy_poll_usec_ = 0;
+            busy_poll_stats busy_poll_stats_;
+            std::atomic<shutdown_type> shutdown_{ shutdown_type::none };
             exts_type exts_;
+            std::vector<std::type_index> installed_; // exts_ keys, in install order
+            std::vector<socket_ext*> hooked_; // exts_ providing hooks, in install order
+            std::atomic<unsigned> hooks_{ 0 }; // socket_ext::hook_type mask over exts_
+            std::weak_ptr<handler_binding> binding_; // passed to each op as it is queued
             endpoint_type endpoint_;
             bool serverish_ = false;
             std::array<op_queue_type, max_ops> op_queue_;
@@ -105,8 +145,21 @@ namespace detail {
                 BOOST_ASSERT_MSG(!socket_, "socket already open");
                 socket_ = socket_ops::create_socket(ctx, type, ec);
                 if (ec) return;
-
-                sd_ = socket_ops::get_stream_descriptor(ios, socket_, ec);
+                ctx_ = ctx;
+
+                thread_safe_ = socket_ops::is_thread_safe(socket_);
+                if (thread_safe_) {
+#ifdef AZMQ_DETAIL_HAS_THREAD_SAFE_SOCKETS
+                    socket_ops::native_handle_type handle;
+                    ts_poller_ = socket_ops::get_socket_poller(socket_, handle, ec);
+                    if (ec) return;
+                    sd_ = socket_ops::get_stream_descriptor(ios, handle);
+#else
+                    ec = make_error_code(boost::system::errc::not_supported);
+#endif
+                } else {
+                    sd_ = socket_ops::get_stream_descriptor(ios, socket_, ec);
+                }
                 if (ec) return;
 
                 optimize_single_threaded_ = optimize_single_threaded;
@@ -128,6 +181,7 @@ namespace detail {
                     for (size_t i = 0; i != max_ops; ++i) {
                         if ((evs & filter[i]) && op_queue_[i].front().do_perform(socket_)) {
                             op_queue_[i].pop_front_and_dispose([&ops](reactor_op * op) {
+                                release(op);
                                 ops.push_back(*op);
                             });
                         }
@@ -141,17 +195,78 @@ namespace detail {
                 return socket_ops::cancel_stream_descriptor(sd_, ec);
             }
 
+            // takes a single queued op out of turn
+            void cancel_op(op_type o, reactor_op * op, boost::system::error_code const& ec,
+                           op_queue_type & ops) {
+                op_queue_[o].erase(op_queue_type::s_iterator_to(*op));
+                release(op);
+                op->ec_ = ec;
+                ops.push_back(*op);
+            }
+
             void cancel_ops(boost::system::error_code const& ec, op_queue_type & ops) {
+                ++cancel_gen_;
                 for (size_t i = 0; i != max_ops; ++i) {
                     while (!op_queue_[i].empty()) {
                         op_queue_[i].front().ec_ = ec;
                         op_queue_[i].pop_front_and_dispose([&ops](reactor_op * op) {
+                            release(op);
                             ops.push_back(*op);
                         });
                     }
                 }
             }
 
+            // hooks_ is cached so that sockets without hooking extensions pay
+            // a single load and branch per operation. exts_ is ordered by
+            // type, and moves its elements as it changes, so hooked_ is rebuilt
+            // in install order whenever an extension comes or goes
+            void update_hooks() {
+                unsigned res = 0;
+                hooked_.clear();
+                for (auto const& t : installed_) {
+                    auto& ext = exts_.find(t)->second;
+                    if (auto h = ext.hooks()) {
+                        res |= h;
+                        hooked_.push_back(&ext);
+                    }
+                }
+                hooks_ = res;
+            }
+
+            bool has_hook(socket_ext::hook_type h) const {
+                return (hooks_.load(std::memory_order_relaxed) & h) != 0;
+            }
+
+            // send hooks run in install order and receive hooks in the reverse,
+            // so extensions nest with the first installed outermost
+            boost::system::error_code on_send(message & msg, int flags, boost::system::error_code & ec) {
+                for (auto ext : hooked_) {
+                    if (ext->on_send(msg, flags, ec))
+                        break;
+                }
+                return ec;
+            }
+
+            boost::system::error_code on_receive(message & msg, boost::system::error_code & ec) {
+                for (auto it = hooked_.rbegin(); it != hooked_.rend(); ++it) {
+                    if ((*it)->on_receive(msg, ec))
+                        break;
+                }
+                return ec;
+            }
+
+            void on_complete(op_type o, boost::system::error_code const& ec, size_t bytes_transferred) {
+                auto op = o == write_op ? socket_ext::hook_op::send : socket_ext::hook_op::receive;
+                for (auto ext : hooked_)
+                    ext->on_complete(op, ec, bytes_transferred);
+            }
+
+            void on_sent(message const& msg, int flags) {
+                for (auto ext : hooked_)
+                    ext->on_sent(msg, flags);
+            }
+
             void set_endpoint(socket_ops::endpoint_type endpoint, bool serverish) {
                 endpoint_ = std::move(endpoint);
                 serverish_ = serverish;
@@ -165,14 +280,18 @@ namespace detail {
             void format(std::ostream & stm) {
                 char const* kinds[] = {"PAIR", "PUB", "SUB", "REQ", "REP",
                                         "DEALER", "ROUTER", "PULL", "PUSH",
-                                        "XPUB", "XSUB", "STREAM"
+                                        "XPUB", "XSUB", "STREAM",
+                                        // draft thread-safe types
+                                        "SERVER", "CLIENT", "RADIO", "DISH",
+                                        "GATHER", "SCATTER", "DGRAM"
                                       };
                 static_assert(ZMQ_PAIR == 0, "ZMQ_PAIR");
                 boost::system::error_code ec;
                 auto kind = socket_ops::get_socket_kind(socket_, ec);
                 if (ec)
                     throw boost::system::system_error(ec);
-                BOOST_ASSERT_MSG(kind >= 0 && kind <= ZMQ_STREAM, "kind not in [ZMQ_PAIR, ZMQ_STREAM]");
+                BOOST_ASSERT_MSG(kind >= 0 && kind < static_cast<int>(sizeof(kinds) / sizeof(kinds[0])),
+                                 "unknown socket kind");
                 stm << "socket[" << kinds[kind] << "]{ ";
                 if (!endpoint_.empty())
                     stm << (serverish_ ? '@' : '>') << endpoint_ << ' ';
@@ -184,9 +303,9 @@ namespace detail {
                 mutex_.lock();
             }
 
-            void try_lock() const {
-                if (optimize_single_threaded_) return;
-                mutex_.try_lock();
+            bool try_lock() const {
+                if (optimize_single_threaded_) return true;
+                return mutex_.try_lock();
             }
 
             void unlock() const {
@@ -199,6 +318,161 @@ namespace detail {
 
         using core_access = azmq::detail::core_access<socket_service>;
 
+        using deadline_type = timer_wheel::time_point;
+        static deadline_type no_deadline() { return deadline_type::max(); }
+
+        class deadline_timers;
+
+        /** \brief wheel entry of a queued op with a deadline */
+        struct op_deadline : timer_wheel::entry {
+            deadline_timers * timers_;
+            std::weak_ptr<per_descriptor_data> owner_;
+            op_type op_;
+            reactor_op * target_;
+        };
+
+        /** \brief expires queued ops at their deadlines
+         *  \remark One wheel and steady_timer serve every socket on the
+         *  service. The timer is created on first use, and armed for the
+         *  earliest outstanding deadline only, so it wakes the io_service
+         *  once per expiry rather than on every tick of the wheel; it is
+         *  cancelled once no deadlines remain.
+         *  An op leaving its queue, with its socket locked, unlinks its entry.
+         *  On expiry the op is taken out of its queue and completed with
+         *  timed_out, leaving the socket's other ops queued; a socket which is
+         *  locked at that moment has its op retried on the next tick, so the
+         *  wheel never waits on a socket's lock.
+         */
+        class deadline_timers {
+        public:
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            deadline_timers(socket_service & service, boost::asio::io_service & ios)
+#else
+            deadline_timers(socket_service & service, boost::asio::io_context & ios)
+#endif
+                : service_(service)
+                , ios_(ios)
+            { }
+
+            // called with impl locked, after op has been queued
+            void add(implementation_type const& impl, op_type o, reactor_op & op, deadline_type deadline) {
+                auto d = new op_deadline;
+                d->timers_ = this;
+                d->owner_ = impl;
+                d->op_ = o;
+                d->target_ = &op;
+                op.deadline_ = d;
+                lock_type l{ mutex_ };
+                wheel_.add(*d, deadline);
+                auto due = wheel_.due(*d);
+                if (due < armed_until_ && !shutdown_)
+                    arm(due);
+            }
+
+            // called with the op's socket locked, as the op leaves its queue
+            void remove(reactor_op & op) {
+                auto d = static_cast<op_deadline*>(op.deadline_);
+                op.deadline_ = nullptr;
+                {
+                    lock_type l{ mutex_ };
+                    wheel_.remove(*d);
+                    // an idle timer should not hold work on the io_service
+                    if (wheel_.empty() && timer_) {
+                        armed_until_ = deadline_type::max();
+                        timer_->cancel();
+                    }
+                }
+                delete d;
+            }
+
+            size_t size() const {
+                lock_type l{ mutex_ };
+                return wheel_.size();
+            }
+
+            // the timer's service may be shut down first, so the timer must
+            // not outlive this call
+            void shutdown() {
+                lock_type l{ mutex_ };
+                shutdown_ = true;
+                timer_.reset();
+            }
+
+        private:
+            using lock_type = boost::unique_lock<boost::mutex>;
+
+            socket_service & service_;
+            mutable boost::mutex mutex_;
+            timer_wheel wheel_;
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            boost::asio::io_service & ios_;
+#else
+            boost::asio::io_context & ios_;
+#endif
+            std::unique_ptr<boost::asio::steady_timer> timer_;
+            deadline_type armed_until_ = deadline_type::max(); // max() while disarmed
+            bool shutdown_ = false;
+
+            // supersedes any wait in progress, which completes as aborted
+            void arm(deadline_type at) {
+                armed_until_ = at;
+                if (!timer_)
+                    timer_.reset(new boost::asio::steady_timer(ios_));
+                timer_->expires_at(at);
+                timer_->async_wait([this](boost::system::error_code const& ec) { expire(ec); });
+            }
+
+            void expire(boost::system::error_code const& ec) {
+                std::vector<implementation_type> owners; // released once mutex_ is
+                op_queue_type ops;
+                {
+                    lock_type l{ mutex_ };
+                    // an aborted wait was superseded, or the timer cancelled
+                    if (ec || shutdown_)
+                        return;
+                    armed_until_ = deadline_type::max();
+                    auto now = timer_wheel::clock_type::now();
+                    auto busy = false;
+                    wheel_.advance(now, [&](timer_wheel::entry & e) {
+                        auto d = static_cast<op_deadline*>(&e);
+                        auto p = d->owner_.lock();
+                        if (p && !p->try_lock()) {
+                            owners.push_back(std::move(p));
+                            busy = true;
+                            return false;
+                        }
+                        if (p) {
+                            d->target_->deadline_ = nullptr;
+                            p->cancel_op(d->op_, d->target_, boost::asio::error::timed_out, ops);
+                            service_.disarm(p);
+                            p->unlock();
+                            owners.push_back(std::move(p));
+                        }
+                        delete d;
+                        return true;
+                    });
+                    // a deadline whose socket was locked is retried a tick
+                    // later, rather than spinning until the lock is released
+                    if (!wheel_.empty())
+                        arm(busy ? std::max(wheel_.next_expiry(), now + wheel_.resolution())
+                                 : wheel_.next_expiry());
+                }
+                while (!ops.empty())
+                    ops.pop_front_and_dispose(reactor_op::do_complete);
+            }
+        };
+
+        // detaches an op's deadline and cancellation slot as it leaves its
+        // queue, with the op's socket locked
+        static void release(reactor_op * op) {
+            if (op->deadline_)
+                static_cast<op_deadline*>(op->deadline_)->timers_->remove(*op);
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            if (op->slot_.is_connected())
+                op->slot_.clear();
+#endif
+        }
+
 #ifdef AZMQ_DETAIL_USE_IO_SERVICE	  
         explicit socket_service(boost::asio::io_service & ios)
 #else
@@ -206,13 +480,28 @@ namespace detail {
 #endif
             : azmq::detail::service_base<socket_service>(ios)
             , ctx_(context_ops::get_context())
+            , deadlines_(*this, ios)
         { }
 
         void shutdown_service() override {
-            ctx_.reset();
+            deadlines_.shutdown();
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+            if (auto p = std::atomic_load(&poller_))
+                p->cancel();
+            std::atomic_store(&poller_, poller_ptr());
+#endif
+            std::atomic_store(&ctx_, context_type());
         }
 
-        context_type context() const { return ctx_; }
+        context_type context() const { return std::atomic_load(&ctx_); }
+
+        /** \brief replace the context used for sockets subsequently opened on
+         *  this service, sockets already open keep their context alive
+         */
+        void set_context(context_type ctx) {
+            BOOST_ASSERT_MSG(ctx, "context must not be null");
+            std::atomic_store(&ctx_, std::move(ctx));
+        }
 
         void construct(implementation_type & impl) {
             impl = std::make_shared<per_descriptor_data>();
@@ -235,10 +524,11 @@ namespace detail {
                                           bool optimize_single_threaded,
                                           boost::system::error_code & ec) {
             BOOST_ASSERT_MSG(impl, "impl");
+            auto ctx = context();
 #ifdef AZMQ_DETAIL_USE_IO_SERVICE
-            impl->do_open(get_io_service(), ctx_, type, optimize_single_threaded, ec);
+            impl->do_open(get_io_service(), ctx, type, optimize_single_threaded, ec);
 #else
-            impl->do_open(get_io_context(), ctx_, type, optimize_single_threaded, ec);
+            impl->do_open(get_io_context(), ctx, type, optimize_single_threaded, ec);
 #endif
             if (ec)
                 impl.reset();
@@ -246,6 +536,18 @@ namespace detail {
         }
 
         void destroy(implementation_type & impl) {
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+            // the poller's entry would otherwise pin impl until its
+            // descriptor number is reused
+            if (impl) {
+                unique_lock l{ *impl };
+                if (impl->polled_) {
+                    if (auto p = std::atomic_load(&poller_))
+                        p->remove(impl->sd_->native_handle());
+                    impl->polled_ = false;
+                }
+            }
+#endif
             impl.reset();
         }
 
@@ -255,6 +557,47 @@ namespace detail {
             return impl->socket_.get();
         }
 
+        /** \brief service sockets subsequently scheduled on this service through
+         *  a single aggregated poller, rather than one reactor registration each
+         *  \remark Sockets which already have a pending operation keep their
+         *  individual registration.
+         */
+        boost::system::error_code use_poller(boost::system::error_code & ec) {
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+            if (std::atomic_load(&poller_))
+                return ec;
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            auto p = std::make_shared<poller_type>(get_io_service(), poll_handler{ descriptors_ }, ec);
+#else
+            auto p = std::make_shared<poller_type>(get_io_context(), poll_handler{ descriptors_ }, ec);
+#endif
+            if (ec)
+                return ec;
+            poller_ptr expected;
+            std::atomic_compare_exchange_strong(&poller_, &expected, p);
+#else
+            ec = make_error_code(boost::system::errc::not_supported);
+#endif
+            return ec;
+        }
+
+        bool uses_poller() const {
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+            return static_cast<bool>(std::atomic_load(&poller_));
+#else
+            return false;
+#endif
+        }
+
+        // number of sockets registered with the poller
+        size_t polled() const {
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+            if (auto p = std::atomic_load(&poller_))
+                return p->size();
+#endif
+            return 0;
+        }
+
         template<typename Extension>
         bool associate_ext(implementation_type & impl, Extension&& ext) {
             BOOST_ASSERT_MSG(impl, "impl");
@@ -263,15 +606,27 @@ namespace detail {
             bool res;
             std::tie(it, res) = impl->exts_.emplace(std::type_index(typeid(Extension)),
                                                     socket_ext(std::forward<Extension>(ext)));
-            if (res)
+            if (res) {
 #ifdef AZMQ_DETAIL_USE_IO_SERVICE
                 it->second.on_install(get_io_service(), impl->socket_.get());
 #else
                 it->second.on_install(get_io_context(), impl->socket_.get());
 #endif
+                impl->installed_.push_back(it->first);
+                impl->update_hooks();
+            }
             return res;
         }
 
+        /** \brief complete the socket's subsequently queued ops through
+         *  binding, see handler_binding
+         */
+        void bind_handlers(implementation_type & impl, std::weak_ptr<handler_binding> binding) {
+            BOOST_ASSERT_MSG(impl, "impl");
+            unique_lock l{ *impl };
+            impl->binding_ = std::move(binding);
+        }
+
         template<typename Extension>
         bool remove_ext(implementation_type & impl) {
             BOOST_ASSERT_MSG(impl, "impl");
@@ -279,7 +634,10 @@ namespace detail {
             auto it = impl->exts_.find(std::type_index(typeid(Extension)));
             if (it != std::end(impl->exts_)) {
                 it->second.on_remove();
+                impl->installed_.erase(std::find(std::begin(impl->installed_),
+                                                 std::end(impl->installed_), it->first));
                 impl->exts_.erase(it);
+                impl->update_hooks();
                 return true;
             }
             return false;
@@ -288,13 +646,15 @@ namespace detail {
         template<typename Option>
         boost::system::error_code set_option(Option const& option,
                                              boost::system::error_code & ec) {
-            return context_ops::set_option(ctx_, option, ec);
+            auto ctx = context();
+            return context_ops::set_option(ctx, option, ec);
         }
 
         template<typename Option>
         boost::system::error_code get_option(Option & option,
                                              boost::system::error_code & ec) {
-            return context_ops::get_option(ctx_, option, ec);
+            auto ctx = context();
+            return context_ops::get_option(ctx, option, ec);
         }
 
         template<typename Option>
@@ -302,21 +662,20 @@ namespace detail {
                                              Option const& option,
                                              boost::system::error_code & ec) {
             unique_lock l{ *impl };
-            switch (option.name()) {
-            case allow_speculative::static_name::value :
-                    ec = boost::system::error_code();
-                    impl->allow_speculative_ = option.data() ? *static_cast<bool const*>(option.data())
-                                                             : false;
-                break;
-            default:
-                for (auto& ext : impl->exts_) {
-                    if (ext.second.set_option(option, ec)) {
-                        if (ec.value() == boost::system::errc::not_supported) continue;
-                        return ec;
-                    }
-                }
-                ec = boost::system::error_code();
-                socket_ops::set_option(impl->socket_, option, ec);
+            return set_option_locked(impl, option, ec);
+        }
+
+        /** \brief set a range of options holding the socket's lock once,
+         *  stopping at the first which fails
+         */
+        template<typename Iterator>
+        boost::system::error_code set_options(implementation_type & impl,
+                                              Iterator first, Iterator last,
+                                              boost::system::error_code & ec) {
+            unique_lock l{ *impl };
+            for (; first != last; ++first) {
+                if (set_option_locked(impl, *first, ec))
+                    break;
             }
             return ec;
         }
@@ -335,12 +694,29 @@ namespace detail {
                         *static_cast<bool*>(option.data()) = impl->allow_speculative_;
                     }
                 break;
+            case busy_poll_spins::static_name::value :
+                ec = boost::system::error_code();
+                *static_cast<int*>(option.data()) = impl->busy_poll_spins_;
+                break;
+            case busy_poll_usec::static_name::value :
+                ec = boost::system::error_code();
+                *static_cast<int*>(option.data()) = impl->busy_poll_usec_;
+                break;
+            case busy_poll_counters::static_name::value :
+                if (option.size() < sizeof(busy_poll_stats)) {
+                    ec = make_error_code(boost::system::errc::invalid_argument);
+                } else {
+                    ec = boost::system::error_code();
+                    *static_cast<busy_poll_stats*>(option.data()) = impl->busy_poll_stats_;
+                }
+                break;
             default:
+                // extensions report options they do not handle as not_supported
                 for (auto& ext : impl->exts_) {
-                    if (ext.second.get_option(option, ec)) {
-                        if (ec.value() == boost::system::errc::not_supported) continue;
+                    ec = boost::system::error_code();
+                    ext.second.get_option(option, ec);
+                    if (ec.value() != boost::system::errc::not_supported)
                         return ec;
-                    }
                 }
                 ec = boost::system::error_code();
                 socket_ops::get_option(impl->socket_, option, ec);
@@ -410,24 +786,43 @@ namespace detail {
                     ConstBufferSequence const& buffers,
                     flags_type flags,
                     boost::system::error_code & ec) {
-            unique_lock l{ *impl };
-            if (is_shutdown(impl, op_type::write_op, ec))
-                return 0;
-            auto r = socket_ops::send(buffers, impl->socket_, flags, ec);
-            check_missed_events(impl);
-            return r;
+            return sync_op(impl, op_type::write_op, ec, [&](unsigned) {
+                return socket_ops::send(buffers, impl->socket_, flags, ec);
+            });
         }
 
         size_t send(implementation_type & impl,
                     message const& msg,
                     flags_type flags,
                     boost::system::error_code & ec) {
-            unique_lock l{ *impl };
-            if (is_shutdown(impl, op_type::write_op, ec))
-                return 0;
-            auto r = socket_ops::send(msg, impl->socket_, flags, ec);
-            check_missed_events(impl);
-            return r;
+            return sync_op(impl, op_type::write_op, ec, [&](unsigned hooks) -> size_t {
+                if (!(hooks & socket_ext::send_hook))
+                    return send_hooked(impl, msg, flags, hooks, ec);
+                message m(msg);
+                if (impl->on_send(m, flags, ec))
+                    return 0;
+                return send_hooked(impl, m, flags, hooks, ec);
+            });
+        }
+
+        size_t send(implementation_type & impl,
+                    message && msg,
+                    flags_type flags,
+                    boost::system::error_code & ec) {
+            return sync_op(impl, op_type::write_op, ec, [&](unsigned hooks) -> size_t {
+                if (!(hooks & socket_ext::send_hook))
+                    return send_hooked(impl, msg, flags, hooks, ec);
+                // the hooks work on msg in place, so should the send fail the
+                // caller is handed back the message it gave, e.g. to retry.
+                // That costs a reference counted copy, only when hooked
+                message original(msg);
+                size_t r = 0;
+                if (!impl->on_send(msg, flags, ec))
+                    r = send_hooked(impl, msg, flags, hooks, ec);
+                if (ec)
+                    msg = std::move(original);
+                return r;
+            });
         }
 
         template<typename MutableBufferSequence>
@@ -435,38 +830,60 @@ namespace detail {
                        MutableBufferSequence const& buffers,
                        flags_type flags,
                        boost::system::error_code & ec) {
-            unique_lock l{ *impl };
-            if (is_shutdown(impl, op_type::read_op, ec))
-                return 0;
-            auto r = socket_ops::receive(buffers, impl->socket_, flags, ec);
-            check_missed_events(impl);
-            return r;
+            return sync_op(impl, op_type::read_op, ec, [&](unsigned) {
+                return socket_ops::receive(buffers, impl->socket_, flags, ec);
+            });
         }
 
         size_t receive(implementation_type & impl,
                        message & msg,
                        flags_type flags,
                        boost::system::error_code & ec) {
-            unique_lock l{ *impl };
-            if (is_shutdown(impl, op_type::read_op, ec))
-                return 0;
-            auto r = socket_ops::receive(msg, impl->socket_, flags, ec);
-            check_missed_events(impl);
-            return r;
+            return sync_op(impl, op_type::read_op, ec, [&](unsigned hooks) -> size_t {
+                auto res = socket_ops::receive(msg, impl->socket_, flags, ec);
+                if (ec || !(hooks & socket_ext::receive_hook))
+                    return res;
+                if (impl->on_receive(msg, ec))
+                    return 0;
+                return msg.size();
+            });
         }
 
         size_t receive_more(implementation_type & impl,
                             message_vector & vec,
                             flags_type flags,
                             boost::system::error_code & ec) {
+            return sync_op(impl, op_type::read_op, ec, [&](unsigned hooks) -> size_t {
+                auto first = vec.size();
+                auto res = socket_ops::receive_more(vec, impl->socket_, flags, ec);
+                if (ec || !(hooks & socket_ext::receive_hook))
+                    return res;
+                res = 0;
+                for (auto i = first; i != vec.size(); ++i) {
+                    if (impl->on_receive(vec[i], ec))
+                        return 0;
+                    res += vec[i].size();
+                }
+                return res;
+            });
+        }
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        boost::system::error_code join(implementation_type & impl,
+                                       std::string const& group,
+                                       boost::system::error_code & ec) {
             unique_lock l{ *impl };
-            if (is_shutdown(impl, op_type::read_op, ec))
-                return 0;
-            auto r = socket_ops::receive_more(vec, impl->socket_, flags, ec);
-            check_missed_events(impl);
-            return r;
+            return socket_ops::join(impl->socket_, group, ec);
         }
 
+        boost::system::error_code leave(implementation_type & impl,
+                                        std::string const& group,
+                                        boost::system::error_code & ec) {
+            unique_lock l{ *impl };
+            return socket_ops::leave(impl->socket_, group, ec);
+        }
+#endif
+
         size_t flush(implementation_type & impl,
                      boost::system::error_code & ec) {
             unique_lock l{ *impl };
@@ -477,11 +894,168 @@ namespace detail {
             return r;
         }
 
+        /** \brief socket_ext::hook_type mask of the hooks installed on a socket */
+        unsigned hooks(implementation_type const& impl) const {
+            return impl->hooks_.load(std::memory_order_relaxed);
+        }
+
+        /** \brief run extension send hooks on a message about to be queued by
+         *  an async send
+         */
+        boost::system::error_code on_send(implementation_type & impl,
+                                          message & msg,
+                                          flags_type flags,
+                                          boost::system::error_code & ec) {
+            if (!impl->has_hook(socket_ext::send_hook))
+                return ec;
+            unique_lock l{ *impl };
+            return impl->on_send(msg, flags, ec);
+        }
+
+        /** \brief complete a WriteHandler with ec without queueing an op, as
+         *  when an extension's send hook fails an async send
+         */
+        template<typename WriteHandler>
+        void post_send_error(WriteHandler && handler, boost::system::error_code const& ec) {
+            auto f = [h = std::forward<WriteHandler>(handler), ec]() mutable { h(ec, 0); };
+#ifdef AZMQ_DETAIL_USE_IO_SERVICE
+            get_io_service().post(std::move(f));
+#else
+            boost::asio::post(get_io_context(), std::move(f));
+#endif
+        }
+
+        /** \brief wraps a MessageReadHandler, running extension receive hooks
+         *  on the message before it is passed on
+         */
+        template<typename Handler>
+        struct receive_hook_handler {
+            std::weak_ptr<per_descriptor_data> owner_;
+            Handler handler_;
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            using cancellation_slot_type = boost::asio::associated_cancellation_slot_t<Handler>;
+            cancellation_slot_type get_cancellation_slot() const noexcept {
+                return boost::asio::get_associated_cancellation_slot(handler_);
+            }
+#endif
+
+            void operator()(boost::system::error_code ec, message & msg, size_t bytes_transferred) {
+                run_hooks(ec, msg, bytes_transferred);
+                handler_(ec, msg, bytes_transferred);
+            }
+
+            // a receive hook may fail the receive
+            void run_hooks(boost::system::error_code & ec, message & msg, size_t & bytes_transferred) {
+                if (auto p = owner_.lock()) {
+                    unique_lock l{ *p };
+                    if (!ec && p->has_hook(socket_ext::receive_hook) && !p->on_receive(msg, ec))
+                        bytes_transferred = msg.size();
+                    if (p->has_hook(socket_ext::complete_hook))
+                        p->on_complete(read_op, ec, bytes_transferred);
+                }
+            }
+        };
+
+        /** \brief wraps a MessageLoopHandler as receive_hook_handler does a
+         *  MessageReadHandler
+         *  \remark The loop ends on any error passed to the handler, including
+         *  one raised by a receive hook, whatever the handler returns.
+         */
+        template<typename Handler>
+        struct receive_loop_hook_handler {
+            receive_hook_handler<Handler> hooked_;
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            using cancellation_slot_type = boost::asio::associated_cancellation_slot_t<Handler>;
+            cancellation_slot_type get_cancellation_slot() const noexcept {
+                return hooked_.get_cancellation_slot();
+            }
+#endif
+
+            bool operator()(boost::system::error_code ec, message & msg, size_t bytes_transferred) {
+                hooked_.run_hooks(ec, msg, bytes_transferred);
+                return hooked_.handler_(ec, msg, bytes_transferred) && !ec;
+            }
+        };
+
+        /** \brief wraps the WriteHandler of an async message send, running
+         *  extension sent hooks, should the message be sent, and completion
+         *  hooks before it
+         *  \remark msg_ is a copy of the message as the send hooks left it,
+         *  the send consumes the one queued.
+         */
+        template<typename Handler>
+        struct sent_hook_handler {
+            std::weak_ptr<per_descriptor_data> owner_;
+            message msg_;
+            flags_type flags_;
+            Handler handler_;
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            using cancellation_slot_type = boost::asio::associated_cancellation_slot_t<Handler>;
+            cancellation_slot_type get_cancellation_slot() const noexcept {
+                return boost::asio::get_associated_cancellation_slot(handler_);
+            }
+#endif
+
+            void operator()(boost::system::error_code const& ec, size_t bytes_transferred) {
+                if (auto p = owner_.lock()) {
+                    unique_lock l{ *p };
+                    if (!ec)
+                        p->on_sent(msg_, flags_);
+                    p->on_complete(write_op, ec, bytes_transferred);
+                }
+                handler_(ec, bytes_transferred);
+            }
+        };
+
+        /** \brief wraps a ReadHandler, ReadMoreHandler or WriteHandler, running
+         *  extension completion hooks before it
+         */
+        template<typename Handler>
+        struct complete_hook_handler {
+            std::weak_ptr<per_descriptor_data> owner_;
+            op_type op_;
+            Handler handler_;
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            using cancellation_slot_type = boost::asio::associated_cancellation_slot_t<Handler>;
+            cancellation_slot_type get_cancellation_slot() const noexcept {
+                return boost::asio::get_associated_cancellation_slot(handler_);
+            }
+#endif
+
+            void operator()(boost::system::error_code const& ec, size_t bytes_transferred) {
+                if (auto p = owner_.lock()) {
+                    unique_lock l{ *p };
+                    p->on_complete(op_, ec, bytes_transferred);
+                }
+                handler_(ec, bytes_transferred);
+            }
+
+            void operator()(boost::system::error_code const& ec, more_result_type result) {
+                if (auto p = owner_.lock()) {
+                    unique_lock l{ *p };
+                    p->on_complete(op_, ec, result.first);
+                }
+                handler_(ec, result);
+            }
+        };
+
         using reactor_op_ptr = std::unique_ptr<reactor_op>;
         template<typename T, typename... Args>
         void enqueue(implementation_type & impl, op_type o, Args&&... args) {
+            enqueue_until<T>(impl, o, no_deadline(), std::forward<Args>(args)...);
+        }
+
+        /** \brief as enqueue, but should the op still be queued at deadline
+         *  it completes with timed_out
+         */
+        template<typename T, typename... Args>
+        void enqueue_until(implementation_type & impl, op_type o, deadline_type deadline, Args&&... args) {
             reactor_op_ptr p{ new T(std::forward<Args>(args)...) };
-            boost::system::error_code ec = enqueue(impl, o, p);
+            boost::system::error_code ec = enqueue(impl, o, p, deadline);
             if (ec) {
                 BOOST_ASSERT_MSG(p, "op ptr");
                 p->ec_ = ec;
@@ -489,12 +1063,34 @@ namespace detail {
             }
         }
 
+        /** \brief queue a receive_loop_op, which the service requeues after
+         *  each message until its handler returns false
+         */
+        template<typename Handler>
+        void enqueue_receive_loop(implementation_type & impl, Handler && handler, flags_type flags) {
+            loop_requeue requeue{ this, impl, 0 };
+            {
+                unique_lock l{ *impl };
+                requeue.gen_ = impl->cancel_gen_;
+            }
+            using type = receive_loop_op<typename std::decay<Handler>::type, loop_requeue>;
+            enqueue<type>(impl, op_type::read_op, requeue, std::forward<Handler>(handler), flags);
+        }
+
+        // cancelled ops complete once the socket is unlocked, as hooked
+        // handlers lock it
         boost::system::error_code cancel(implementation_type & impl,
                                          boost::system::error_code & ec) {
-            unique_lock l{ *impl };
-            descriptors_.unregister_descriptor(impl);
-            cancel_ops(impl);
-            return impl->cancel_stream_descriptor(ec);
+            op_queue_type ops;
+            {
+                unique_lock l{ *impl };
+                descriptors_.unregister_descriptor(impl);
+                impl->cancel_ops(reactor_op::canceled(), ops);
+                impl->cancel_stream_descriptor(ec);
+            }
+            while (!ops.empty())
+                ops.pop_front_and_dispose(reactor_op::do_complete);
+            return ec;
         }
 
         std::string monitor(implementation_type & impl, int events,
@@ -509,8 +1105,59 @@ namespace detail {
         }
 
     private:
+        template<typename Option>
+        boost::system::error_code set_option_locked(implementation_type & impl,
+                                                    Option const& option,
+                                                    boost::system::error_code & ec) {
+            switch (option.name()) {
+            case allow_speculative::static_name::value :
+                    ec = boost::system::error_code();
+                    impl->allow_speculative_ = option.data() ? *static_cast<bool const*>(option.data())
+                                                             : false;
+                break;
+            case busy_poll_spins::static_name::value :
+                ec = boost::system::error_code();
+                impl->busy_poll_spins_ = std::max(0, *static_cast<int const*>(option.data()));
+                break;
+            case busy_poll_usec::static_name::value :
+                ec = boost::system::error_code();
+                impl->busy_poll_usec_ = std::max(0, *static_cast<int const*>(option.data()));
+                break;
+            case busy_poll_counters::static_name::value :
+                // setting resets the counters
+                ec = boost::system::error_code();
+                impl->busy_poll_stats_ = busy_poll_stats();
+                break;
+            default:
+                // extensions report options they do not handle as not_supported
+                for (auto& ext : impl->exts_) {
+                    ec = boost::system::error_code();
+                    ext.second.set_option(option, ec);
+                    if (ec.value() != boost::system::errc::not_supported)
+                        return ec;
+                }
+                ec = boost::system::error_code();
+                socket_ops::set_option(impl->socket_, option, ec);
+            }
+            return ec;
+        }
+
         context_type ctx_;
 
+        // sends a message which has been through the send hooks, running the
+        // sent hooks once it has gone; zmq_msg_send consumes the message, so
+        // they are given a copy
+        static size_t send_hooked(implementation_type & impl, message const& msg, flags_type flags,
+                                  unsigned hooks, boost::system::error_code & ec) {
+            if (!(hooks & socket_ext::sent_hook))
+                return socket_ops::send(msg, impl->socket_, flags, ec);
+            message sent(msg);
+            auto r = socket_ops::send(msg, impl->socket_, flags, ec);
+            if (!ec)
+                impl->on_sent(sent, flags);
+            return r;
+        }
+
         bool is_shutdown(implementation_type & impl, op_type o, boost::system::error_code & ec) {
             if (is_shutdown(o, impl->shutdown_)) {
                 ec = make_error_code(boost::system::errc::operation_not_permitted);
@@ -524,6 +1171,86 @@ namespace detail {
                                             : what >= shutdown_type::receive;
         }
 
+        // thread-safe sockets need no lock around the libzmq call itself, the
+        // lock is only taken if async operations may be waiting on the socket.
+        // Message hooks touch extension state, so a socket with any takes the
+        // locked path. op is passed the mask of hooks it may run
+        template<typename Operation>
+        size_t sync_op(implementation_type & impl, op_type o,
+                       boost::system::error_code & ec, Operation && op) {
+            auto hooks = impl->hooks_.load(std::memory_order_relaxed);
+            if (impl->thread_safe_ && !(hooks & (socket_ext::send_hook | socket_ext::receive_hook |
+                                                 socket_ext::sent_hook))) {
+                if (is_shutdown(impl, o, ec))
+                    return 0;
+                auto r = op(0u);
+                if (impl->scheduled_ || impl->has_hook(socket_ext::complete_hook)) {
+                    unique_lock l{ *impl };
+                    if (impl->has_hook(socket_ext::complete_hook))
+                        impl->on_complete(o, ec, r);
+                    check_missed_events(impl);
+                }
+                return r;
+            }
+            unique_lock l{ *impl };
+            if (is_shutdown(impl, o, ec))
+                return 0;
+            auto r = op(impl->hooks_.load(std::memory_order_relaxed));
+            if (impl->has_hook(socket_ext::complete_hook))
+                impl->on_complete(o, ec, r);
+            check_missed_events(impl);
+            return r;
+        }
+
+        // called with impl locked after ops were removed other than by the
+        // reactor, an idle socket should not hold work on the io_service
+        void disarm(implementation_type & impl) {
+            if (!impl->scheduled_ || impl->events_mask() || impl->polled_)
+                return;
+            impl->scheduled_ = false;
+            ++impl->reactor_gen_;
+            descriptors_.unregister_descriptor(impl);
+            boost::system::error_code ec;
+            impl->cancel_stream_descriptor(ec);
+        }
+
+        struct loop_requeue {
+            socket_service * service_;
+            std::weak_ptr<per_descriptor_data> owner_;
+            unsigned gen_; // owner's cancel_gen_ when the loop started
+
+            boost::system::error_code operator()(reactor_op & op) const {
+                return service_->requeue(owner_, gen_, op);
+            }
+        };
+
+        // puts a completed receive_loop_op back on its socket's read queue,
+        // unless the socket was cancelled or shut down while it was out
+        boost::system::error_code requeue(std::weak_ptr<per_descriptor_data> const& owner,
+                                          unsigned gen, reactor_op & op) {
+            auto impl = owner.lock();
+            if (!impl)
+                return reactor_op::canceled();
+            unique_lock l{ *impl };
+            boost::system::error_code ec;
+            if (impl->cancel_gen_ != gen)
+                return ec = reactor_op::canceled();
+            if (is_shutdown(impl, op_type::read_op, ec))
+                return ec;
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            if (op.slot_.is_connected())
+                op.slot_.template emplace<slot_cancellation>(*this, impl, op_type::read_op, &op);
+#endif
+            impl->op_queue_[op_type::read_op].push_back(op);
+            if (!impl->scheduled_) {
+                impl->scheduled_ = true;
+                reactor_handler::schedule(descriptors_, get_poller(), impl);
+            } else {
+                check_missed_events(impl);
+            }
+            return ec;
+        }
+
         static void cancel_ops(implementation_type & impl) {
             op_queue_type ops;
             impl->cancel_ops(reactor_op::canceled(), ops);
@@ -604,11 +1331,13 @@ namespace detail {
         struct reactor_handler {
             descriptor_map & descriptors_;
             weak_descriptor_ptr per_descriptor_data_;
+            unsigned gen_;
 
             reactor_handler(descriptor_map & descriptors,
                             implementation_type const& per_descriptor_data)
                 : descriptors_(descriptors)
                 , per_descriptor_data_(per_descriptor_data)
+                , gen_(per_descriptor_data->reactor_gen_)
             { }
 
             void operator()(boost::system::error_code ec, size_t) const {
@@ -616,46 +1345,135 @@ namespace detail {
                 if (!p)
                     return;
 
-                op_queue_type ops;
-                {
-                    unique_lock l{ *p };
+                bool spin;
+                do {
+                    op_queue_type ops;
+                    spin = false;
+                    {
+                        unique_lock l{ *p };
+                        // the socket was disarmed since this handler was scheduled
+                        if (gen_ != p->reactor_gen_)
+                            return;
+
+                        if (!ec)
+                            p->scheduled_ = p->perform_ops(ops, ec);
+                        if (ec) {
+                            p->scheduled_ = false;
+                            p->cancel_ops(ec, ops);
+                        }
 
-                    if (!ec)
-                        p->scheduled_ = p->perform_ops(ops, ec);
-                    if (ec) {
-                        p->scheduled_ = false;
-                        p->cancel_ops(ec, ops);
+                        if (p->scheduled_) {
+                            // busy polling defers arming until the spin budget is spent
+                            if (p->busy_poll_spins_ || p->busy_poll_usec_)
+                                spin = true;
+                            else if (!p->polled_) // polled sockets stay registered with the poller
+                                p->sd_->async_read_some(boost::asio::null_buffers(), *this);
+                        } else {
+                            descriptors_.unregister_descriptor(p);
+                        }
                     }
+                    while (!ops.empty())
+                        ops.pop_front_and_dispose(reactor_op::do_complete);
+                } while (spin && busy_poll(p, ec));
+            }
 
-                    if (p->scheduled_)
-                        p->sd_->async_read_some(boost::asio::null_buffers(), *this);
-                    else
-                        descriptors_.unregister_descriptor(p);
+            // spin on ZMQ_EVENTS, returns true if the socket became ready (or
+            // failed) within budget, otherwise arms the reactor and returns false
+            bool busy_poll(implementation_type & p, boost::system::error_code & ec) const {
+                using clock_type = std::chrono::steady_clock;
+                clock_type::time_point deadline;
+                int spins;
+                {
+                    unique_lock l{ *p };
+                    spins = p->busy_poll_spins_;
+                    if (p->busy_poll_usec_)
+                        deadline = clock_type::now() + std::chrono::microseconds(p->busy_poll_usec_);
+                    ++p->busy_poll_stats_.polls;
+                }
+                for (auto i = 0; ; ++i) {
+                    {
+                        unique_lock l{ *p };
+                        if (!p->scheduled_) {
+                            ++p->busy_poll_stats_.misses;
+                            return false;
+                        }
+                        ++p->busy_poll_stats_.probes;
+                        auto evs = socket_ops::get_events(p->socket_, ec) & p->events_mask();
+                        if (evs || ec) {
+                            ++p->busy_poll_stats_.hits;
+                            return true;
+                        }
+                        // whichever of the configured budgets runs out first;
+                        // both may have been cleared since the handler chose
+                        // to spin, leaving none to spend
+                        if ((spins && i + 1 >= spins)
+                                || (deadline != clock_type::time_point() && clock_type::now() >= deadline)
+                                || (!spins && deadline == clock_type::time_point())) {
+                            ++p->busy_poll_stats_.misses;
+                            if (!p->polled_)
+                                p->sd_->async_read_some(boost::asio::null_buffers(), *this);
+                            return false;
+                        }
+                    }
                 }
-                while (!ops.empty())
-                    ops.pop_front_and_dispose(reactor_op::do_complete);
             }
 
-            static void schedule(descriptor_map & descriptors, implementation_type & impl) {
+            template<typename Poller>
+            static void schedule(descriptor_map & descriptors, Poller * poller,
+                                 implementation_type & impl) {
                 reactor_handler handler(descriptors, impl);
                 descriptors.register_descriptor(impl);
 
+                if (poller && !impl->polled_) {
+                    // on failure fall back to an individual registration
+                    boost::system::error_code pec;
+                    impl->polled_ = poller->add(impl->sd_->native_handle(), impl, pec);
+                }
+
                 boost::system::error_code ec;
                 auto evs = socket_ops::get_events(impl->socket_, ec) & impl->events_mask();
 
-                if (evs || ec) {
+                // busy polling sockets spin in the handler before arming the reactor
+                if (evs || ec || impl->busy_poll_spins_ || impl->busy_poll_usec_) {
 #ifdef AZMQ_DETAIL_USE_IO_SERVICE
   		    impl->sd_->get_io_service().post([handler, ec] { handler(ec, 0); });
 #else
 		    boost::asio::post(impl->sd_->get_executor(), [handler, ec] { handler(ec, 0); });
 #endif
-                } else {
+                } else if (!impl->polled_) {
                     impl->sd_->async_read_some(boost::asio::null_buffers(),
                                                 std::move(handler));
                 }
             }
         };
 
+        // invoked by the poller for each ready socket, in a batch
+        struct poll_handler {
+            descriptor_map & descriptors_;
+
+            void operator()(implementation_type & impl) const {
+                {
+                    unique_lock l{ *impl };
+                    if (!impl->scheduled_)
+                        return;
+                }
+                reactor_handler(descriptors_, impl)(boost::system::error_code(), 0);
+            }
+        };
+
+#ifdef AZMQ_DETAIL_HAS_SOCKET_POLLER
+        using poller_type = socket_poller<per_descriptor_data, poll_handler>;
+        using poller_ptr = std::shared_ptr<poller_type>;
+        poller_ptr poller_;
+
+        poller_type * get_poller() const { return std::atomic_load(&poller_).get(); }
+#else
+        struct null_poller {
+            bool add(int, implementation_type const&, boost::system::error_code &) { return false; }
+        };
+        null_poller * get_poller() const { return nullptr; }
+#endif
+
         struct deferred_completion {
             weak_descriptor_ptr owner_;
             reactor_op *op_;
@@ -679,10 +1497,59 @@ namespace detail {
         };
 
         descriptor_map descriptors_;
+        deadline_timers deadlines_;
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+        // installed in the slot of a queued op's handler, cancels just that op
+        struct slot_cancellation {
+            socket_service & service_;
+            weak_descriptor_ptr owner_;
+            op_type o_;
+            reactor_op * op_;
+
+            slot_cancellation(socket_service & service, implementation_type const& owner,
+                              op_type o, reactor_op * op)
+                : service_(service)
+                , owner_(owner)
+                , o_(o)
+                , op_(op)
+            { }
+
+            // a queued op has not touched the socket, so it honours every
+            // type of cancellation
+            void operator()(boost::asio::cancellation_type_t type) {
+                if (type == boost::asio::cancellation_type::none)
+                    return;
+                // cancelling the op clears the slot, destroying this handler
+                auto & service = service_;
+                auto p = owner_.lock();
+                auto o = o_;
+                auto op = op_;
+                if (!p)
+                    return;
+                op_queue_type ops;
+                {
+                    unique_lock l{ *p };
+                    // the op may have left its queue, to be performed or
+                    // cancelled, while emit() waited for the lock
+                    if (!op->member_hook_.is_linked())
+                        return;
+                    p->cancel_op(o, op, reactor_op::canceled(), ops);
+                    service.disarm(p);
+                }
+                // complete as a cancelled op would, never from within emit()
+                ops.pop_front_and_dispose([&](reactor_op * op) {
+                    boost::asio::post(service.get_io_context(), [op] { reactor_op::do_complete(op); });
+                });
+            }
+        };
+#endif
 
         boost::system::error_code enqueue(implementation_type & impl,
-                                        op_type o, reactor_op_ptr & op) {
+                                        op_type o, reactor_op_ptr & op,
+                                        deadline_type deadline) {
             unique_lock l{ *impl };
+            op->binding_ = impl->binding_.lock();
             boost::system::error_code ec;
             if (is_shutdown(impl, o, ec))
                 return ec;
@@ -703,11 +1570,17 @@ namespace detail {
                     }
                 }
             }
+            if (deadline != no_deadline())
+                deadlines_.add(impl, o, *op, deadline);
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+            if (op->slot_.is_connected())
+                op->slot_.template emplace<slot_cancellation>(*this, impl, o, op.get());
+#endif
             impl->op_queue_[o].push_back(*op.release());
 
             if (!impl->scheduled_) {
                 impl->scheduled_ = true;
-                reactor_handler::schedule(descriptors_, impl);
+                reactor_handler::schedule(descriptors_, get_poller(), impl);
             } else {
                 check_missed_events(impl);
             }
@@ -721,6 +1594,12 @@ namespace detail {
         return access.service().associate_ext(access.implementation(), std::forward<Extension>(ext));
     }
 
+    template<typename T>
+    static void bind_handlers(T & that, std::weak_ptr<handler_binding> binding) {
+        socket_service::core_access access{ that };
+        access.service().bind_handlers(access.implementation(), std::move(binding));
+    }
+
     template<typename T, typename Extension>
     static bool remove_ext(T & that) {
         socket_service::core_access access{ that };
@@ -0,0 +1,190 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_SPILL_LOG_HPP_
+#define AZMQ_DETAIL_SPILL_LOG_HPP_
+
+#include "../error.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace azmq {
+namespace detail {
+    /** \brief FIFO of frames stored in memory mapped segment files
+     *  \remark Records are a uint64_t size followed by the frame, padded to a
+     *  multiple of 8 bytes. Segments are created in the directory as the
+     *  tail fills, and unlinked once the head has been read; only the head and
+     *  tail segments are mapped at any time. The log is transient, all of its
+     *  segments are removed when it is destroyed.
+     */
+    class spill_log {
+    public:
+        spill_log(std::string directory, size_t segment_size)
+            : directory_(std::move(directory))
+            , segment_size_(std::max(segment_size, static_cast<size_t>(4096)))
+        { }
+
+        spill_log(spill_log const&) = delete;
+        spill_log & operator=(spill_log const&) = delete;
+
+        ~spill_log() {
+            for (auto & s : segments_)
+                close(s, true);
+        }
+
+        bool empty() const { return !count_; }
+        size_t size() const { return count_; }
+        size_t bytes() const { return bytes_; }
+        size_t segments() const { return segments_.size(); }
+
+        boost::system::error_code push(boost::asio::const_buffer data, boost::system::error_code & ec) {
+            auto size = boost::asio::buffer_size(data);
+            auto need = sizeof(uint64_t) + padded(size);
+            if (segments_.empty() || segments_.back().write_pos + need > segments_.back().capacity) {
+                // an empty log's only segment is too small, replace it
+                if (!count_)
+                    clear();
+                segment s;
+                s.path = directory_ + "/" + segment_name(next_id_++);
+                s.capacity = std::max(segment_size_, need);
+                if (open(s, O_RDWR | O_CREAT | O_TRUNC, ec))
+                    return ec;
+                // a full tail is not read from until it becomes the head
+                if (segments_.size() > 1)
+                    close(segments_.back(), false);
+                segments_.push_back(std::move(s));
+            }
+            auto & tail = segments_.back();
+            uint64_t len = size;
+            std::memcpy(tail.base + tail.write_pos, &len, sizeof(len));
+            boost::asio::buffer_copy(boost::asio::buffer(tail.base + tail.write_pos + sizeof(len), size), data);
+            tail.write_pos += need;
+            ++count_;
+            bytes_ += size;
+            return ec;
+        }
+
+        // discards every frame and removes the segments
+        void clear() {
+            for (auto & s : segments_)
+                close(s, true);
+            segments_.clear();
+            count_ = 0;
+            bytes_ = 0;
+        }
+
+        // the oldest frame, valid until pop()
+        boost::asio::const_buffer front() const {
+            auto const& head = segments_.front();
+            uint64_t len;
+            std::memcpy(&len, head.base + head.read_pos, sizeof(len));
+            return boost::asio::buffer(head.base + head.read_pos + sizeof(len), static_cast<size_t>(len));
+        }
+
+        // on error the next segment could not be mapped, and the log must be
+        // cleared before further use
+        boost::system::error_code pop(boost::system::error_code & ec) {
+            auto & head = segments_.front();
+            uint64_t len;
+            std::memcpy(&len, head.base + head.read_pos, sizeof(len));
+            head.read_pos += sizeof(len) + padded(static_cast<size_t>(len));
+            --count_;
+            bytes_ -= static_cast<size_t>(len);
+            if (head.read_pos < head.write_pos)
+                return ec;
+            if (segments_.size() == 1) {
+                // reuse the only segment rather than replacing it
+                head.read_pos = head.write_pos = 0;
+                return ec;
+            }
+            close(head, true);
+            segments_.pop_front();
+            auto & next = segments_.front();
+            if (!next.base)
+                open(next, O_RDWR, ec);
+            return ec;
+        }
+
+    private:
+        struct segment {
+            std::string path;
+            int fd = -1;
+            char * base = nullptr;
+            size_t capacity = 0;
+            size_t write_pos = 0;
+            size_t read_pos = 0;
+        };
+
+        std::string const directory_;
+        size_t const segment_size_;
+        std::deque<segment> segments_;
+        uint64_t next_id_ = 0;
+        size_t count_ = 0;
+        size_t bytes_ = 0;
+
+        static size_t padded(size_t n) {
+            return (n + 7) & ~static_cast<size_t>(7);
+        }
+
+        std::string segment_name(uint64_t id) const {
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "azmq-spill-%d-%p-%08llu.seg", static_cast<int>(::getpid()),
+                          static_cast<void const*>(this), static_cast<unsigned long long>(id));
+            return buf;
+        }
+
+        static boost::system::error_code open(segment & s, int flags, boost::system::error_code & ec) {
+            s.fd = ::open(s.path.c_str(), flags, 0600);
+            if (s.fd < 0)
+                return ec = make_error_code();
+            if ((flags & O_CREAT) && ::ftruncate(s.fd, static_cast<off_t>(s.capacity)) < 0) {
+                ec = make_error_code();
+                ::close(s.fd);
+                ::unlink(s.path.c_str());
+                s.fd = -1;
+                return ec;
+            }
+            auto p = ::mmap(nullptr, s.capacity, PROT_READ | PROT_WRITE, MAP_SHARED, s.fd, 0);
+            if (p == MAP_FAILED) {
+                ec = make_error_code();
+                ::close(s.fd);
+                if (flags & O_CREAT)
+                    ::unlink(s.path.c_str());
+                s.fd = -1;
+                return ec;
+            }
+            s.base = static_cast<char*>(p);
+            return ec;
+        }
+
+        static void close(segment & s, bool remove) {
+            if (s.base)
+                ::munmap(s.base, s.capacity);
+            if (s.fd >= 0)
+                ::close(s.fd);
+            s.base = nullptr;
+            s.fd = -1;
+            if (remove)
+                ::unlink(s.path.c_str());
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_SPILL_LOG_HPP_
@@ -0,0 +1,110 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_SPSC_QUEUE_HPP_
+#define AZMQ_DETAIL_SPSC_QUEUE_HPP_
+
+#include <boost/assert.hpp>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+namespace azmq {
+namespace detail {
+    /** \brief bounded, lock-free, single producer/single consumer queue
+     *  \remark capacity is rounded up to the next power of two. At most one
+     *  thread at a time may push, and at most one thread at a time may pop.
+     */
+    template<typename T>
+    class spsc_queue {
+    public:
+        explicit spsc_queue(size_t capacity)
+            : mask_(round_up(capacity) - 1)
+            , slots_(new storage_type[mask_ + 1])
+            , head_(0)
+            , cached_tail_(0)
+            , tail_(0)
+            , cached_head_(0)
+        { }
+
+        ~spsc_queue() {
+            T v;
+            while (try_pop(v)) { }
+        }
+
+        spsc_queue(spsc_queue const&) = delete;
+        spsc_queue & operator=(spsc_queue const&) = delete;
+
+        size_t capacity() const { return mask_ + 1; }
+
+        bool try_push(T && v) {
+            auto t = tail_.load(std::memory_order_relaxed);
+            if (t - cached_head_ > mask_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (t - cached_head_ > mask_)
+                    return false;
+            }
+            new (&slots_[t & mask_]) T(std::move(v));
+            tail_.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T & v) {
+            auto h = head_.load(std::memory_order_relaxed);
+            if (h == cached_tail_) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (h == cached_tail_)
+                    return false;
+            }
+            auto p = reinterpret_cast<T*>(&slots_[h & mask_]);
+            v = std::move(*p);
+            p->~T();
+            head_.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        // may be called by either side, the answer is only a snapshot
+        bool empty() const {
+            return head_.load(std::memory_order_acquire)
+                    == tail_.load(std::memory_order_acquire);
+        }
+
+        bool full() const {
+            return tail_.load(std::memory_order_acquire)
+                    - head_.load(std::memory_order_acquire) > mask_;
+        }
+
+    private:
+        using storage_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+        enum { cache_line_size = 64 };
+
+        static size_t round_up(size_t n) {
+            BOOST_ASSERT_MSG(n, "capacity must be non-zero");
+            size_t res = 1;
+            while (res < n) res <<= 1;
+            return res;
+        }
+
+        size_t const mask_;
+        std::unique_ptr<storage_type[]> const slots_;
+
+        // consumer side
+        alignas(cache_line_size) std::atomic<size_t> head_;
+        size_t cached_tail_;
+
+        // producer side
+        alignas(cache_line_size) std::atomic<size_t> tail_;
+        size_t cached_head_;
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_SPSC_QUEUE_HPP_
@@ -0,0 +1,169 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_STREAM_OPS_HPP_
+#define AZMQ_DETAIL_STREAM_OPS_HPP_
+
+#include "../error.hpp"
+#include "../message.hpp"
+#include "../socket.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace azmq {
+namespace detail {
+    struct stream_ops {
+        // each chunk is a two part message, a header followed by the data,
+        // the stream ends with a header flagged last and an empty data part
+        struct header {
+            uint32_t magic = magic_value;
+            uint32_t flags = 0;
+            uint64_t seq = 0;
+        };
+
+        enum : uint32_t {
+            magic_value = 0x41535452u,  // "ASTR"
+            last_chunk = 1
+        };
+
+        static message encode(uint64_t seq, bool last) {
+            header h;
+            h.seq = seq;
+            h.flags = last ? last_chunk : 0;
+            return message(boost::asio::buffer(&h, sizeof(h)));
+        }
+
+        static bool decode(message const& msg, header & h) {
+            if (msg.size() != sizeof(h) || !msg.more())
+                return false;
+            std::memcpy(&h, boost::asio::buffer_cast<void const*>(msg.cbuffer()), sizeof(h));
+            return h.magic == magic_value;
+        }
+    };
+
+    template<typename Source, typename Handler>
+    class send_stream_op
+        : public std::enable_shared_from_this<send_stream_op<Source, Handler>> {
+    public:
+        send_stream_op(socket & s, Source source, Handler handler,
+                       size_t chunk_size, size_t window)
+            : socket_(s)
+            , source_(std::move(source))
+            , handler_(std::move(handler))
+            , chunk_size_(chunk_size ? chunk_size : 1)
+            , window_(window ? window : 1)
+        { }
+
+        void pump() {
+            while (!done_ && !ec_ && in_flight_ < window_) {
+                message chunk(chunk_size_);
+                auto n = source_(chunk.buffer());
+                done_ = n == 0;
+                if (n < chunk_size_)
+                    chunk = message(boost::asio::buffer(chunk.cbuffer(), n));
+                total_ += n;
+                send(std::move(chunk));
+            }
+            if (!in_flight_ && (done_ || ec_)) {
+                auto ec = ec_;
+                auto total = total_;
+                handler_(ec, total);
+            }
+        }
+
+    private:
+        socket & socket_;
+        Source source_;
+        Handler handler_;
+        size_t const chunk_size_;
+        size_t const window_;
+        size_t in_flight_ = 0;
+        uint64_t seq_ = 0;
+        size_t total_ = 0;
+        bool done_ = false;
+        boost::system::error_code ec_;
+
+        void send(message chunk) {
+            auto self = this->shared_from_this();
+            ++in_flight_;
+            // ops on a socket complete in order, so the parts stay together
+            socket_.async_send(stream_ops::encode(seq_++, done_),
+                               [self](boost::system::error_code const& ec, size_t) {
+                                   if (ec && !self->ec_)
+                                       self->ec_ = ec;
+                               }, ZMQ_SNDMORE);
+            socket_.async_send(std::move(chunk), [self](boost::system::error_code const& ec, size_t) {
+                if (ec && !self->ec_)
+                    self->ec_ = ec;
+                --self->in_flight_;
+                self->pump();
+            });
+        }
+    };
+
+    template<typename Sink, typename Handler>
+    class receive_stream_op
+        : public std::enable_shared_from_this<receive_stream_op<Sink, Handler>> {
+    public:
+        receive_stream_op(socket & s, Sink sink, Handler handler)
+            : socket_(s)
+            , sink_(std::move(sink))
+            , handler_(std::move(handler))
+        { }
+
+        void start() {
+            auto self = this->shared_from_this();
+            socket_.async_receive([self](boost::system::error_code const& ec, message & msg, size_t) {
+                self->on_header(ec, msg);
+            });
+        }
+
+    private:
+        socket & socket_;
+        Sink sink_;
+        Handler handler_;
+        message data_;
+        uint64_t seq_ = 0;
+        size_t total_ = 0;
+
+        void on_header(boost::system::error_code ec, message & msg) {
+            stream_ops::header h;
+            if (!ec) {
+                if (!stream_ops::decode(msg, h) || h.seq != seq_) {
+                    ec = make_error_code(boost::system::errc::protocol_error);
+                    socket_.flush(ec);
+                    ec = make_error_code(boost::system::errc::protocol_error);
+                } else {
+                    socket_.receive(data_, 0, ec);
+                }
+            }
+            if (ec) {
+                handler_(ec, total_);
+                return;
+            }
+            ++seq_;
+            total_ += data_.size();
+            if (data_.size())
+                sink_(data_.cbuffer());
+            if (h.flags & stream_ops::last_chunk) {
+                handler_(ec, total_);
+                return;
+            }
+            start();
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_STREAM_OPS_HPP_
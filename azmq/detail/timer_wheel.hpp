@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_TIMER_WHEEL_HPP_
+#define AZMQ_DETAIL_TIMER_WHEEL_HPP_
+
+#include <boost/intrusive/list.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace azmq {
+namespace detail {
+    /** \brief hashed timing wheel of intrusive entries
+     *  \remark Entries are hashed into slots by the tick they expire on, so
+     *  adding and removing an entry is O(1) however many are outstanding, and
+     *  advancing visits only the slots of ticks which have passed. An entry
+     *  more than one rotation away stays in its slot and is skipped until its
+     *  tick comes around. Expiry is rounded up to the next tick, entries never
+     *  expire early. Not thread safe.
+     */
+    class timer_wheel {
+    public:
+        using clock_type = std::chrono::steady_clock;
+        using duration = clock_type::duration;
+        using time_point = clock_type::time_point;
+
+        struct entry {
+            boost::intrusive::list_member_hook<> hook_;
+            uint64_t tick_ = 0;
+        };
+
+        explicit timer_wheel(duration resolution = std::chrono::milliseconds(1),
+                             size_t slots = 4096)
+            : resolution_(std::max(resolution, duration(1)))
+            , epoch_(clock_type::now())
+            , slots_(power_of_two(slots))
+        { }
+
+        timer_wheel(timer_wheel const&) = delete;
+        timer_wheel & operator=(timer_wheel const&) = delete;
+
+        bool empty() const { return !size_; }
+        size_t size() const { return size_; }
+        duration resolution() const { return resolution_; }
+
+        void add(entry & e, time_point expiry) {
+            e.tick_ = std::max(tick(expiry, true), current_ + 1);
+            slots_[e.tick_ & (slots_.size() - 1)].push_back(e);
+            ++size_;
+        }
+
+        void remove(entry & e) {
+            slots_[e.tick_ & (slots_.size() - 1)].erase(list_type::s_iterator_to(e));
+            --size_;
+        }
+
+        // when an entry is due
+        time_point due(entry const& e) const { return at(e.tick_); }
+
+        // when the earliest entry is due, time_point::max() if there is none
+        time_point next_expiry() const {
+            if (!size_)
+                return time_point::max();
+            // every entry due within a rotation sits in the slot of its own tick
+            auto earliest = UINT64_MAX;
+            for (auto t = current_ + 1; t != current_ + 1 + slots_.size(); ++t) {
+                for (auto const& e : slots_[t & (slots_.size() - 1)]) {
+                    if (e.tick_ == t)
+                        return at(t);
+                    earliest = std::min(earliest, e.tick_);
+                }
+            }
+            return at(earliest);
+        }
+
+        // unlinks each entry which has expired by now and calls f(e) on it,
+        // an entry for which f returns false is retried on the next tick
+        template<typename Function>
+        void advance(time_point now, Function && f) {
+            auto to = tick(now, false);
+            if (to <= current_)
+                return;
+            list_type expired;
+            auto n = std::min(to - current_, static_cast<uint64_t>(slots_.size()));
+            for (uint64_t t = current_ + 1; t != current_ + 1 + n; ++t) {
+                auto & slot = slots_[t & (slots_.size() - 1)];
+                for (auto it = slot.begin(); it != slot.end();) {
+                    auto & e = *it++;
+                    if (e.tick_ <= to) {
+                        slot.erase(list_type::s_iterator_to(e));
+                        expired.push_back(e);
+                        --size_;
+                    }
+                }
+            }
+            current_ = to;
+
+            list_type retry;
+            while (!expired.empty()) {
+                auto & e = expired.front();
+                expired.pop_front();
+                if (!f(e))
+                    retry.push_back(e);
+            }
+            while (!retry.empty()) {
+                auto & e = retry.front();
+                retry.pop_front();
+                e.tick_ = current_ + 1;
+                slots_[e.tick_ & (slots_.size() - 1)].push_back(e);
+                ++size_;
+            }
+        }
+
+    private:
+        using list_type = boost::intrusive::list<entry,
+                                boost::intrusive::member_hook<
+                                    entry,
+                                    boost::intrusive::list_member_hook<>,
+                                    &entry::hook_
+                                >>;
+
+        duration const resolution_;
+        time_point const epoch_;
+        std::vector<list_type> slots_;
+        uint64_t current_ = 0;  // last tick advanced over
+        size_t size_ = 0;
+
+        time_point at(uint64_t tick) const {
+            if (tick == UINT64_MAX)
+                return time_point::max();
+            return epoch_ + resolution_ * static_cast<duration::rep>(tick);
+        }
+
+        uint64_t tick(time_point t, bool round_up) const {
+            if (t <= epoch_)
+                return 0;
+            if (t == time_point::max())
+                return UINT64_MAX;
+            auto d = t - epoch_;
+            auto n = static_cast<uint64_t>(d / resolution_);
+            return (round_up && d % resolution_ != duration::zero()) ? n + 1 : n;
+        }
+
+        static size_t power_of_two(size_t n) {
+            size_t res = 1;
+            while (res < n)
+                res <<= 1;
+            return res;
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_TIMER_WHEEL_HPP_
@@ -0,0 +1,121 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_TOPIC_TRIE_HPP_
+#define AZMQ_DETAIL_TOPIC_TRIE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace azmq {
+namespace detail {
+    /** \brief byte-wise prefix trie mapping topic prefixes to values
+     *  \remark Nodes live in one vector and refer to each other by index. A
+     *  node's child labels are packed into a contiguous byte string alongside a
+     *  parallel array of child indices, so selecting the next edge is a single
+     *  memchr() over at most 256 bytes, which the C library vectorizes.
+     *  \remark Lookup walks the topic once and yields the value of the longest
+     *  prefix present, independent of the number of prefixes held.
+     */
+    template<typename T>
+    class topic_trie {
+    public:
+        topic_trie() : nodes_(1) { }
+
+        // returns true if the prefix was not already present
+        bool insert(std::string_view prefix, T value) {
+            auto n = 0u;
+            for (auto c : prefix) {
+                auto next = child(n, c);
+                if (next == npos) {
+                    next = static_cast<uint32_t>(nodes_.size());
+                    nodes_.emplace_back();
+                    nodes_[n].labels_.push_back(c);
+                    nodes_[n].children_.push_back(next);
+                }
+                n = next;
+            }
+            auto & node = nodes_[n];
+            auto added = !node.has_value_;
+            node.value_ = std::move(value);
+            node.has_value_ = true;
+            size_ += added;
+            return added;
+        }
+
+        // returns true if the prefix was present, interior nodes are kept for
+        // reuse
+        bool erase(std::string_view prefix) {
+            auto n = find_node(prefix);
+            if (n == npos || !nodes_[n].has_value_)
+                return false;
+            nodes_[n].has_value_ = false;
+            nodes_[n].value_ = T();
+            --size_;
+            return true;
+        }
+
+        // the value for exactly this prefix, nullptr if absent
+        T * find(std::string_view prefix) {
+            auto n = find_node(prefix);
+            return n == npos || !nodes_[n].has_value_ ? nullptr : &nodes_[n].value_;
+        }
+
+        // the value of the longest prefix of topic present, nullptr if none
+        T * match(void const* topic, size_t size) {
+            auto p = static_cast<char const*>(topic);
+            T * res = nodes_[0].has_value_ ? &nodes_[0].value_ : nullptr;
+            auto n = 0u;
+            for (size_t i = 0; i != size; ++i) {
+                n = child(n, p[i]);
+                if (n == npos)
+                    break;
+                if (nodes_[n].has_value_)
+                    res = &nodes_[n].value_;
+            }
+            return res;
+        }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+    private:
+        static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+        struct node {
+            std::string labels_;
+            std::vector<uint32_t> children_;
+            T value_ = T();
+            bool has_value_ = false;
+        };
+
+        std::vector<node> nodes_;
+        size_t size_ = 0;
+
+        uint32_t child(uint32_t n, char c) const {
+            auto const& l = nodes_[n].labels_;
+            auto p = static_cast<char const*>(std::memchr(l.data(), c, l.size()));
+            return p ? nodes_[n].children_[p - l.data()] : npos;
+        }
+
+        uint32_t find_node(std::string_view prefix) const {
+            auto n = 0u;
+            for (auto c : prefix) {
+                n = child(n, c);
+                if (n == npos)
+                    break;
+            }
+            return n;
+        }
+    };
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_TOPIC_TRIE_HPP_
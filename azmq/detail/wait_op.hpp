@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_DETAIL_WAIT_OP_HPP_
+#define AZMQ_DETAIL_WAIT_OP_HPP_
+
+#include "../error.hpp"
+#include "socket_ops.hpp"
+#include "reactor_op.hpp"
+
+#include <zmq.h>
+
+namespace azmq {
+namespace detail {
+class wait_op_base : public reactor_op {
+public:
+    wait_op_base(int events,
+                 complete_func_type complete_func)
+        : reactor_op(&wait_op_base::do_perform, complete_func)
+        , events_(events)
+        { }
+
+    // transfers nothing, completes once the socket reports the event; the
+    // socket is checked here as a speculative perform is not preceded by a
+    // readiness test
+    static bool do_perform(reactor_op* base, socket_type & socket) {
+        auto o = static_cast<wait_op_base*>(base);
+        o->ec_ = boost::system::error_code();
+        auto evs = socket_ops::get_events(socket, o->ec_);
+        return o->ec_ || (evs & o->events_);
+    }
+
+private:
+    int events_;
+};
+
+template<typename Handler>
+class wait_op : public wait_op_base {
+public:
+    wait_op(int events, Handler handler)
+        : wait_op_base(events, &wait_op::do_complete)
+        , handler_(std::move(handler))
+    {
+        this->bind_slot(handler_);
+    }
+
+    static void do_complete(reactor_op* base,
+                            const boost::system::error_code &,
+                            size_t) {
+        auto o = static_cast<wait_op*>(base);
+        auto h = std::move(o->handler_);
+        auto ec = o->ec_;
+        delete o;
+        h(ec);
+    }
+
+private:
+    Handler handler_;
+};
+} // namespace detail
+} // namespace azmq
+#endif // AZMQ_DETAIL_WAIT_OP_HPP_
@@ -0,0 +1,264 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_LAST_VALUE_CACHE_HPP_
+#define AZMQ_LAST_VALUE_CACHE_HPP_
+
+#include "socket.hpp"
+#include "message.hpp"
+#include "detail/last_value_table.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief Maintains the latest message per topic received on a subscriber
+ *  socket, for lock-free reading from any number of threads
+ *  \remark The cache takes ownership of a (typically already subscribed)
+ *  sub_socket and receives on it from the socket's io_service. Each wakeup
+ *  drains up to batch_size messages with non-blocking receives before the next
+ *  asynchronous receive is issued.
+ *  \remark A message is keyed by its first frame. If the message has further
+ *  parts, the second part is the value and any remaining parts are discarded,
+ *  otherwise the whole frame is both key and value.
+ *  \remark Reads never take a lock or write shared state. Each topic is
+ *  guarded by a seqlock, a read copies the value out and is retried only if an
+ *  update to the same topic raced with it. Topics are never evicted; messages
+ *  for new topics once max_topics have been seen, and values larger than
+ *  max_value_size, are counted as dropped.
+ *  \remark last_value_cache is neither copyable nor movable
+ */
+class last_value_cache {
+public:
+    /** \brief construct a cache over a subscriber socket and start receiving
+     *  \param s socket, normally a sub_socket or xsub_socket
+     *  \param max_topics maximum number of distinct topics retained
+     *  \param max_value_size maximum size in bytes of a retained value
+     *  \param batch_size maximum number of messages received per wakeup
+     */
+    explicit last_value_cache(socket s,
+                              size_t max_topics = 1024,
+                              size_t max_value_size = 256,
+                              size_t batch_size = 64)
+        : state_(std::make_shared<state>(std::move(s), max_topics, max_value_size, batch_size))
+    {
+        state::start(state_);
+    }
+
+    last_value_cache(last_value_cache const&) = delete;
+    last_value_cache & operator=(last_value_cache const&) = delete;
+
+    ~last_value_cache() {
+        boost::system::error_code ec;
+        state_->socket_.cancel(ec);
+        state_->retry_.cancel(ec);
+    }
+
+    /** \brief the underlying socket, e.g. to add subscriptions
+     *  \remark not safe to use concurrently with the socket's io_service
+     */
+    socket & get_socket() { return state_->socket_; }
+
+    /** \brief copy the latest value for a topic, safe from any thread
+     *  \param topic topic to look up
+     *  \param buffer buffer to receive the value
+     *  \param version set to the number of updates seen for the topic
+     *  \param ec set to boost::asio::error::not_found if the topic has not
+     *  been seen, or to no_buffer_space if buffer is too small for the value
+     *  \return size of the value
+     */
+    size_t read(std::string_view topic, boost::asio::mutable_buffer buffer,
+                uint64_t & version, boost::system::error_code & ec) const {
+        return state_->table_.read(topic, boost::asio::buffer_cast<void*>(buffer),
+                                   boost::asio::buffer_size(buffer), version, ec);
+    }
+
+    /** \brief copy the latest value for a topic, safe from any thread
+     *  \param topic topic to look up
+     *  \param buffer buffer to receive the value
+     *  \return size of the value
+     *  \throw boost::system::system_error
+     */
+    size_t read(std::string_view topic, boost::asio::mutable_buffer buffer) const {
+        boost::system::error_code ec;
+        uint64_t version;
+        auto res = read(topic, buffer, version, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+    /** \brief copy the latest value for a topic into a string, safe from any
+     *  thread
+     *  \param topic topic to look up
+     *  \param value string to receive the value, its capacity is reused
+     *  \return false if the topic has not been seen
+     */
+    bool read(std::string_view topic, std::string & value) const {
+        value.resize(max_value_size());
+        boost::system::error_code ec;
+        uint64_t version;
+        auto res = read(topic, boost::asio::buffer(&value[0], value.size()), version, ec);
+        value.resize(ec ? 0 : res);
+        return !ec;
+    }
+
+    /** \brief number of updates seen for a topic, zero if it has not been
+     *  seen, safe from any thread
+     */
+    uint64_t version(std::string_view topic) const {
+        return state_->table_.version(topic);
+    }
+
+    /** \brief number of distinct topics held */
+    size_t size() const { return state_->table_.size(); }
+
+    size_t max_topics() const { return state_->table_.max_keys(); }
+    size_t max_value_size() const { return state_->table_.max_value_size(); }
+
+    /** \brief number of messages applied to the cache */
+    uint64_t updates() const { return state_->updates_.load(std::memory_order_relaxed); }
+
+    /** \brief number of messages dropped as too large or for lack of space */
+    uint64_t dropped() const { return state_->dropped_.load(std::memory_order_relaxed); }
+
+    /** \brief number of receives which failed
+     *  \remark The cache carries on receiving after a failure, unless the
+     *  receive was cancelled, the socket shut down or its context terminated.
+     *  A failure repeating the previous receive's error is likely to persist
+     *  (e.g. EFSM), the next receive then waits for a back-off which doubles
+     *  with each repeat, from 1ms up to a second.
+     */
+    uint64_t errors() const { return state_->errors_.load(std::memory_order_relaxed); }
+
+private:
+    struct state {
+        using ptr = std::shared_ptr<state>;
+        using weak_ptr = std::weak_ptr<state>;
+
+        socket socket_;
+        detail::last_value_table table_;
+        size_t const batch_size_;
+        message key_;
+        message value_;
+        std::atomic<uint64_t> updates_{ 0 };
+        std::atomic<uint64_t> dropped_{ 0 };
+        std::atomic<uint64_t> errors_{ 0 };
+        boost::system::error_code last_error_; // of the previous receive
+        boost::asio::steady_timer retry_;
+        std::chrono::milliseconds backoff_{ 0 };
+
+        state(socket s, size_t max_topics, size_t max_value_size, size_t batch_size)
+            : socket_(std::move(s))
+            , table_(max_topics, max_value_size)
+            , batch_size_(batch_size ? batch_size : 1)
+            , retry_(socket_.get_io_service())
+        { }
+
+        // a failed receive is counted and receiving carries on, unless the
+        // error is final. Should the previous receive have failed the same
+        // way, after backing off
+        static void start(ptr const& p) {
+            weak_ptr w = p;
+            p->socket_.async_receive([w](boost::system::error_code const& ec, message & msg, size_t) {
+                if (ec == boost::asio::error::operation_aborted)
+                    return;
+                auto p = w.lock();
+                if (!p)
+                    return;
+                if (ec) {
+                    p->errors_.fetch_add(1, std::memory_order_relaxed);
+                    if (!detail::socket_ops::ends_receive(ec))
+                        retry(p, ec);
+                    return;
+                }
+                p->last_error_.clear();
+                p->backoff_ = std::chrono::milliseconds(0);
+                p->key_ = std::move(msg);
+                if (p->apply()) {
+                    for (size_t i = 1; i != p->batch_size_; ++i) {
+                        boost::system::error_code rec;
+                        p->socket_.receive(p->key_, ZMQ_DONTWAIT, rec);
+                        if (rec) {
+                            if (rec.value() != EAGAIN)
+                                p->errors_.fetch_add(1, std::memory_order_relaxed);
+                            break;
+                        }
+                        if (!p->apply())
+                            break;
+                    }
+                }
+                start(p);
+            });
+        }
+
+        static void retry(ptr const& p, boost::system::error_code const& ec) {
+            if (ec != p->last_error_) {
+                p->last_error_ = ec;
+                p->backoff_ = std::chrono::milliseconds(0);
+                start(p);
+                return;
+            }
+            p->backoff_ = std::min(std::max(p->backoff_ * 2, std::chrono::milliseconds(1)),
+                                   std::chrono::milliseconds(1000));
+            weak_ptr w = p;
+            p->retry_.expires_from_now(p->backoff_);
+            p->retry_.async_wait([w](boost::system::error_code const& ec) {
+                if (ec)
+                    return;
+                if (auto p = w.lock())
+                    start(p);
+            });
+        }
+
+        // key_ holds the first frame of a message, receives the rest of it
+        // and updates the table, returns false if the rest could not be
+        // received
+        bool apply() {
+            auto v = &key_;
+            if (key_.more()) {
+                boost::system::error_code ec;
+                socket_.receive(value_, 0, ec);
+                if (ec) {
+                    errors_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                if (value_.more())
+                    socket_.flush(ec);
+                v = &value_;
+            }
+            auto key = key_.cbuffer();
+            auto val = v->cbuffer();
+            if (table_.update(std::string_view(boost::asio::buffer_cast<char const*>(key),
+                                               boost::asio::buffer_size(key)),
+                              boost::asio::buffer_cast<void const*>(val),
+                              boost::asio::buffer_size(val)))
+                updates_.fetch_add(1, std::memory_order_relaxed);
+            else
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    std::shared_ptr<state> state_;
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_LAST_VALUE_CACHE_HPP_
@@ -227,6 +227,48 @@ AZMQ_V1_INLINE_NAMESPACE_BEGIN
             return zmq_msg_more(const_cast<zmq_msg_t*>(&msg_)) ? true : false;
         }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+        /** \brief routing id of a message received on, or to be sent through, a
+         *  ZMQ_SERVER socket, 0 if unset
+         */
+        uint32_t routing_id() const BOOST_NOEXCEPT {
+            return zmq_msg_routing_id(const_cast<zmq_msg_t*>(&msg_));
+        }
+
+        boost::system::error_code set_routing_id(uint32_t id,
+                                                 boost::system::error_code & ec) BOOST_NOEXCEPT {
+            if (zmq_msg_set_routing_id(&msg_, id) < 0)
+                ec = make_error_code();
+            return ec;
+        }
+
+        void set_routing_id(uint32_t id) {
+            boost::system::error_code ec;
+            if (set_routing_id(id, ec))
+                throw boost::system::system_error(ec);
+        }
+
+        /** \brief group of a message received on, or to be published through, a
+         *  ZMQ_RADIO/ZMQ_DISH socket
+         */
+        char const* group() const BOOST_NOEXCEPT {
+            return zmq_msg_group(const_cast<zmq_msg_t*>(&msg_));
+        }
+
+        boost::system::error_code set_group(char const* group,
+                                            boost::system::error_code & ec) BOOST_NOEXCEPT {
+            if (zmq_msg_set_group(&msg_, group) < 0)
+                ec = make_error_code();
+            return ec;
+        }
+
+        void set_group(char const* group) {
+            boost::system::error_code ec;
+            if (set_group(group, ec))
+                throw boost::system::system_error(ec);
+        }
+#endif
+
     private:
         friend detail::socket_ops;
         zmq_msg_t msg_;
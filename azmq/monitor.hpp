@@ -0,0 +1,123 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_MONITOR_HPP_
+#define AZMQ_MONITOR_HPP_
+
+#include "socket.hpp"
+#include "detail/monitor_ext.hpp"
+#include "detail/socket_service.hpp"
+
+#include <boost/system/system_error.hpp>
+
+#include <utility>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+    using monitor_event = detail::monitor_event;
+    using endpoint_stats = detail::endpoint_stats;
+    using endpoint_stats_map = detail::endpoint_stats_map;
+
+    /** \brief socket option (get only) yielding a snapshot of the per-endpoint
+     *  statistics gathered by async_monitor()
+     */
+    using monitor_stats = detail::monitor_ext::stats;
+
+    /** \brief monitor events on a socket, decoding them as they arrive
+     *  \tparam MonitorHandler must conform to the signature
+     *  void(boost::system::error_code const&, monitor_event const&)
+     *  \param s socket to monitor
+     *  \param events int mask of ZMQ_EVENT_* values to monitor
+     *  \param handler MonitorHandler, invoked on the socket's io_service for
+     *  each event
+     *  \param ec error_code to set on error
+     *  \return true if monitoring was started, false if the socket is already
+     *  being monitored or an error occurred
+     *
+     *  \remark The monitor stream is received into fixed buffers owned by the
+     *  extension and the event passed to the handler is reused, so decoding does
+     *  not allocate once each endpoint has been seen. The event reference is
+     *  only valid for the duration of the handler call.
+     *
+     *  \remark Independently of the handler, per-endpoint connection statistics
+     *  (connect and handshake latency, reconnect, disconnect and handshake
+     *  failure counts) are accumulated and may be queried at any time by
+     *  getting the monitor_stats option on the socket.
+     *
+     *  \remark Monitoring stops when the socket is destroyed.
+     */
+    template<typename MonitorHandler>
+    bool async_monitor(socket & s, int events, MonitorHandler && handler,
+                       boost::system::error_code & ec) {
+        monitor_stats existing;
+        if (!s.get_option(existing, ec))
+            return false;
+        ec = boost::system::error_code();
+        auto m = s.monitor(s.get_io_service(), events, ec);
+        if (ec)
+            return false;
+        return detail::associate_ext(s, detail::monitor_ext(std::move(m),
+                                                            std::forward<MonitorHandler>(handler)));
+    }
+
+    /** \brief monitor events on a socket, decoding them as they arrive
+     *  \tparam MonitorHandler must conform to the signature
+     *  void(boost::system::error_code const&, monitor_event const&)
+     *  \param s socket to monitor
+     *  \param events int mask of ZMQ_EVENT_* values to monitor
+     *  \param handler MonitorHandler
+     *  \return true if monitoring was started, false if the socket is already
+     *  being monitored
+     *  \throw boost::system::system_error
+     */
+    template<typename MonitorHandler>
+    bool async_monitor(socket & s, int events, MonitorHandler && handler) {
+        boost::system::error_code ec;
+        auto res = async_monitor(s, events, std::forward<MonitorHandler>(handler), ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+    /** \brief gather per-endpoint connection statistics for a socket without
+     *  handling individual events
+     *  \param s socket to monitor
+     *  \param ec error_code to set on error
+     *  \return true if monitoring was started
+     */
+    inline bool async_monitor(socket & s, boost::system::error_code & ec) {
+        return async_monitor(s, ZMQ_EVENT_ALL, detail::monitor_ext::handler_type(), ec);
+    }
+
+    /** \brief snapshot of the statistics gathered by async_monitor()
+     *  \param s monitored socket
+     *  \param ec error_code to set on error, including when the socket is not
+     *  being monitored
+     */
+    inline endpoint_stats_map get_monitor_stats(socket & s, boost::system::error_code & ec) {
+        monitor_stats opt;
+        s.get_option(opt, ec);
+        return std::move(opt.value_);
+    }
+
+    /** \brief snapshot of the statistics gathered by async_monitor()
+     *  \param s monitored socket
+     *  \throw boost::system::system_error
+     */
+    inline endpoint_stats_map get_monitor_stats(socket & s) {
+        boost::system::error_code ec;
+        auto res = get_monitor_stats(s, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_MONITOR_HPP_
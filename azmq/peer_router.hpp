@@ -0,0 +1,283 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_PEER_ROUTER_HPP_
+#define AZMQ_PEER_ROUTER_HPP_
+
+#include "socket.hpp"
+#include "message.hpp"
+#include "error.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief Wraps a ROUTER socket with a table of peers, each with its own
+ *  bounded outgoing queue
+ *  \remark Identities are interned once into a hash table and thereafter
+ *  referred to by a small integer peer_id. Sends are queued per peer and
+ *  written with ZMQ_ROUTER_MANDATORY and ZMQ_DONTWAIT, so a peer whose pipe is
+ *  full only blocks its own queue; it is retried every retry_interval while
+ *  other peers continue to be served. When a peer's queue is full, further
+ *  messages to it are dropped and counted rather than stalling the caller.
+ *  \remark Messages are single frame; the identity frame is supplied by the
+ *  router.
+ *  \remark Like socket, a peer_router is not thread safe and should be used
+ *  from the socket's io_service. It is neither copyable nor movable.
+ */
+class peer_router {
+public:
+    using peer_id = uint32_t;
+    static constexpr peer_id npos = static_cast<peer_id>(-1);
+
+    /** \brief per peer counters */
+    struct peer_stats {
+        uint64_t sent = 0;          // messages written to the socket
+        uint64_t dropped = 0;       // messages discarded, queue full or peer gone
+        uint64_t blocked = 0;       // writes deferred because the peer's pipe was full
+        size_t queued = 0;          // current queue depth
+    };
+
+    /** \brief construct a peer_router over a ROUTER socket
+     *  \param s socket, sets ZMQ_ROUTER_MANDATORY on it
+     *  \param queue_capacity maximum number of messages queued per peer
+     *  \param retry_interval how often writes to blocked peers are retried
+     *  \throw boost::system::system_error
+     */
+    explicit peer_router(socket s,
+                         size_t queue_capacity = 1000,
+                         std::chrono::steady_clock::duration retry_interval = std::chrono::milliseconds(1))
+        : state_(std::make_shared<state>(std::move(s), queue_capacity, retry_interval))
+    {
+        state_->socket_.set_option(socket::router_mandatory(true));
+    }
+
+    peer_router(peer_router const&) = delete;
+    peer_router & operator=(peer_router const&) = delete;
+
+    ~peer_router() {
+        boost::system::error_code ec;
+        state_->timer_.cancel(ec);
+        state_->socket_.cancel(ec);
+    }
+
+    socket & get_socket() { return state_->socket_; }
+
+    /** \brief peer_id for an identity, adding it to the table if necessary */
+    peer_id intern(std::string_view identity) { return state_->intern(identity); }
+
+    /** \brief peer_id for an identity, npos if it has not been seen */
+    peer_id find(std::string_view identity) const { return state_->find(identity); }
+
+    /** \brief identity of a peer */
+    std::string const& identity(peer_id id) const { return state_->peers_.at(id).identity_; }
+
+    /** \brief number of peers in the table */
+    size_t size() const { return state_->peers_.size(); }
+
+    /** \brief counters for a peer */
+    peer_stats stats(peer_id id) const {
+        auto const& p = state_->peers_.at(id);
+        auto res = p.stats_;
+        res.queued = p.queue_.size();
+        return res;
+    }
+
+    /** \brief current queue depth for a peer */
+    size_t queue_depth(peer_id id) const { return state_->peers_.at(id).queue_.size(); }
+
+    /** \brief queue a message for a peer, writing it immediately if the peer
+     *  has nothing already queued and its pipe has room
+     *  \param id peer to send to
+     *  \param msg message to send
+     *  \param ec set to no_buffer_space if the peer's queue is full, or to
+     *  EHOSTUNREACH if the router has no connection to the peer; the message
+     *  is dropped and counted in either case
+     *  \return true if the message was sent or queued
+     */
+    bool send(peer_id id, message msg, boost::system::error_code & ec) {
+        return state_->send(id, std::move(msg), ec);
+    }
+
+    /** \brief queue a message for a peer
+     *  \return true if the message was sent or queued, false if it was
+     *  dropped
+     */
+    bool send(peer_id id, message msg) {
+        boost::system::error_code ec;
+        return send(id, std::move(msg), ec);
+    }
+
+    /** \brief Initiate an async receive operation
+     *  \tparam PeerReadHandler must conform to the signature
+     *  void(boost::system::error_code const&, peer_id, message & msg)
+     *  \remark msg is the first frame after the identity, further parts may be
+     *  received synchronously from get_socket()
+     */
+    template<typename PeerReadHandler>
+    void async_receive(PeerReadHandler && handler) {
+        std::weak_ptr<state> w = state_;
+        state_->socket_.async_receive(
+            [w, handler = std::forward<PeerReadHandler>(handler)](boost::system::error_code const& ec,
+                                                                  message & msg, size_t) mutable {
+                auto p = w.lock();
+                if (ec || !p) {
+                    handler(ec, npos, msg);
+                    return;
+                }
+                auto b = msg.cbuffer();
+                auto id = p->intern(std::string_view(boost::asio::buffer_cast<char const*>(b),
+                                                     boost::asio::buffer_size(b)));
+                boost::system::error_code rec;
+                if (msg.more())
+                    p->socket_.receive(msg, 0, rec);
+                else
+                    msg = message();
+                handler(rec, id, msg);
+            });
+    }
+
+private:
+    struct peer {
+        std::string identity_;
+        std::deque<message> queue_;
+        peer_stats stats_;
+        bool blocked_ = false;
+    };
+
+    struct state : std::enable_shared_from_this<state> {
+        socket socket_;
+        size_t const queue_capacity_;
+        std::chrono::steady_clock::duration const retry_interval_;
+        boost::asio::steady_timer timer_;
+        bool timer_armed_ = false;
+        std::unordered_map<std::string, peer_id> index_;
+        // identities are copied here to be looked up, so that a known peer
+        // costs no allocation once its capacity has grown to fit
+        mutable std::string key_;
+        std::vector<peer> peers_;
+        std::vector<peer_id> blocked_;
+
+        state(socket s, size_t queue_capacity, std::chrono::steady_clock::duration retry_interval)
+            : socket_(std::move(s))
+            , queue_capacity_(queue_capacity)
+            , retry_interval_(retry_interval)
+            , timer_(socket_.get_io_service())
+        { }
+
+        peer_id find(std::string_view identity) const {
+            key_.assign(identity.data(), identity.size());
+            auto it = index_.find(key_);
+            return it == std::end(index_) ? npos : it->second;
+        }
+
+        peer_id intern(std::string_view identity) {
+            auto id = find(identity);
+            if (id != npos)
+                return id;
+            id = static_cast<peer_id>(peers_.size());
+            index_.emplace(key_, id);
+            peers_.emplace_back();
+            peers_.back().identity_ = key_;
+            return id;
+        }
+
+        bool send(peer_id id, message msg, boost::system::error_code & ec) {
+            auto & p = peers_.at(id);
+            if (p.queue_.size() >= queue_capacity_) {
+                ++p.stats_.dropped;
+                ec = make_error_code(boost::system::errc::no_buffer_space);
+                return false;
+            }
+            p.queue_.push_back(std::move(msg));
+            if (!p.blocked_ && !flush(id, ec))
+                return false;
+            return true;
+        }
+
+        // writes as much of a peer's queue as its pipe accepts, returns false
+        // if the peer is unreachable
+        bool flush(peer_id id, boost::system::error_code & ec) {
+            auto & p = peers_[id];
+            while (!p.queue_.empty()) {
+                // with ROUTER_MANDATORY a full or missing pipe is reported on
+                // the identity frame, before any part of the message is written
+                socket_.send(boost::asio::buffer(p.identity_), ZMQ_SNDMORE | ZMQ_DONTWAIT, ec);
+                if (ec) {
+                    if (ec.value() == EAGAIN) {
+                        ec = boost::system::error_code();
+                        block(id);
+                        return true;
+                    }
+                    p.stats_.dropped += p.queue_.size();
+                    p.queue_.clear();
+                    return false;
+                }
+                socket_.send(p.queue_.front(), ZMQ_DONTWAIT, ec);
+                p.queue_.pop_front();
+                if (ec) {
+                    ++p.stats_.dropped;
+                    return false;
+                }
+                ++p.stats_.sent;
+            }
+            p.blocked_ = false;
+            return true;
+        }
+
+        void block(peer_id id) {
+            auto & p = peers_[id];
+            ++p.stats_.blocked;
+            if (!p.blocked_) {
+                p.blocked_ = true;
+                blocked_.push_back(id);
+            }
+            if (timer_armed_)
+                return;
+            timer_armed_ = true;
+            timer_.expires_from_now(retry_interval_);
+            std::weak_ptr<state> w = shared_from_this();
+            timer_.async_wait([w](boost::system::error_code const& ec) {
+                if (ec)
+                    return;
+                if (auto p = w.lock())
+                    p->retry();
+            });
+        }
+
+        void retry() {
+            timer_armed_ = false;
+            auto ids = std::move(blocked_);
+            blocked_.clear();
+            for (auto id : ids) {
+                peers_[id].blocked_ = false;
+                boost::system::error_code ec;
+                flush(id, ec);
+            }
+        }
+    };
+
+    std::shared_ptr<state> state_;
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_PEER_ROUTER_HPP_
@@ -0,0 +1,219 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_PIPE_HPP_
+#define AZMQ_PIPE_HPP_
+
+#include <boost/asio/io_service.hpp>
+
+// azmq::pipe wakes its peer through an eventfd (or a self-pipe), so it is
+// only available on POSIX platforms
+#if ! defined BOOST_ASIO_WINDOWS
+#include "error.hpp"
+#include "message.hpp"
+#include "detail/pipe_ops.hpp"
+
+#include <boost/system/system_error.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief One end of an in-process message pipe
+ *  \remark A pipe is a pair of bounded, lock-free, single producer/single
+ *  consumer rings of messages. Each end registers an eventfd with its
+ *  io_service to be woken when the other end sends (or drains a full ring),
+ *  and the eventfd is only written when the other side is actually waiting.
+ *  Operations on one end, synchronous or not, are serialized by a mutex
+ *  owned by that end, which is not held while a synchronous call blocks.
+ *  Messages never pass through libzmq, so intra-process traffic avoids its
+ *  pipe, mailbox and ZMQ_FD machinery entirely.
+ *  \remark The send/receive interface mirrors that of azmq::socket for single
+ *  part messages. Multipart messages are not supported; messages are delivered
+ *  in order, one frame at a time.
+ *  \remark Once either end is destroyed, operations on the other end complete
+ *  with boost::asio::error::broken_pipe after any messages already queued have
+ *  been received.
+ *  \remark pipes are movable, but not copyable
+ */
+class pipe {
+public:
+    using flags_type = detail::pipe_ops::flags_type;
+
+    pipe(pipe && other) = default;
+    pipe & operator=(pipe && other) {
+        reset();
+        impl_ = std::move(other.impl_);
+        companion_ = std::move(other.companion_);
+        return *this;
+    }
+
+    pipe(pipe const&) = delete;
+    pipe & operator=(pipe const&) = delete;
+
+    ~pipe() { reset(); }
+
+    boost::asio::io_service & get_io_service() { return impl_->get_io_service(); }
+
+    /** \brief Send a message to the other end of the pipe
+     *  \param msg message to send, pass an rvalue to avoid a reference count
+     *  increment
+     *  \param flags specifying how the send call is to be made, ZMQ_DONTWAIT
+     *  fails with EAGAIN rather than blocking if the pipe is full
+     *  \param ec set to indicate what, if any, error occurred
+     *  \return bytes transferred
+     */
+    std::size_t send(message msg,
+                     flags_type flags,
+                     boost::system::error_code & ec) {
+        return impl_->send(msg, flags, ec);
+    }
+
+    /** \brief Send a message to the other end of the pipe
+     *  \param msg message to send
+     *  \param flags specifying how the send call is to be made
+     *  \return bytes transferred
+     *  \throw boost::system::system_error
+     */
+    std::size_t send(message msg,
+                     flags_type flags = 0) {
+        boost::system::error_code ec;
+        auto res = send(std::move(msg), flags, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+    /** \brief Receive a message from the other end of the pipe
+     *  \param msg message to fill on receive
+     *  \param flags specifying how the receive call is to be made, ZMQ_DONTWAIT
+     *  fails with EAGAIN rather than blocking if the pipe is empty
+     *  \param ec set to indicate what, if any, error occurred
+     *  \return bytes transferred
+     */
+    std::size_t receive(message & msg,
+                        flags_type flags,
+                        boost::system::error_code & ec) {
+        return impl_->receive(msg, flags, ec);
+    }
+
+    /** \brief Receive a message from the other end of the pipe
+     *  \param msg message to fill on receive
+     *  \param flags specifying how the receive call is to be made
+     *  \return bytes transferred
+     *  \throw boost::system::system_error
+     */
+    std::size_t receive(message & msg,
+                        flags_type flags = 0) {
+        boost::system::error_code ec;
+        auto res = receive(msg, flags, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+    /** \brief Initiate an async send operation
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept
+     *  \param msg message to send
+     *  \param handler WriteHandler
+     */
+    template<typename WriteHandler>
+    void async_send(message msg, WriteHandler && handler) {
+        using type = detail::pipe_send_op<typename std::decay<WriteHandler>::type>;
+        detail::pipe_impl::enqueue(impl_, detail::pipe_impl::write_op,
+                                   std::unique_ptr<detail::pipe_op>(
+                                        new type(std::move(msg), std::forward<WriteHandler>(handler))));
+    }
+
+    /** \brief Initiate an async receive operation
+     *  \tparam MessageReadHandler must conform to the MessageReadHandler
+     *  concept described for azmq::socket::async_receive
+     *  \param handler MessageReadHandler
+     */
+    template<typename MessageReadHandler>
+    void async_receive(MessageReadHandler && handler) {
+        using type = detail::pipe_receive_op<typename std::decay<MessageReadHandler>::type>;
+        detail::pipe_impl::enqueue(impl_, detail::pipe_impl::read_op,
+                                   std::unique_ptr<detail::pipe_op>(
+                                        new type(std::forward<MessageReadHandler>(handler))));
+    }
+
+    /** \brief Cancel all outstanding asynchronous operations
+     *  \param ec set to indicate what, if any, error occurred
+     */
+    boost::system::error_code cancel(boost::system::error_code & ec) {
+        impl_->cancel(ec);
+        return ec;
+    }
+
+    /** \brief Cancel all outstanding asynchronous operations
+     *  \throw boost::system::system_error
+     */
+    void cancel() {
+        boost::system::error_code ec;
+        if (cancel(ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief Close this end of the pipe
+     *  \remark Outstanding and subsequent operations on either end complete
+     *  with boost::asio::error::broken_pipe, once any queued messages have been
+     *  received.
+     */
+    void close() {
+        impl_->close();
+    }
+
+    /** \brief create a connected pair of pipe ends
+     *  \param ios_a io_service for the first end
+     *  \param ios_b io_service for the second end
+     *  \param capacity maximum number of messages queued in each direction,
+     *  rounded up to a power of two
+     *  \throw boost::system::system_error
+     */
+    static std::pair<pipe, pipe> create(boost::asio::io_service & ios_a,
+                                        boost::asio::io_service & ios_b,
+                                        size_t capacity = 1024) {
+        boost::system::error_code ec;
+        auto a_to_b = std::make_shared<detail::pipe_channel>(capacity, ec);
+        auto b_to_a = std::make_shared<detail::pipe_channel>(capacity, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return std::make_pair(pipe(std::make_shared<detail::pipe_impl>(ios_a, b_to_a, a_to_b)),
+                              pipe(std::make_shared<detail::pipe_impl>(ios_b, a_to_b, b_to_a)));
+    }
+
+    /** \brief associate an object with this end of the pipe, it is released
+     *  after the pipe has been closed
+     */
+    void set_companion(std::shared_ptr<void> companion) {
+        companion_ = std::move(companion);
+    }
+
+private:
+    detail::pipe_impl::ptr impl_;
+    std::shared_ptr<void> companion_;
+
+    explicit pipe(detail::pipe_impl::ptr impl)
+        : impl_(std::move(impl))
+    { }
+
+    void reset() {
+        if (impl_)
+            impl_->close();
+        impl_.reset();
+        companion_.reset();
+    }
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // ! defined BOOST_ASIO_WINDOWS
+#endif // AZMQ_PIPE_HPP_
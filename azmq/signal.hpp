@@ -10,10 +10,105 @@
 #define AZMQ_SIGNAL_HPP_
 
 #include "socket.hpp"
+#include "pipe.hpp"
+
+#include <deque>
+#include <type_traits>
+#include <utility>
 
 namespace azmq {
+namespace detail {
+    struct signal_ops {
+        enum : uint64_t {
+            magic = 0x77664433221100u,
+            mask = 0xffffffffffff00u
+        };
+
+        static bool decode(message const& msg, uint8_t & status) {
+            if (msg.size() != sizeof(uint64_t) || msg.more())
+                return false;
+            auto v = msg.buffer_cast<uint64_t>();
+            if ((v & mask) != magic)
+                return false;
+            status = v & 255;
+            return true;
+        }
+
+        template<typename Endpoint>
+        static boost::system::error_code send(Endpoint & s, uint8_t status,
+                                              boost::system::error_code & ec) {
+            uint64_t v = magic + status;
+            // eight bytes fits in a libzmq very small message, so this does
+            // not allocate
+            s.send(message(boost::asio::buffer(&v, sizeof(v))), 0, ec);
+            return ec;
+        }
+
+        template<typename Endpoint, typename Stash>
+        static uint8_t wait(Endpoint & s, Stash * stash, boost::system::error_code & ec) {
+            message msg;
+            bool in_multipart = false;
+            while (true) {
+                s.receive(msg, 0, ec);
+                if (ec)
+                    return 0;
+                uint8_t status;
+                if (!in_multipart && decode(msg, status))
+                    return status;
+                in_multipart = msg.more();
+                if (stash)
+                    stash->push_back(std::move(msg));
+            }
+        }
+
+        template<typename Endpoint, typename Stash, typename Handler>
+        struct async_wait_op {
+            Endpoint & s_;
+            Stash * stash_;
+            Handler handler_;
+            bool in_multipart_;
+
+            async_wait_op(Endpoint & s, Stash * stash, Handler handler)
+                : s_(s)
+                , stash_(stash)
+                , handler_(std::move(handler))
+                , in_multipart_(false)
+            { }
+
+            void operator()(boost::system::error_code const& ec, message & msg, size_t) {
+                if (ec) {
+                    handler_(ec, uint8_t(0));
+                    return;
+                }
+                uint8_t status;
+                if (!in_multipart_ && decode(msg, status)) {
+                    handler_(ec, status);
+                    return;
+                }
+                in_multipart_ = msg.more();
+                if (stash_)
+                    stash_->push_back(std::move(msg));
+                auto & s = s_;
+                s.async_receive(std::move(*this));
+            }
+        };
+
+        template<typename Endpoint, typename Stash, typename Handler>
+        static void async_wait(Endpoint & s, Stash * stash, Handler && handler) {
+            using op = async_wait_op<Endpoint, Stash, typename std::decay<Handler>::type>;
+            s.async_receive(op(s, stash, std::forward<Handler>(handler)));
+        }
+    };
+} // namespace detail
+
 namespace signal {
 AZMQ_V1_INLINE_NAMESPACE_BEGIN
+/** \brief Container receiving messages which arrive ahead of a signal
+ *  \remark wait() and async_wait() append any non-signal message parts they
+ *  receive while waiting to a stash, in order, rather than dropping them.
+ */
+using stash = std::deque<message>;
+
 /** \brief Send a signal over a socket. A signal is a short message carrying a
  *  success/failure code (by convention, 0 means OK). Signals are encoded to be
  *  distinguishable from "normal" messages.
@@ -22,12 +117,9 @@ AZMQ_V1_INLINE_NAMESPACE_BEGIN
  *  \param ec boost::system::error_code&
  *  \return boost::system::error_code
  */
-boost::system::error_code send(socket & s, uint8_t status,
+inline boost::system::error_code send(socket & s, uint8_t status,
                                boost::system::error_code & ec) {
-    uint64_t v = 0x77664433221100u + status;
-    auto buf = boost::asio::buffer(&v, sizeof(v));
-    s.send(buf, 0, ec);
-    return ec;
+    return detail::signal_ops::send(s, status, ec);
 }
 
 /** \brief Send a signal over a socket. A signal is a short message carrying a
@@ -37,30 +129,46 @@ boost::system::error_code send(socket & s, uint8_t status,
  *  \param status uint8_t to send
  *  \throw boost::system::system_error
  */
-void send(socket & s, uint8_t status) {
+inline void send(socket & s, uint8_t status) {
     boost::system::error_code ec;
     if (send(s, status, ec))
         throw boost::system::system_error(ec);
 }
 
+#if ! defined BOOST_ASIO_WINDOWS
+/** \brief Send a signal over an in-process pipe. The signal is queued on the
+ *  pipe's ring, the peer is only woken (via its eventfd) if it is waiting.
+ *  \param p pipe& to signal on
+ *  \param status uint8_t to send
+ *  \param ec boost::system::error_code&
+ *  \return boost::system::error_code
+ */
+inline boost::system::error_code send(pipe & p, uint8_t status,
+                               boost::system::error_code & ec) {
+    return detail::signal_ops::send(p, status, ec);
+}
+
+/** \brief Send a signal over an in-process pipe.
+ *  \param p pipe& to signal on
+ *  \param status uint8_t to send
+ *  \throw boost::system::system_error
+ */
+inline void send(pipe & p, uint8_t status) {
+    boost::system::error_code ec;
+    if (send(p, status, ec))
+        throw boost::system::system_error(ec);
+}
+#endif // ! defined BOOST_ASIO_WINDOWS
+
 /** \brief Wait on a signal from a socket. Use this with signal() to coordiante
  *  over thread/actor pipes
  *  \param s socket& to receive signal from
  *  \param ec boost::system::error_code
  *  \return signal
+ *  \remark any other messages received while waiting are discarded
  */
-uint8_t wait(socket & s, boost::system::error_code & ec) {
-    message msg;
-    while (true) {
-        auto sz = s.receive(msg, 0, ec);
-        if (ec)
-            return 0;
-        if (sz == sizeof(uint64_t)) {
-            auto v = msg.buffer_cast<uint64_t>();
-            if ((v & 0xffffffffffff00u) == 0x77664433221100u)
-                return v & 255;
-        }
-    }
+inline uint8_t wait(socket & s, boost::system::error_code & ec) {
+    return detail::signal_ops::wait(s, static_cast<stash*>(nullptr), ec);
 }
 
 /** \brief Wait on a signal from a socket. Use this with signal() to coordiante
@@ -69,7 +177,7 @@ uint8_t wait(socket & s, boost::system::error_code & ec) {
  *  \return signal
  *  \throw boost::system::system_error
  */
-uint8_t wait(socket & s) {
+inline uint8_t wait(socket & s) {
     boost::system::error_code ec;
     auto res = wait(s, ec);
     if (ec)
@@ -77,6 +185,109 @@ uint8_t wait(socket & s) {
     return res;
 }
 
+/** \brief Wait on a signal from a socket, keeping any other messages
+ *  \param s socket& to receive signal from
+ *  \param pending stash& to which messages received ahead of the signal are
+ *  appended
+ *  \param ec boost::system::error_code
+ *  \return signal
+ */
+inline uint8_t wait(socket & s, stash & pending, boost::system::error_code & ec) {
+    return detail::signal_ops::wait(s, &pending, ec);
+}
+
+#if ! defined BOOST_ASIO_WINDOWS
+/** \brief Wait on a signal from an in-process pipe
+ *  \param p pipe& to receive signal from
+ *  \param ec boost::system::error_code
+ *  \return signal
+ *  \remark any other messages received while waiting are discarded
+ */
+inline uint8_t wait(pipe & p, boost::system::error_code & ec) {
+    return detail::signal_ops::wait(p, static_cast<stash*>(nullptr), ec);
+}
+
+/** \brief Wait on a signal from an in-process pipe
+ *  \param p pipe& to receive signal from
+ *  \return signal
+ *  \throw boost::system::system_error
+ */
+inline uint8_t wait(pipe & p) {
+    boost::system::error_code ec;
+    auto res = wait(p, ec);
+    if (ec)
+        throw boost::system::system_error(ec);
+    return res;
+}
+
+/** \brief Wait on a signal from an in-process pipe, keeping any other
+ *  messages
+ *  \param p pipe& to receive signal from
+ *  \param pending stash& to which messages received ahead of the signal are
+ *  appended
+ *  \param ec boost::system::error_code
+ *  \return signal
+ */
+inline uint8_t wait(pipe & p, stash & pending, boost::system::error_code & ec) {
+    return detail::signal_ops::wait(p, &pending, ec);
+}
+#endif // ! defined BOOST_ASIO_WINDOWS
+
+/** \brief Asynchronously wait on a signal from a socket. Does not block the
+ *  calling thread; completes through the socket's io_service.
+ *  \tparam SignalHandler must conform to the signature
+ *  void(boost::system::error_code const&, uint8_t)
+ *  \param s socket& to receive signal from
+ *  \param pending stash& to which messages received ahead of the signal are
+ *  appended, must remain valid until the handler is invoked
+ *  \param handler SignalHandler
+ */
+template<typename SignalHandler>
+void async_wait(socket & s, stash & pending, SignalHandler && handler) {
+    detail::signal_ops::async_wait(s, &pending, std::forward<SignalHandler>(handler));
+}
+
+/** \brief Asynchronously wait on a signal from a socket, discarding any
+ *  other messages received while waiting
+ *  \tparam SignalHandler must conform to the signature
+ *  void(boost::system::error_code const&, uint8_t)
+ *  \param s socket& to receive signal from
+ *  \param handler SignalHandler
+ */
+template<typename SignalHandler>
+void async_wait(socket & s, SignalHandler && handler) {
+    detail::signal_ops::async_wait(s, static_cast<stash*>(nullptr),
+                                   std::forward<SignalHandler>(handler));
+}
+
+#if ! defined BOOST_ASIO_WINDOWS
+/** \brief Asynchronously wait on a signal from an in-process pipe
+ *  \tparam SignalHandler must conform to the signature
+ *  void(boost::system::error_code const&, uint8_t)
+ *  \param p pipe& to receive signal from
+ *  \param pending stash& to which messages received ahead of the signal are
+ *  appended, must remain valid until the handler is invoked
+ *  \param handler SignalHandler
+ */
+template<typename SignalHandler>
+void async_wait(pipe & p, stash & pending, SignalHandler && handler) {
+    detail::signal_ops::async_wait(p, &pending, std::forward<SignalHandler>(handler));
+}
+
+/** \brief Asynchronously wait on a signal from an in-process pipe,
+ *  discarding any other messages received while waiting
+ *  \tparam SignalHandler must conform to the signature
+ *  void(boost::system::error_code const&, uint8_t)
+ *  \param p pipe& to receive signal from
+ *  \param handler SignalHandler
+ */
+template<typename SignalHandler>
+void async_wait(pipe & p, SignalHandler && handler) {
+    detail::signal_ops::async_wait(p, static_cast<stash*>(nullptr),
+                                   std::forward<SignalHandler>(handler));
+}
+#endif // ! defined BOOST_ASIO_WINDOWS
+
 AZMQ_V1_INLINE_NAMESPACE_END
 } // namespace signal
 } // namespace azmq
@@ -16,6 +16,7 @@
 #include "detail/basic_io_object.hpp"
 #include "detail/send_op.hpp"
 #include "detail/receive_op.hpp"
+#include "detail/wait_op.hpp"
 
 #include <boost/asio/basic_io_object.hpp>
 #include <boost/asio/io_service.hpp>
@@ -23,6 +24,7 @@
 #include <boost/system/error_code.hpp>
 
 #include <type_traits>
+#include <initializer_list>
 
 namespace azmq {
 AZMQ_V1_INLINE_NAMESPACE_BEGIN
@@ -39,9 +41,33 @@ public:
     using flags_type = detail::socket_service::flags_type;
     using more_result_type = detail::socket_service::more_result_type;
     using shutdown_type = detail::socket_service::shutdown_type;
+    using wait_type = detail::socket_service::wait_type;
+    using deadline_type = detail::socket_service::deadline_type;
+
+    /** \brief flag for the buffer sequence overloads of send/receive (and
+     *  their async forms). On send, the buffers are gathered into a single
+     *  frame with one allocation and one copy rather than sent as one frame
+     *  per buffer. On receive, a single frame is scattered across the buffers;
+     *  it is an error (no_buffer_space) if the frame does not fit or if more
+     *  parts follow it.
+     */
+    static constexpr flags_type single_frame = detail::socket_ops::single_frame;
 
     // socket options
     using allow_speculative = detail::socket_service::allow_speculative;
+
+    /** \brief busy poll options. After completing operations, rather than
+     *  immediately waiting on the reactor, the service spins on ZMQ_EVENTS
+     *  for up to busy_poll_spins probes or busy_poll_usec microseconds
+     *  (whichever is exhausted first, 0 disables that budget). This trades
+     *  CPU for latency and is intended for sockets serviced on dedicated cores.
+     *  busy_poll_counters reports how often spinning paid off, setting it
+     *  resets the counters.
+     */
+    using busy_poll_spins = detail::socket_service::busy_poll_spins;
+    using busy_poll_usec = detail::socket_service::busy_poll_usec;
+    using busy_poll_counters = detail::socket_service::busy_poll_counters;
+    using busy_poll_stats = detail::busy_poll_stats;
     using type = opt::integer<ZMQ_TYPE>;
     using rcv_more = opt::integer<ZMQ_RCVMORE>;
     using rcv_hwm = opt::integer<ZMQ_RCVHWM>;
@@ -260,6 +286,36 @@ public:
             throw boost::system::system_error(ec);
     }
 
+    /** \brief Set a range of options on a socket in one pass
+     *  \tparam Iterator forward iterator whose value type conforms to the
+     *  asio SettableSocketOption concept
+     *  \param first start of the range
+     *  \param last end of the range
+     *  \param ec error_code to capture error
+     *  \remark The socket's lock is taken once for the whole range, options
+     *  are applied in order and the first failure stops the remainder.
+     *  \see socket_profile
+     */
+    template<typename Iterator>
+    boost::system::error_code set_options(Iterator first, Iterator last,
+                                          boost::system::error_code & ec) {
+        return get_service().set_options(get_implementation(), first, last, ec);
+    }
+
+    /** \brief Set a range of options on a socket in one pass
+     *  \tparam Iterator forward iterator whose value type conforms to the
+     *  asio SettableSocketOption concept
+     *  \param first start of the range
+     *  \param last end of the range
+     *  \throw boost::system::system_error
+     */
+    template<typename Iterator>
+    void set_options(Iterator first, Iterator last) {
+        boost::system::error_code ec;
+        if (set_options(first, last, ec))
+            throw boost::system::system_error(ec);
+    }
+
     /** \brief Get an option from a socket
      *  \tparam T must conform to the asio GettableSocketOption concept
      *  \param opt T option to get
@@ -465,6 +521,36 @@ public:
         return res;
     }
 
+    /** \brief Send a message, giving it up
+     *  \param msg message to send
+     *  \param flags specifying how the send call is to be made
+     *  \param ec set to indicate what, if any, error occurred
+     *  \remark Without extension send hooks msg is sent as is, nothing is
+     *  copied. Send hooks act on msg itself, and a reference counted copy of
+     *  it (sharing, not duplicating, a large message's data) is held so that
+     *  msg is left as it was given, before any hook changed it, if the send
+     *  fails. msg is left empty if the send succeeds.
+     */
+    std::size_t send(message && msg,
+                     flags_type flags,
+                     boost::system::error_code & ec) {
+        return get_service().send(get_implementation(), std::move(msg), flags, ec);
+    }
+
+    /** \brief Send a message, giving it up
+     *  \param msg message to send
+     *  \param flags specifying how the send call is to be made
+     *  \return bytes transferred
+     */
+    std::size_t send(message && msg,
+                     flags_type flags = 0) {
+        boost::system::error_code ec;
+        auto res = send(std::move(msg), flags, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
     /* \brief Purge remaining message parts from prior receive()
      * \param ec boost::system::error_code &
      * \return size_t number of bytes discarded
@@ -506,9 +592,40 @@ public:
     void async_receive(MutableBufferSequence const& buffers,
                        ReadHandler && handler,
                        flags_type flags = 0) {
+        async_receive(buffers, std::forward<ReadHandler>(handler),
+                      detail::socket_service::no_deadline(), flags);
+    }
+
+    /** \brief Initiate an async receive operation which times out
+     *  \tparam MutableBufferSequence
+     *  \tparam ReadHandler must conform to the asio ReadHandler concept
+     *  \param buffers buffer(s) to fill on receive
+     *  \param handler ReadHandler
+     *  \param deadline steady_clock time at which the receive is abandoned
+     *  \remark
+     *  Works as for async_receive(), except that if no message has arrived
+     *  by the deadline the handler is called with timed_out. Only this
+     *  operation is abandoned, others queued on the socket are unaffected.
+     *  Deadlines are kept by the socket's service in a timing wheel of 1ms
+     *  resolution, so they may run up to a millisecond late.
+     */
+    template<typename MutableBufferSequence,
+             typename ReadHandler>
+    void async_receive(MutableBufferSequence const& buffers,
+                       ReadHandler && handler,
+                       deadline_type deadline,
+                       flags_type flags = 0) {
+        if (get_service().hooks(get_implementation()) & detail::socket_ext::complete_hook) {
+            using hook_type = detail::socket_service::complete_hook_handler<typename std::decay<ReadHandler>::type>;
+            using type = detail::receive_buffer_op<MutableBufferSequence, hook_type>;
+            get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::read_op, deadline,
+                                              buffers, hook_type{ get_implementation(), detail::socket_service::op_type::read_op,
+                                                                  std::forward<ReadHandler>(handler) }, flags);
+            return;
+        }
         using type = detail::receive_buffer_op<MutableBufferSequence, ReadHandler>;
-        get_service().enqueue<type>(get_implementation(), detail::socket_service::op_type::read_op,
-                                    buffers, std::forward<ReadHandler>(handler), flags);
+        get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::read_op, deadline,
+                                          buffers, std::forward<ReadHandler>(handler), flags);
     }
 
     /** \brief Initiate an async receive operation.
@@ -535,6 +652,14 @@ public:
     void async_receive_more(MutableBufferSequence const& buffers,
                             ReadMoreHandler && handler,
                             flags_type flags = 0) {
+        if (get_service().hooks(get_implementation()) & detail::socket_ext::complete_hook) {
+            using hook_type = detail::socket_service::complete_hook_handler<typename std::decay<ReadMoreHandler>::type>;
+            using type = detail::receive_more_buffer_op<MutableBufferSequence, hook_type>;
+            get_service().enqueue<type>(get_implementation(), detail::socket_service::op_type::read_op,
+                                        buffers, hook_type{ get_implementation(), detail::socket_service::op_type::read_op,
+                                                            std::forward<ReadMoreHandler>(handler) }, flags);
+            return;
+        }
         using type = detail::receive_more_buffer_op<MutableBufferSequence, ReadMoreHandler>;
         get_service().enqueue<type>(get_implementation(), detail::socket_service::op_type::read_op,
                                     buffers, std::forward<ReadMoreHandler>(handler), flags);
@@ -561,9 +686,68 @@ public:
     template<typename MessageReadHandler>
     void async_receive(MessageReadHandler && handler,
                        flags_type flags = 0) {
+        async_receive(std::forward<MessageReadHandler>(handler),
+                      detail::socket_service::no_deadline(), flags);
+    }
+
+    /** \brief Initate an async receive operation which times out
+     *  \tparam MessageReadHandler must conform to the MessageReadHandler concept
+     *  \param handler ReadHandler
+     *  \param deadline steady_clock time at which the receive is abandoned
+     *  \param flags int flags
+     *  \remark
+     *  If no message has arrived by the deadline the handler is called with
+     *  timed_out, see async_receive(buffers, handler, deadline, flags).
+     */
+    template<typename MessageReadHandler>
+    void async_receive(MessageReadHandler && handler,
+                       deadline_type deadline,
+                       flags_type flags = 0) {
+        if (get_service().hooks(get_implementation()) & (detail::socket_ext::receive_hook | detail::socket_ext::complete_hook)) {
+            using hook_type = detail::socket_service::receive_hook_handler<typename std::decay<MessageReadHandler>::type>;
+            using type = detail::receive_op<hook_type>;
+            get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::read_op, deadline,
+                                              hook_type{ get_implementation(), std::forward<MessageReadHandler>(handler) },
+                                              flags);
+            return;
+        }
         using type = detail::receive_op<MessageReadHandler>;
-        get_service().enqueue<type>(get_implementation(), detail::socket_service::op_type::read_op,
-                                    std::forward<MessageReadHandler>(handler), flags);
+        get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::read_op, deadline,
+                                          std::forward<MessageReadHandler>(handler), flags);
+    }
+
+    /** \brief Initiate a receive operation which completes once for each
+     *  message, until stopped
+     *  \tparam MessageLoopHandler must conform to the MessageLoopHandler concept
+     *  \param handler MessageLoopHandler
+     *  \param flags int flags
+     *  \remark
+     *  The MessageLoopHandler concept has the following interface
+     *  struct MessageLoopHandler {
+     *      bool operator()(const boost::system::error_code & ec,
+     *                      message & msg,
+     *                      size_t bytes_transferred);
+     *  }
+     *  \remark
+     *  After each message the handler returns true to receive another, or
+     *  false to stop. One op and its message are reused throughout, so
+     *  no memory is allocated per message and the message passed to the
+     *  handler is overwritten by the next; a handler wishing to retain it
+     *  must copy or move it. The loop ends with the handler being called
+     *  with an error, e.g. operation_aborted should the socket be
+     *  cancelled, in which case its return value is ignored.
+     */
+    template<typename MessageLoopHandler>
+    void async_receive_loop(MessageLoopHandler && handler,
+                            flags_type flags = 0) {
+        if (get_service().hooks(get_implementation()) & (detail::socket_ext::receive_hook | detail::socket_ext::complete_hook)) {
+            using hook_type = detail::socket_service::receive_loop_hook_handler<typename std::decay<MessageLoopHandler>::type>;
+            get_service().enqueue_receive_loop(get_implementation(),
+                                               hook_type{ { get_implementation(), std::forward<MessageLoopHandler>(handler) } },
+                                               flags);
+            return;
+        }
+        get_service().enqueue_receive_loop(get_implementation(), std::forward<MessageLoopHandler>(handler), flags);
     }
 
     /** \brief Initiate an async send operation
@@ -581,9 +765,39 @@ public:
     void async_send(ConstBufferSequence const& buffers,
                     WriteHandler && handler,
                     flags_type flags = 0) {
+        async_send(buffers, std::forward<WriteHandler>(handler),
+                   detail::socket_service::no_deadline(), flags);
+    }
+
+    /** \brief Initiate an async send operation which times out
+     *  \tparam ConstBufferSequence must conform to the asio
+     *          ConstBufferSequence concept
+     *  \tparam WriteHandler must conform to the asio
+     *          WriteHandler concept
+     *  \param deadline steady_clock time at which the send is abandoned
+     *  \param flags specifying how the send call is to be made
+     *  \remark
+     *  If the socket has not accepted the message by the deadline the
+     *  handler is called with timed_out, see
+     *  async_receive(buffers, handler, deadline, flags).
+     */
+    template<typename ConstBufferSequence,
+             typename WriteHandler>
+    void async_send(ConstBufferSequence const& buffers,
+                    WriteHandler && handler,
+                    deadline_type deadline,
+                    flags_type flags = 0) {
+        if (get_service().hooks(get_implementation()) & detail::socket_ext::complete_hook) {
+            using hook_type = detail::socket_service::complete_hook_handler<typename std::decay<WriteHandler>::type>;
+            using type = detail::send_buffer_op<ConstBufferSequence, hook_type>;
+            get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::write_op, deadline,
+                                              buffers, hook_type{ get_implementation(), detail::socket_service::op_type::write_op,
+                                                                  std::forward<WriteHandler>(handler) }, flags);
+            return;
+        }
         using type = detail::send_buffer_op<ConstBufferSequence, WriteHandler>;
-        get_service().enqueue<type>(get_implementation(), detail::socket_service::op_type::write_op,
-                                    buffers, std::forward<WriteHandler>(handler), flags);
+        get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::write_op, deadline,
+                                          buffers, std::forward<WriteHandler>(handler), flags);
     }
 
     /** \brief Initate an async send operation
@@ -591,14 +805,119 @@ public:
      *  \param msg message reference
      *  \param handler WriteHandler
      *  \param flags int flags
+     *  \remark The operation sends a copy of msg, which shares msg's content
+     *  at the cost of a reference count, or copies it if it is small.
      */
     template<typename WriteHandler>
     void async_send(message const& msg,
                     WriteHandler && handler,
                     flags_type flags = 0) {
+        async_send(message(msg), std::forward<WriteHandler>(handler),
+                   detail::socket_service::no_deadline(), flags);
+    }
+
+    /** \brief Initate an async send operation which times out
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept
+     *  \param msg message reference
+     *  \param handler WriteHandler
+     *  \param deadline steady_clock time at which the send is abandoned
+     *  \param flags int flags
+     */
+    template<typename WriteHandler>
+    void async_send(message const& msg,
+                    WriteHandler && handler,
+                    deadline_type deadline,
+                    flags_type flags = 0) {
+        async_send(message(msg), std::forward<WriteHandler>(handler), deadline, flags);
+    }
+
+    /** \brief Initate an async send operation, giving up the message
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept
+     *  \param msg message to send, moved into the operation
+     *  \param handler WriteHandler
+     *  \param flags int flags
+     */
+    template<typename WriteHandler>
+    void async_send(message && msg,
+                    WriteHandler && handler,
+                    flags_type flags = 0) {
+        async_send(std::move(msg), std::forward<WriteHandler>(handler),
+                   detail::socket_service::no_deadline(), flags);
+    }
+
+    /** \brief Initate an async send operation which times out, giving up the
+     *  message
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept
+     *  \param msg message to send, moved into the operation
+     *  \param handler WriteHandler
+     *  \param deadline steady_clock time at which the send is abandoned
+     *  \param flags int flags
+     */
+    template<typename WriteHandler>
+    void async_send(message && msg,
+                    WriteHandler && handler,
+                    deadline_type deadline,
+                    flags_type flags = 0) {
+        auto hooks = get_service().hooks(get_implementation());
+        // as with the synchronous send, a failed send hook fails the send
+        boost::system::error_code ec;
+        if (hooks & detail::socket_ext::send_hook)
+            get_service().on_send(get_implementation(), msg, flags, ec);
+        if (hooks & detail::socket_ext::sent_hook) {
+            using hook_type = detail::socket_service::sent_hook_handler<typename std::decay<WriteHandler>::type>;
+            using type = detail::send_op<hook_type>;
+            hook_type h{ get_implementation(), message(msg), flags, std::forward<WriteHandler>(handler) };
+            if (ec) {
+                get_service().post_send_error(std::move(h), ec);
+                return;
+            }
+            get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::write_op, deadline,
+                                              std::move(msg), std::move(h), flags);
+            return;
+        }
+        if (hooks & detail::socket_ext::complete_hook) {
+            using hook_type = detail::socket_service::complete_hook_handler<typename std::decay<WriteHandler>::type>;
+            using type = detail::send_op<hook_type>;
+            hook_type h{ get_implementation(), detail::socket_service::op_type::write_op,
+                         std::forward<WriteHandler>(handler) };
+            if (ec) {
+                get_service().post_send_error(std::move(h), ec);
+                return;
+            }
+            get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::write_op, deadline,
+                                              std::move(msg), std::move(h), flags);
+            return;
+        }
+        if (ec) {
+            get_service().post_send_error(std::forward<WriteHandler>(handler), ec);
+            return;
+        }
         using type = detail::send_op<WriteHandler>;
-        get_service().enqueue<type>(get_implementation(), detail::socket_service::op_type::write_op,
-                                    msg, std::forward<WriteHandler>(handler), flags);
+        get_service().enqueue_until<type>(get_implementation(), detail::socket_service::op_type::write_op, deadline,
+                                          std::move(msg), std::forward<WriteHandler>(handler), flags);
+    }
+
+    /** \brief Initiate an async wait for a socket to become readable or
+     *  writable
+     *  \tparam WaitHandler must conform to the asio WaitHandler concept
+     *  \param w wait_type::read or wait_type::write
+     *  \param handler WaitHandler
+     *  \remark
+     *  No message is transferred. The wait is queued with the socket's other
+     *  operations of the same direction, so it completes after any receives
+     *  (or sends) issued before it. A consumer can use a single wakeup to
+     *  drain the socket with synchronous ZMQ_DONTWAIT calls until they report
+     *  EAGAIN, then wait again.
+     */
+    template<typename WaitHandler>
+    void async_wait(wait_type w, WaitHandler && handler) {
+        using type = detail::wait_op<typename std::decay<WaitHandler>::type>;
+        auto read = w == wait_type::read;
+        get_service().enqueue<type>(get_implementation(),
+                                    read ? detail::socket_service::op_type::read_op
+                                         : detail::socket_service::op_type::write_op,
+                                    read ? ZMQ_POLLIN : ZMQ_POLLOUT,
+                                    std::forward<WaitHandler>(handler));
     }
 
     /** \brief Initiate shutdown of socket
@@ -643,6 +962,46 @@ public:
         return get_service().native_handle(get_implementation());
     }
 
+#ifdef ZMQ_BUILD_DRAFT_API
+    /** \brief join a group, for ZMQ_DISH sockets
+     *  \param group std::string const& group to join
+     *  \param ec error_code to set on error
+     */
+    boost::system::error_code join(std::string const& group,
+                                   boost::system::error_code & ec) {
+        return get_service().join(get_implementation(), group, ec);
+    }
+
+    /** \brief join a group, for ZMQ_DISH sockets
+     *  \param group std::string const& group to join
+     *  \throw boost::system::system_error
+     */
+    void join(std::string const& group) {
+        boost::system::error_code ec;
+        if (join(group, ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief leave a group, for ZMQ_DISH sockets
+     *  \param group std::string const& group to leave
+     *  \param ec error_code to set on error
+     */
+    boost::system::error_code leave(std::string const& group,
+                                    boost::system::error_code & ec) {
+        return get_service().leave(get_implementation(), group, ec);
+    }
+
+    /** \brief leave a group, for ZMQ_DISH sockets
+     *  \param group std::string const& group to leave
+     *  \throw boost::system::system_error
+     */
+    void leave(std::string const& group) {
+        boost::system::error_code ec;
+        if (leave(group, ec))
+            throw boost::system::system_error(ec);
+    }
+#endif
+
     /** \brief monitor events on a socket
         *  \param ios io_service on which to bind the returned monitor socket
         *  \param events int mask of events to publish to returned socket
@@ -725,6 +1084,36 @@ using push_socket = detail::specialized_socket<ZMQ_PUSH>;
 using pull_socket = detail::specialized_socket<ZMQ_PULL>;
 using stream_socket = detail::specialized_socket<ZMQ_STREAM>;
 
+#ifdef ZMQ_BUILD_DRAFT_API
+/** \brief draft thread-safe socket types
+ *  \remark These types are safe to share between threads, do not support
+ *  multipart messages and use message::routing_id() (SERVER/CLIENT) or
+ *  message::group() (RADIO/DISH) for addressing. They have no ZMQ_FD, so
+ *  readiness is obtained through a zmq_poller, and synchronous send/receive
+ *  do not serialize on azmq's per-socket lock.
+ */
+using server_socket = detail::specialized_socket<ZMQ_SERVER>;
+using client_socket = detail::specialized_socket<ZMQ_CLIENT>;
+using radio_socket = detail::specialized_socket<ZMQ_RADIO>;
+using dish_socket = detail::specialized_socket<ZMQ_DISH>;
+using scatter_socket = detail::specialized_socket<ZMQ_SCATTER>;
+using gather_socket = detail::specialized_socket<ZMQ_GATHER>;
+#endif
+
+/** \brief socket affinity option restricting a socket's connections to
+ *  particular libzmq io threads of its context
+ *  \param io_threads zero based io thread indices, each less than the
+ *  context's io_threads and less than 64
+ *  \remark Combine with azmq::dedicate_cpus() to give hot sockets io threads
+ *  on dedicated cores. Must be set before bind or connect.
+ */
+inline socket::affinity io_thread_affinity(std::initializer_list<unsigned> io_threads) {
+    uint64_t mask = 0;
+    for (auto t : io_threads)
+        mask |= detail::context_ops::io_thread_mask(t);
+    return socket::affinity(mask);
+}
+
 /** \brief attach a socket to a range of endpoints
  *  \tparam Iterator iterator to a sequence of endpoints
  *  \param s socket& to attach to supplied endpoints
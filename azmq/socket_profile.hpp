@@ -0,0 +1,195 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_SOCKET_PROFILE_HPP_
+#define AZMQ_SOCKET_PROFILE_HPP_
+
+#include "socket.hpp"
+
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief A precomputed set of socket options, applied to a socket in one
+ *  pass
+ *  \remark Options are held as their name and raw value, in the order first
+ *  set; setting an option already in the profile replaces its value. Any
+ *  option accepted by socket::set_option may be held, including azmq's own
+ *  and those of installed extensions.
+ */
+class socket_profile {
+public:
+    /** \brief an option captured by name and value */
+    class option {
+    public:
+        template<typename Option>
+        explicit option(Option const& opt)
+            : name_(opt.name())
+            , value_(static_cast<char const*>(opt.data()),
+                     static_cast<char const*>(opt.data()) + opt.size())
+        { }
+
+        int name() const { return name_; }
+        void const* data() const { return value_.data(); }
+        void* data() { return value_.data(); }
+        size_t size() const { return value_.size(); }
+
+    private:
+        friend class socket_profile;
+
+        int name_;
+        std::vector<char> value_;
+    };
+
+    using const_iterator = std::vector<option>::const_iterator;
+
+    /** \brief add an option to the profile, or replace its value
+     *  \param opt option conforming to the asio SettableSocketOption concept
+     */
+    template<typename Option>
+    socket_profile & set(Option const& opt) {
+        option o(opt);
+        auto it = std::find_if(std::begin(options_), std::end(options_),
+                               [&](option const& x) { return x.name_ == o.name_; });
+        if (it != std::end(options_))
+            *it = std::move(o);
+        else
+            options_.push_back(std::move(o));
+        return *this;
+    }
+
+    size_t size() const { return options_.size(); }
+    bool empty() const { return options_.empty(); }
+    const_iterator begin() const { return options_.begin(); }
+    const_iterator end() const { return options_.end(); }
+
+    /** \brief apply the profile to a socket
+     *  \param s socket
+     *  \param ec error_code to capture the first option which failed
+     */
+    boost::system::error_code apply(socket & s, boost::system::error_code & ec) const {
+        return s.set_options(options_.begin(), options_.end(), ec);
+    }
+
+    /** \brief apply the profile to a socket
+     *  \param s socket
+     *  \throw boost::system::system_error
+     */
+    void apply(socket & s) const {
+        boost::system::error_code ec;
+        if (apply(s, ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief preset for request/response and market data style traffic
+     *  \remark Small HWMs and kernel buffers bound queueing delay, immediate
+     *  keeps messages off connections which have not completed, linger is
+     *  zero so closing never blocks, and TCP keepalive detects dead peers
+     *  within about 15 seconds.
+     */
+    static socket_profile low_latency() {
+        socket_profile res;
+        res.set(socket::snd_hwm(1000))
+           .set(socket::rcv_hwm(1000))
+           .set(socket::snd_buf(64 * 1024))
+           .set(socket::rcv_buf(64 * 1024))
+           .set(socket::immediate(true))
+           .set(socket::linger(0))
+           .set(socket::tcp_keepalive(1))
+           .set(socket::tcp_keepalive_idle(10))
+           .set(socket::tcp_keepalive_intvl(1))
+           .set(socket::tcp_keepalive_cnt(5));
+        return res;
+    }
+
+    /** \brief preset for bulk transfer
+     *  \remark Large HWMs and kernel buffers keep the pipes full, messages
+     *  may queue to connections still being established, and TCP keepalive
+     *  runs at the slower pace typical of long lived links.
+     */
+    static socket_profile high_throughput() {
+        socket_profile res;
+        res.set(socket::snd_hwm(100000))
+           .set(socket::rcv_hwm(100000))
+           .set(socket::snd_buf(4 * 1024 * 1024))
+           .set(socket::rcv_buf(4 * 1024 * 1024))
+           .set(socket::immediate(false))
+           .set(socket::linger(1000))
+           .set(socket::tcp_keepalive(1))
+           .set(socket::tcp_keepalive_idle(60))
+           .set(socket::tcp_keepalive_intvl(10))
+           .set(socket::tcp_keepalive_cnt(6));
+        return res;
+    }
+
+private:
+    std::vector<option> options_;
+};
+
+/** \brief Creates sockets of one type configured from a socket_profile
+ *  \remark The profile is validated once, when the factory is constructed,
+ *  by applying it to a probe socket; each socket created thereafter has the
+ *  whole profile applied under a single acquisition of its lock.
+ */
+class socket_factory {
+public:
+    /** \brief construct a factory
+     *  \param ios io_service on which sockets are created
+     *  \param type socket type
+     *  \param profile options applied to every socket
+     *  \param optimize_single_threaded see socket::socket
+     *  \throw boost::system::system_error if the profile can not be applied
+     *  to a socket of this type
+     */
+    socket_factory(boost::asio::io_service & ios, int type, socket_profile profile,
+                   bool optimize_single_threaded = false)
+        : ios_(ios)
+        , type_(type)
+        , profile_(std::move(profile))
+        , optimize_single_threaded_(optimize_single_threaded)
+    {
+        socket probe(ios_, type_, optimize_single_threaded_);
+        profile_.apply(probe);
+    }
+
+    socket_profile const& profile() const { return profile_; }
+
+    /** \brief create a socket
+     *  \throw boost::system::system_error
+     */
+    socket create() const {
+        socket res(ios_, type_, optimize_single_threaded_);
+        profile_.apply(res);
+        return res;
+    }
+
+    /** \brief create count sockets
+     *  \throw boost::system::system_error
+     */
+    std::vector<socket> create(size_t count) const {
+        std::vector<socket> res;
+        res.reserve(count);
+        for (size_t i = 0; i != count; ++i)
+            res.push_back(create());
+        return res;
+    }
+
+private:
+    boost::asio::io_service & ios_;
+    int const type_;
+    socket_profile const profile_;
+    bool const optimize_single_threaded_;
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_SOCKET_PROFILE_HPP_
@@ -0,0 +1,221 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_SPILL_HPP_
+#define AZMQ_SPILL_HPP_
+
+#include "socket.hpp"
+#include "message.hpp"
+#include "error.hpp"
+#include "detail/spill_log.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief Store and forward sender for PUSH, DEALER and similar outgoing
+ *  sockets, spilling to disk when the peer falls behind
+ *  \remark send() never blocks. A message is written straight to the socket
+ *  when nothing is queued and the socket's HWM has room; otherwise it is
+ *  queued in memory up to memory_budget bytes, and beyond that appended to a
+ *  segmented, memory mapped queue on disk. Queued messages are written in
+ *  order as the socket becomes writable again, memory first and then disk,
+ *  so a stalled consumer costs disk space rather than memory or throughput.
+ *  \remark Messages are single frame. The on-disk queue is transient,
+ *  messages still queued when the sender is destroyed are discarded.
+ *  \remark Like socket, a spill_sender is not thread safe and should be used
+ *  from the socket's io_service. It is neither copyable nor movable.
+ */
+class spill_sender {
+public:
+    /** \brief queue depth and counters */
+    struct spill_stats {
+        uint64_t sent = 0;              // messages written to the socket
+        uint64_t spilled = 0;           // messages which went to disk
+        uint64_t dropped = 0;           // messages lost to socket or disk errors
+        size_t memory_messages = 0;     // messages queued in memory
+        size_t memory_bytes = 0;
+        size_t disk_messages = 0;       // messages queued on disk
+        size_t disk_bytes = 0;
+        size_t segments = 0;            // segment files on disk
+    };
+
+    /** \brief construct a spill_sender
+     *  \param s outgoing socket
+     *  \param directory where segment files are created
+     *  \param memory_budget bytes of messages held in memory before spilling
+     *  \param segment_size size of each segment file
+     */
+    spill_sender(socket s, std::string directory,
+                 size_t memory_budget = 16 * 1024 * 1024,
+                 size_t segment_size = 64 * 1024 * 1024)
+        : state_(std::make_shared<state>(std::move(s), std::move(directory), memory_budget, segment_size))
+    { }
+
+    spill_sender(spill_sender const&) = delete;
+    spill_sender & operator=(spill_sender const&) = delete;
+
+    ~spill_sender() {
+        boost::system::error_code ec;
+        state_->socket_.cancel(ec);
+    }
+
+    socket & get_socket() { return state_->socket_; }
+
+    /** \brief send a message, or queue it if the socket is not writable
+     *  \param msg message to send
+     *  \param ec set if the message could neither be sent nor queued, it is
+     *  then dropped and counted
+     *  \return true if the message was sent or queued
+     */
+    bool send(message const& msg, boost::system::error_code & ec) {
+        return state::send(state_, msg, ec);
+    }
+
+    /** \brief send a message, or queue it if the socket is not writable
+     *  \throw boost::system::system_error
+     */
+    void send(message const& msg) {
+        boost::system::error_code ec;
+        if (!send(msg, ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief number of messages waiting to be written, including one being
+     *  written asynchronously
+     */
+    size_t depth() const {
+        return state_->memory_.size() + state_->disk_.size() + (state_->in_flight_ ? 1 : 0);
+    }
+
+    /** \brief queue depth and counters */
+    spill_stats stats() const {
+        auto res = state_->stats_;
+        res.memory_messages = state_->memory_.size();
+        res.memory_bytes = state_->memory_bytes_;
+        res.disk_messages = state_->disk_.size();
+        res.disk_bytes = state_->disk_.bytes();
+        res.segments = state_->disk_.segments();
+        return res;
+    }
+
+private:
+    struct state {
+        using ptr = std::shared_ptr<state>;
+        using weak_ptr = std::weak_ptr<state>;
+
+        socket socket_;
+        size_t const memory_budget_;
+        std::deque<message> memory_;
+        size_t memory_bytes_ = 0;
+        detail::spill_log disk_;
+        bool in_flight_ = false;
+        spill_stats stats_;
+
+        state(socket s, std::string directory, size_t memory_budget, size_t segment_size)
+            : socket_(std::move(s))
+            , memory_budget_(memory_budget)
+            , disk_(std::move(directory), segment_size)
+        { }
+
+        bool queued() const { return in_flight_ || !memory_.empty() || !disk_.empty(); }
+
+        static bool send(ptr const& p, message const& msg, boost::system::error_code & ec) {
+            if (!p->queued()) {
+                p->socket_.send(msg, ZMQ_DONTWAIT, ec);
+                if (!ec) {
+                    ++p->stats_.sent;
+                    return true;
+                }
+                if (ec.value() != EAGAIN) {
+                    ++p->stats_.dropped;
+                    return false;
+                }
+                ec = boost::system::error_code();
+            }
+            // once anything is on disk, later messages follow it there
+            if (p->disk_.empty() && p->memory_bytes_ + msg.size() <= p->memory_budget_) {
+                p->memory_.push_back(msg);
+                p->memory_bytes_ += msg.size();
+            } else if (p->disk_.push(msg.cbuffer(), ec)) {
+                ++p->stats_.dropped;
+                return false;
+            } else {
+                ++p->stats_.spilled;
+            }
+            if (!p->in_flight_)
+                drain(p);
+            return true;
+        }
+
+        // removes and returns the oldest queued message
+        message pop() {
+            if (!memory_.empty()) {
+                auto res = std::move(memory_.front());
+                memory_.pop_front();
+                memory_bytes_ -= res.size();
+                return res;
+            }
+            message res(disk_.front());
+            boost::system::error_code ec;
+            if (disk_.pop(ec)) {
+                stats_.dropped += disk_.size();
+                disk_.clear();
+            }
+            return res;
+        }
+
+        // writes queued messages while the socket accepts them, then waits
+        // for it to become writable with an async send of the next one
+        static void drain(ptr const& p) {
+            while (!p->memory_.empty() || !p->disk_.empty()) {
+                auto msg = p->pop();
+                boost::system::error_code ec;
+                p->socket_.send(msg, ZMQ_DONTWAIT, ec);
+                if (!ec) {
+                    ++p->stats_.sent;
+                    continue;
+                }
+                if (ec.value() != EAGAIN) {
+                    ++p->stats_.dropped;
+                    continue;
+                }
+                p->in_flight_ = true;
+                weak_ptr w = p;
+                p->socket_.async_send(std::move(msg), [w](boost::system::error_code const& ec, size_t) {
+                    auto p = w.lock();
+                    if (!p)
+                        return;
+                    p->in_flight_ = false;
+                    if (ec == boost::asio::error::operation_aborted)
+                        return;
+                    if (ec)
+                        ++p->stats_.dropped;
+                    else
+                        ++p->stats_.sent;
+                    drain(p);
+                });
+                return;
+            }
+        }
+    };
+
+    std::shared_ptr<state> state_;
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_SPILL_HPP_
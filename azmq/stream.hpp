@@ -0,0 +1,123 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_STREAM_HPP_
+#define AZMQ_STREAM_HPP_
+
+#include "socket.hpp"
+#include "detail/stream_ops.hpp"
+
+#include <boost/asio/buffer.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <unistd.h>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+    /** \brief Source reading from a buffer, which must remain valid until the
+     *  stream has been sent
+     */
+    class buffer_source {
+    public:
+        explicit buffer_source(boost::asio::const_buffer buffer)
+            : buffer_(buffer)
+        { }
+
+        size_t operator()(boost::asio::mutable_buffer chunk) {
+            auto n = boost::asio::buffer_copy(chunk, buffer_);
+            buffer_ = buffer_ + n;
+            return n;
+        }
+
+    private:
+        boost::asio::const_buffer buffer_;
+    };
+
+    /** \brief Source reading from a file descriptor, until end of file or a
+     *  read error
+     *  \remark the descriptor is not closed, and reads block
+     */
+    class descriptor_source {
+    public:
+        explicit descriptor_source(int fd)
+            : fd_(fd)
+        { }
+
+        size_t operator()(boost::asio::mutable_buffer chunk) {
+            auto p = boost::asio::buffer_cast<char*>(chunk);
+            auto size = boost::asio::buffer_size(chunk);
+            size_t res = 0;
+            while (res < size) {
+                auto n = ::read(fd_, p + res, size - res);
+                if (n <= 0)
+                    break;
+                res += n;
+            }
+            return res;
+        }
+
+    private:
+        int fd_;
+    };
+
+    /** \brief Send a large object as a stream of fixed size chunks
+     *  \tparam Source callable as size_t(boost::asio::mutable_buffer), filling
+     *  the buffer with the next part of the object and returning the number of
+     *  bytes written, zero at the end of the object. buffer_source and
+     *  descriptor_source are provided, a generator may be any such callable.
+     *  \tparam WriteHandler must conform to the asio WriteHandler concept, and
+     *  is passed the total number of bytes streamed
+     *  \param s socket to send on, no other sends may be issued on it until the
+     *  stream completes
+     *  \param source Source
+     *  \param handler WriteHandler
+     *  \param chunk_size size of each chunk
+     *  \param window maximum number of chunks queued on the socket at once
+     *
+     *  \remark Each chunk is sent as a two part message, a sequence header and
+     *  the data, and the stream is terminated by an empty chunk. At most window
+     *  chunks are allocated at any time, so the memory used by the sender is
+     *  bounded by chunk_size * window regardless of the size of the object.
+     */
+    template<typename Source, typename WriteHandler>
+    void async_send_stream(socket & s, Source && source, WriteHandler && handler,
+                           size_t chunk_size = 65536, size_t window = 4) {
+        using type = detail::send_stream_op<typename std::decay<Source>::type,
+                                            typename std::decay<WriteHandler>::type>;
+        std::make_shared<type>(s, std::forward<Source>(source), std::forward<WriteHandler>(handler),
+                               chunk_size, window)->pump();
+    }
+
+    /** \brief Receive a stream sent by async_send_stream, passing each chunk to
+     *  a sink as it arrives
+     *  \tparam Sink callable as void(boost::asio::const_buffer), the buffer is
+     *  only valid for the duration of the call
+     *  \tparam ReadHandler must conform to the asio ReadHandler concept, and is
+     *  passed the total number of bytes streamed
+     *  \param s socket to receive on
+     *  \param sink Sink
+     *  \param handler ReadHandler
+     *
+     *  \remark Only one chunk is held at a time. A message which is not the
+     *  expected chunk completes the handler with errc::protocol_error.
+     */
+    template<typename Sink, typename ReadHandler>
+    void async_receive_stream(socket & s, Sink && sink, ReadHandler && handler) {
+        using type = detail::receive_stream_op<typename std::decay<Sink>::type,
+                                               typename std::decay<ReadHandler>::type>;
+        std::make_shared<type>(s, std::forward<Sink>(sink), std::forward<ReadHandler>(handler))->start();
+    }
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_STREAM_HPP_
@@ -0,0 +1,232 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#ifndef AZMQ_TOPIC_ROUTER_HPP_
+#define AZMQ_TOPIC_ROUTER_HPP_
+
+#include "socket.hpp"
+#include "message.hpp"
+#include "detail/topic_trie.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace azmq {
+AZMQ_V1_INLINE_NAMESPACE_BEGIN
+
+/** \brief Dispatches messages received on a subscriber socket to handlers by
+ *  topic prefix
+ *  \remark The router takes ownership of a sub_socket and receives on it from
+ *  the socket's io_service, draining up to batch_size messages per wakeup.
+ *  Adding and removing routes subscribes and unsubscribes the socket, so its
+ *  subscriptions always mirror the routing table.
+ *  \remark Routes are held in a prefix trie and each message is dispatched to
+ *  the handler of the longest route that is a prefix of its first frame. The
+ *  frame is matched in place and passed to the handler without copying.
+ *  \remark add(), remove() and the handlers run on the socket's io_service;
+ *  add() and remove() may also be called before it is run.
+ *  \remark A failed receive is counted and the router carries on receiving,
+ *  unless it was cancelled, the socket shut down or its context terminated.
+ *  Should a failure repeat the previous receive's error, the router backs
+ *  off before receiving again, for 1ms doubling with each repeat up to a
+ *  second.
+ *  \remark topic_router is neither copyable nor movable
+ */
+class topic_router {
+public:
+    /** \brief handler invoked with the first frame of each routed message
+     *  \remark Further parts may be received synchronously from get_socket();
+     *  any the handler leaves unread are discarded.
+     */
+    using handler_type = std::function<void(message & msg)>;
+
+    /** \brief construct a router over a subscriber socket and start receiving
+     *  \param s socket, normally a sub_socket or xsub_socket
+     *  \param batch_size maximum number of messages received per wakeup
+     */
+    explicit topic_router(socket s, size_t batch_size = 64)
+        : state_(std::make_shared<state>(std::move(s), batch_size))
+    {
+        state::start(state_);
+    }
+
+    topic_router(topic_router const&) = delete;
+    topic_router & operator=(topic_router const&) = delete;
+
+    ~topic_router() {
+        boost::system::error_code ec;
+        state_->socket_.cancel(ec);
+        state_->retry_.cancel(ec);
+    }
+
+    socket & get_socket() { return state_->socket_; }
+
+    /** \brief route messages with the given topic prefix to a handler,
+     *  subscribing to it
+     *  \param prefix topic prefix, empty to match every message
+     *  \param handler handler_type, replaces any existing handler for prefix
+     *  \param ec set to indicate what, if any, error occurred
+     */
+    boost::system::error_code add(std::string_view prefix, handler_type handler,
+                                  boost::system::error_code & ec) {
+        auto & s = *state_;
+        if (auto h = s.routes_.find(prefix)) {
+            *h = std::make_shared<handler_type>(std::move(handler));
+            return ec;
+        }
+        if (s.socket_.set_option(socket::subscribe(prefix.data(), prefix.size()), ec))
+            return ec;
+        s.routes_.insert(prefix, std::make_shared<handler_type>(std::move(handler)));
+        return ec;
+    }
+
+    /** \brief route messages with the given topic prefix to a handler,
+     *  subscribing to it
+     *  \throw boost::system::system_error
+     */
+    void add(std::string_view prefix, handler_type handler) {
+        boost::system::error_code ec;
+        if (add(prefix, std::move(handler), ec))
+            throw boost::system::system_error(ec);
+    }
+
+    /** \brief remove the route for a topic prefix, unsubscribing from it
+     *  \param prefix topic prefix previously passed to add()
+     *  \param ec set to indicate what, if any, error occurred
+     *  \return true if the route was present
+     */
+    bool remove(std::string_view prefix, boost::system::error_code & ec) {
+        auto & s = *state_;
+        if (!s.routes_.find(prefix))
+            return false;
+        if (s.socket_.set_option(socket::unsubscribe(prefix.data(), prefix.size()), ec))
+            return false;
+        return s.routes_.erase(prefix);
+    }
+
+    /** \brief remove the route for a topic prefix, unsubscribing from it
+     *  \throw boost::system::system_error
+     */
+    bool remove(std::string_view prefix) {
+        boost::system::error_code ec;
+        auto res = remove(prefix, ec);
+        if (ec)
+            throw boost::system::system_error(ec);
+        return res;
+    }
+
+    /** \brief number of routes */
+    size_t size() const { return state_->routes_.size(); }
+
+    /** \brief number of messages received which matched no route, e.g. after
+     *  a route was removed but before the publisher saw the unsubscription
+     */
+    uint64_t unrouted() const { return state_->unrouted_; }
+
+    /** \brief number of receives which failed */
+    uint64_t errors() const { return state_->errors_; }
+
+private:
+    struct state {
+        using ptr = std::shared_ptr<state>;
+        using weak_ptr = std::weak_ptr<state>;
+
+        socket socket_;
+        size_t const batch_size_;
+        // handlers are shared so that one may add or remove routes while it
+        // is running
+        detail::topic_trie<std::shared_ptr<handler_type>> routes_;
+        message msg_;
+        uint64_t unrouted_ = 0;
+        uint64_t errors_ = 0;
+        boost::system::error_code last_error_; // of the previous receive
+        boost::asio::steady_timer retry_;
+        std::chrono::milliseconds backoff_{ 0 };
+
+        state(socket s, size_t batch_size)
+            : socket_(std::move(s))
+            , batch_size_(batch_size ? batch_size : 1)
+            , retry_(socket_.get_io_service())
+        { }
+
+        static void start(ptr const& p) {
+            weak_ptr w = p;
+            p->socket_.async_receive([w](boost::system::error_code const& ec, message & msg, size_t) {
+                if (ec == boost::asio::error::operation_aborted)
+                    return;
+                auto p = w.lock();
+                if (!p)
+                    return;
+                if (ec) {
+                    ++p->errors_;
+                    if (!detail::socket_ops::ends_receive(ec))
+                        retry(p, ec);
+                    return;
+                }
+                p->last_error_.clear();
+                p->backoff_ = std::chrono::milliseconds(0);
+                p->dispatch(msg);
+                for (size_t i = 1; i != p->batch_size_; ++i) {
+                    boost::system::error_code rec;
+                    p->socket_.receive(p->msg_, ZMQ_DONTWAIT, rec);
+                    if (rec)
+                        break;
+                    p->dispatch(p->msg_);
+                }
+                start(p);
+            });
+        }
+
+        static void retry(ptr const& p, boost::system::error_code const& ec) {
+            if (ec != p->last_error_) {
+                p->last_error_ = ec;
+                p->backoff_ = std::chrono::milliseconds(0);
+                start(p);
+                return;
+            }
+            p->backoff_ = std::min(std::max(p->backoff_ * 2, std::chrono::milliseconds(1)),
+                                   std::chrono::milliseconds(1000));
+            weak_ptr w = p;
+            p->retry_.expires_from_now(p->backoff_);
+            p->retry_.async_wait([w](boost::system::error_code const& ec) {
+                if (ec)
+                    return;
+                if (auto p = w.lock())
+                    start(p);
+            });
+        }
+
+        void dispatch(message & msg) {
+            auto topic = msg.cbuffer();
+            auto p = routes_.match(boost::asio::buffer_cast<void const*>(topic),
+                                   boost::asio::buffer_size(topic));
+            if (p && *p && **p) {
+                auto h = *p;
+                (*h)(msg);
+            }
+            else
+                ++unrouted_;
+            boost::system::error_code ec;
+            socket_.flush(ec);
+        }
+    };
+
+    std::shared_ptr<state> state_;
+};
+
+AZMQ_V1_INLINE_NAMESPACE_END
+} // namespace azmq
+#endif // AZMQ_TOPIC_ROUTER_HPP_
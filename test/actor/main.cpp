@@ -12,6 +12,11 @@
 #include <boost/asio/buffer.hpp>
 
 #include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
 #include <thread>
 #include <iostream>
 
@@ -66,3 +71,151 @@ TEST_CASE( "Async Send/Receive", "[actor]" ) {
     REQUIRE(ecb == boost::system::error_code());
     REQUIRE(btb == 4);
 }
+
+void pooled_echo(azmq::socket & ss) {
+    ss.async_receive([&ss](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+        if (ec)
+            return;
+        ss.send(msg);
+        pooled_echo(ss);
+    });
+}
+
+TEST_CASE( "Pooled actors", "[actor]" ) {
+    boost::asio::io_service ios;
+    azmq::actor::pool pool(2);
+    REQUIRE(pool.size() == 2);
+
+    std::vector<azmq::socket> peers;
+    for (auto i = 0; i < 16; ++i)
+        peers.emplace_back(azmq::actor::spawn(ios, pool, pooled_echo));
+
+    for (auto i = 0; i < 16; ++i) {
+        auto& s = peers[i];
+        s.send(boost::asio::buffer(&i, sizeof(i)));
+        int res = -1;
+        REQUIRE(s.receive(boost::asio::buffer(&res, sizeof(res))) == sizeof(res));
+        REQUIRE(res == i);
+
+        azmq::actor::is_alive alive;
+        s.get_option(alive);
+        REQUIRE(alive.value());
+    }
+}
+
+TEST_CASE( "Pooled actor last_error", "[actor]" ) {
+    boost::asio::io_service ios;
+    azmq::actor::pool pool(1);
+
+    auto s = azmq::actor::spawn(ios, pool, [](azmq::socket &) {
+        throw std::runtime_error("pooled actor failed");
+    });
+
+    azmq::actor::is_alive alive;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        s.get_option(alive);
+    } while (alive.value());
+
+    azmq::actor::last_error error;
+    s.get_option(error);
+    REQUIRE(error.value());
+    REQUIRE_THROWS_AS(std::rethrow_exception(error.value()), std::runtime_error const&);
+}
+
+TEST_CASE( "Pooled actor handler error", "[actor]" ) {
+    boost::asio::io_service ios;
+    azmq::actor::pool pool(1);
+
+    auto s = azmq::actor::spawn(ios, pool, [](azmq::socket & ss) {
+        ss.async_receive([](boost::system::error_code const& ec, azmq::message &, size_t) {
+            if (!ec)
+                throw std::runtime_error("pooled handler failed");
+        });
+    });
+    s.send(boost::asio::buffer("A"));
+
+    azmq::actor::is_alive alive;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        s.get_option(alive);
+    } while (alive.value());
+
+    azmq::actor::last_error error;
+    s.get_option(error);
+    REQUIRE(error.value());
+    REQUIRE_THROWS_AS(std::rethrow_exception(error.value()), std::runtime_error const&);
+}
+
+TEST_CASE( "Pooled actor handlers are serialized", "[actor]" ) {
+    const int count = 64;
+    std::atomic<int> active{ 0 };
+    std::atomic<bool> overlapped{ false };
+    auto enter = [&] {
+        if (++active > 1)
+            overlapped = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        --active;
+    };
+
+    boost::asio::io_service ios;
+    azmq::actor::pool pool(4);
+
+    // each receive starts a send, whose completion can race the next receive
+    auto s = azmq::actor::spawn(ios, pool, [&](azmq::socket & ss) {
+        ss.async_receive_loop([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+            if (ec)
+                return false;
+            enter();
+            ss.async_send(azmq::message(msg), [&](boost::system::error_code const&, size_t) {
+                enter();
+            });
+            return true;
+        });
+    });
+
+    for (auto i = 0; i < count; ++i)
+        s.send(boost::asio::buffer(&i, sizeof(i)));
+    for (auto i = 0; i < count; ++i) {
+        int res = -1;
+        s.receive(boost::asio::buffer(&res, sizeof(res)));
+        REQUIRE(res == i);
+    }
+    REQUIRE_FALSE(overlapped);
+}
+
+TEST_CASE( "Pooled actor stop", "[actor]" ) {
+    boost::asio::io_service ios;
+    azmq::actor::pool pool(1);
+
+    // from the pool's only thread, outside the stopped actor's strand
+    std::unique_ptr<azmq::socket> other(new azmq::socket(azmq::actor::spawn(ios, pool, pooled_echo)));
+    std::atomic<bool> done{ false };
+    auto s = azmq::actor::spawn(ios, pool, [&](azmq::socket &) {
+        other.reset();
+        done = true;
+    });
+    while (!done)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // once the pool has stopped
+    auto t = azmq::actor::spawn(ios, pool, pooled_echo);
+    pool.stop();
+}
+
+TEST_CASE( "Pooled actor deferred start", "[actor]" ) {
+    boost::asio::io_service ios;
+    azmq::actor::pool pool(1);
+
+    auto s = azmq::actor::spawn(ios, pool, true, pooled_echo);
+
+    azmq::actor::is_alive alive;
+    s.get_option(alive);
+    REQUIRE(!alive.value());
+
+    s.set_option(azmq::actor::start(true));
+    s.send(boost::asio::buffer("A"));
+    std::array<char, 2> buf;
+    REQUIRE(s.receive(boost::asio::buffer(buf)) == 2);
+    REQUIRE(buf[0] == 'A');
+}
@@ -0,0 +1,228 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/capture.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+namespace {
+    std::string log_path(const char* name) {
+        return std::string("/tmp/azmq-capture-") + name + "-" + std::to_string(::getpid()) + ".log";
+    }
+
+    std::string to_string(boost::asio::const_buffer b) {
+        return std::string(boost::asio::buffer_cast<char const*>(b), boost::asio::buffer_size(b));
+    }
+}
+
+TEST_CASE( "Capture records frames", "[capture]" ) {
+    auto path = log_path("record");
+    {
+        boost::asio::io_service ios;
+        azmq::pair_socket sb(ios);
+        azmq::pair_socket sc(ios);
+        sb.bind("inproc://capture-record");
+        sc.connect("inproc://capture-record");
+
+        // a tiny reservation forces the log to grow
+        auto writer = std::make_shared<azmq::capture_writer>(path, 64);
+        REQUIRE(azmq::enable_capture(sc, writer));
+        REQUIRE(!azmq::enable_capture(sc, writer));
+
+        sc.send(azmq::message("part1"), ZMQ_SNDMORE);
+        sc.send(azmq::message("part2"));
+        sc.async_send(azmq::message(std::string(10000, 'x')), [](boost::system::error_code const&, size_t) { });
+        ios.run();
+
+        azmq::message msg;
+        sb.receive(msg);
+        sb.receive(msg);
+        sb.receive(msg);
+        REQUIRE(msg.size() == 10000);
+
+        sb.send(azmq::message("reply"));
+        sc.receive(msg);
+        REQUIRE(msg.string() == "reply");
+
+        // frames which are not sent are not recorded
+        azmq::pair_socket sd(ios);
+        REQUIRE(azmq::enable_capture(sd, writer));
+        boost::system::error_code ec;
+        sd.send(azmq::message("would block"), ZMQ_DONTWAIT, ec);
+        REQUIRE(ec.value() == EAGAIN);
+        ios.reset();
+        sd.async_send(azmq::message("timed out"), [&](boost::system::error_code const& e, size_t) {
+            ec = e;
+        }, std::chrono::steady_clock::now() + std::chrono::milliseconds(5));
+        ios.run();
+        REQUIRE(ec == boost::asio::error::timed_out);
+
+        REQUIRE(azmq::disable_capture(sc));
+        sc.send(azmq::message("not captured"));
+        REQUIRE(writer->frames() == 4);
+        REQUIRE(writer->dropped() == 0);
+    }
+
+    azmq::capture_reader reader(path);
+    auto age = std::chrono::system_clock::now() - reader.start_time();
+    REQUIRE(age < std::chrono::minutes(1));
+
+    azmq::capture_reader::record r;
+    REQUIRE(reader.next(r));
+    REQUIRE(r.sent);
+    REQUIRE(r.more);
+    REQUIRE(to_string(r.data) == "part1");
+    auto t = r.time;
+
+    REQUIRE(reader.next(r));
+    REQUIRE(!r.more);
+    REQUIRE(to_string(r.data) == "part2");
+    REQUIRE(r.time >= t);
+
+    REQUIRE(reader.next(r));
+    REQUIRE(to_string(r.data) == std::string(10000, 'x'));
+
+    REQUIRE(reader.next(r));
+    REQUIRE(!r.sent);
+    REQUIRE(to_string(r.data) == "reply");
+
+    REQUIRE(!reader.next(r));
+    reader.rewind();
+    REQUIRE(reader.next(r));
+    REQUIRE(to_string(r.data) == "part1");
+    ::unlink(path.c_str());
+}
+
+TEST_CASE( "Replay", "[capture]" ) {
+    auto path = log_path("replay");
+    {
+        azmq::capture_writer writer(path);
+        std::string a = "a", b = "b", c = "c";
+        writer.write(true, true, a.data(), a.size());
+        writer.write(true, false, b.data(), b.size());
+        writer.write(false, false, "ignored", 7);
+        writer.write(true, false, c.data(), c.size());
+    }
+
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://capture-replay");
+    sc.connect("inproc://capture-replay");
+
+    azmq::capture_reader reader(path);
+    REQUIRE(azmq::replay(sc, reader) == 3);
+
+    azmq::message msg;
+    sb.receive(msg);
+    REQUIRE(msg.string() == "a");
+    REQUIRE(msg.more());
+    sb.receive(msg);
+    REQUIRE(msg.string() == "b");
+    REQUIRE(!msg.more());
+    sb.receive(msg);
+    REQUIRE(msg.string() == "c");
+
+    auto r = std::make_shared<azmq::capture_reader>(path);
+    boost::system::error_code ecc;
+    size_t frames = 0;
+    azmq::async_replay(sc, r, [&](boost::system::error_code const& ec, size_t n) {
+        ecc = ec;
+        frames = n;
+    }, azmq::replay_pace::fastest, azmq::capture_both);
+    ios.run();
+    REQUIRE(!ecc);
+    REQUIRE(frames == 4);
+    for (auto expect : { "a", "b", "ignored", "c" }) {
+        sb.receive(msg);
+        REQUIRE(msg.string() == expect);
+    }
+
+    // with nothing to replay the handler is still not called inline
+    r = std::make_shared<azmq::capture_reader>(path);
+    auto called = false;
+    azmq::async_replay(sc, r, [&](boost::system::error_code const& ec, size_t n) {
+        called = true;
+        ecc = ec;
+        frames = n;
+    }, azmq::replay_pace::fastest, 0);
+    REQUIRE(!called);
+    ios.reset();
+    ios.run();
+    REQUIRE(called);
+    REQUIRE(!ecc);
+    REQUIRE(frames == 0);
+    ::unlink(path.c_str());
+}
+
+TEST_CASE( "Replay at original pace", "[capture]" ) {
+    auto path = log_path("paced");
+    {
+        azmq::capture_writer writer(path);
+        writer.write(true, false, "1", 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        writer.write(true, false, "2", 1);
+    }
+
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://capture-paced");
+    sc.connect("inproc://capture-paced");
+
+    azmq::capture_reader reader(path);
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(azmq::replay(sc, reader, azmq::replay_pace::original) == 2);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(elapsed >= std::chrono::milliseconds(45));
+
+    auto r = std::make_shared<azmq::capture_reader>(path);
+    size_t frames = 0;
+    start = std::chrono::steady_clock::now();
+    azmq::async_replay(sc, r, [&](boost::system::error_code const&, size_t n) {
+        frames = n;
+    }, azmq::replay_pace::original);
+    ios.run();
+    elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(frames == 2);
+    REQUIRE(elapsed >= std::chrono::milliseconds(45));
+    ::unlink(path.c_str());
+}
+
+TEST_CASE( "Reader rejects other files", "[capture]" ) {
+    auto path = log_path("bad");
+    {
+        azmq::capture_writer writer(path);
+    }
+    {
+        azmq::capture_reader reader(path);
+        azmq::capture_reader::record r;
+        REQUIRE(!reader.next(r));
+    }
+    REQUIRE_THROWS(azmq::capture_reader("/nonexistent/azmq.log"));
+    {
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        std::fputs("not a capture log", f);
+        std::fclose(f);
+    }
+    REQUIRE_THROWS(azmq::capture_reader{ path });
+    ::unlink(path.c_str());
+}
@@ -0,0 +1,180 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/codec.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+namespace {
+    std::string make_payload(size_t size) {
+        std::string res;
+        while (res.size() < size)
+            res += "{\"symbol\":\"AZMQ\",\"price\":" + std::to_string(res.size() % 97) + "},";
+        res.resize(size);
+        return res;
+    }
+}
+
+TEST_CASE( "LZ round trip", "[codec]" ) {
+    using azmq::detail::lz_codec;
+    std::vector<std::string> inputs = {
+        "",
+        "a",
+        "abcd",
+        std::string(1000, 'x'),
+        make_payload(100000)
+    };
+    std::string noise;
+    for (auto i = 0; i != 5000; ++i)
+        noise.push_back(static_cast<char>((i * 2654435761u) >> 13));
+    inputs.push_back(noise);
+
+    for (auto const& in : inputs) {
+        std::vector<char> packed(lz_codec::bound(in.size()));
+        auto n = lz_codec::compress(in.data(), in.size(), packed.data(), packed.size());
+        REQUIRE(n != 0);
+        std::string out(in.size(), '\0');
+        REQUIRE(lz_codec::decompress(packed.data(), n, &out[0], out.size()));
+        REQUIRE(out == in);
+        if (in.size() > 1)
+            REQUIRE(!lz_codec::decompress(packed.data(), n, &out[0], out.size() - 1));
+    }
+}
+
+TEST_CASE( "Compressed send/receive", "[codec]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    REQUIRE(azmq::enable_codec(sb));
+    REQUIRE(azmq::enable_codec(sc));
+    REQUIRE(!azmq::enable_codec(sc));
+    sb.bind("inproc://codec");
+    sc.connect("inproc://codec");
+
+    auto payload = make_payload(10000);
+    auto sent = sc.send(azmq::message(payload));
+    REQUIRE(sent < payload.size() / 2);
+
+    azmq::message msg;
+    REQUIRE(sb.receive(msg) == payload.size());
+    REQUIRE(msg.string() == payload);
+
+    azmq::codec_counters counters;
+    sc.get_option(counters);
+    REQUIRE(counters.value().frames_encoded == 1);
+    REQUIRE(counters.value().bytes_in == payload.size());
+    REQUIRE(counters.value().ratio() < 0.5);
+    sb.get_option(counters);
+    REQUIRE(counters.value().frames_decoded == 1);
+
+    // small frames, and frames which look like codec frames, pass through
+    sc.send(azmq::message(std::string("small")));
+    sb.receive(msg);
+    REQUIRE(msg.string() == "small");
+    std::string lookalike("\x89" "AZ\x01 not really compressed");
+    sc.send(azmq::message(lookalike));
+    sb.receive(msg);
+    REQUIRE(msg.string() == lookalike);
+
+    // only the last part of a multipart message is encoded
+    sc.send(azmq::message(payload), ZMQ_SNDMORE);
+    sc.send(azmq::message(payload));
+    sb.receive(msg);
+    REQUIRE(msg.more());
+    REQUIRE(msg.string() == payload);
+    sb.receive(msg);
+    REQUIRE(!msg.more());
+    REQUIRE(msg.string() == payload);
+
+    sc.async_send(azmq::message(payload), [](boost::system::error_code const& ec, size_t) {
+        REQUIRE(!ec);
+    });
+    std::string received;
+    size_t btr = 0;
+    sb.async_receive([&](boost::system::error_code const& ec, azmq::message & m, size_t bytes_transferred) {
+        REQUIRE(!ec);
+        received = m.string();
+        btr = bytes_transferred;
+    });
+    ios.run();
+    REQUIRE(received == payload);
+    REQUIRE(btr == payload.size());
+
+    sc.set_option(azmq::codec_counters());
+    sc.set_option(azmq::codec(static_cast<int>(azmq::codec_type::none)));
+    sc.send(azmq::message(payload));
+    sb.receive(msg);
+    REQUIRE(msg.string() == payload);
+    sc.get_option(counters);
+    REQUIRE(counters.value().frames_encoded == 0);
+
+    // a failed send hands back the message as it was given, not encoded
+    azmq::pair_socket sd(ios);
+    REQUIRE(azmq::enable_codec(sd));
+    azmq::message unsent(payload);
+    boost::system::error_code ec;
+    REQUIRE(sd.send(std::move(unsent), ZMQ_DONTWAIT, ec) == 0);
+    REQUIRE(ec.value() == EAGAIN);
+    REQUIRE(unsent.string() == payload);
+}
+
+TEST_CASE( "Decoded size limit", "[codec]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    int64_t maxmsgsize = 100000;
+    zmq_setsockopt(sb.native_handle(), ZMQ_MAXMSGSIZE, &maxmsgsize, sizeof(maxmsgsize));
+    azmq::enable_codec(sb);
+    azmq::enable_codec(sc);
+    sb.bind("inproc://codec-limit");
+    sc.connect("inproc://codec-limit");
+
+    azmq::codec_max_size max_size;
+    sb.get_option(max_size);
+    REQUIRE(max_size.value() == 100000);
+
+    // compressed frames which would decode past the limit are rejected
+    auto payload = make_payload(20000);
+    sb.set_option(azmq::codec_max_size(10000));
+    sc.send(azmq::message(payload));
+    azmq::message msg;
+    boost::system::error_code ec;
+    REQUIRE(sb.receive(msg, 0, ec) == 0);
+    REQUIRE(ec == boost::system::errc::protocol_error);
+
+    sb.set_option(azmq::codec_max_size(0));
+    sc.send(azmq::message(payload));
+    sb.receive(msg);
+    REQUIRE(msg.string() == payload);
+}
+
+#ifdef AZMQ_USE_ZLIB
+TEST_CASE( "Zlib codec", "[codec]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    azmq::enable_codec(sb, azmq::codec_type::none);
+    azmq::enable_codec(sc, azmq::codec_type::zlib, 64);
+    sb.bind("inproc://codec-zlib");
+    sc.connect("inproc://codec-zlib");
+
+    auto payload = make_payload(5000);
+    REQUIRE(sc.send(azmq::message(payload)) < payload.size() / 2);
+    azmq::message msg;
+    sb.receive(msg);
+    REQUIRE(msg.string() == payload);
+}
+#endif
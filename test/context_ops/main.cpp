@@ -39,3 +39,60 @@ TEST_CASE( "context_options", "[context]" ) {
     REQUIRE(!ec);
     REQUIRE(res.value() == 2);
 }
+
+TEST_CASE( "context_policies", "[context]" ) {
+    using azmq::detail::context_ops;
+    boost::system::error_code ec;
+
+    auto g = context_ops::get_context(context_ops::context_policy::global, 0, -1, ec);
+    REQUIRE(!ec);
+    REQUIRE(g == context_ops::get_context());
+
+    auto p1 = context_ops::get_context(context_ops::context_policy::per_io_service, 2, -1, ec);
+    REQUIRE(!ec);
+    auto p2 = context_ops::get_context(context_ops::context_policy::per_io_service, 0, -1, ec);
+    REQUIRE(!ec);
+    REQUIRE(p1 != p2);
+    REQUIRE(p1 != g);
+    REQUIRE(zmq_ctx_get(p1.get(), ZMQ_IO_THREADS) == 2);
+
+    auto node = context_ops::current_numa_node();
+    REQUIRE(node >= 0);
+    auto n1 = context_ops::get_context(context_ops::context_policy::per_numa_node, 0, -1, ec);
+    REQUIRE(!ec);
+    auto n2 = context_ops::get_context(context_ops::context_policy::per_numa_node, 0, node, ec);
+    REQUIRE(!ec);
+    REQUIRE(n1 == n2);
+    REQUIRE(n1 != g);
+}
+
+TEST_CASE( "context_thread_options", "[context]" ) {
+    using azmq::detail::context_ops;
+    auto ctx = context_ops::get_context(true);
+    boost::system::error_code ec;
+
+    context_ops::set_option(ctx, context_ops::max_sockets(16), ec);
+    REQUIRE(!ec);
+    context_ops::max_sockets ms;
+    context_ops::get_option(ctx, ms, ec);
+    REQUIRE(!ec);
+    REQUIRE(ms.value() == 16);
+
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+    context_ops::set_option(ctx, context_ops::thread_affinity_cpu_add(0), ec);
+    REQUIRE(!ec);
+    context_ops::set_option(ctx, context_ops::thread_affinity_cpu_remove(0), ec);
+    REQUIRE(!ec);
+#endif
+#ifdef ZMQ_THREAD_NAME_PREFIX
+    context_ops::set_option(ctx, context_ops::thread_name_prefix(7), ec);
+    REQUIRE(!ec);
+#endif
+
+    // invalid options must now be reported
+    context_ops::set_option(ctx, context_ops::io_threads(-1), ec);
+    REQUIRE(ec);
+
+    REQUIRE(context_ops::io_thread_mask(0) == 1u);
+    REQUIRE(context_ops::io_thread_mask(3) == 8u);
+}
@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/credit.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+namespace {
+    template<typename Predicate>
+    void run_until(boost::asio::io_service & ios, Predicate pred) {
+        while (!pred()) {
+            ios.poll();
+            ios.reset();
+            std::this_thread::yield();
+        }
+    }
+}
+
+TEST_CASE( "Message credit", "[credit]" ) {
+    boost::asio::io_service ios;
+    azmq::router_socket rs(ios);
+    rs.bind("inproc://credit-messages");
+    azmq::credit_receiver receiver(std::move(rs), 4, 1 << 20);
+    azmq::dealer_socket ds(ios);
+    ds.connect("inproc://credit-messages");
+    azmq::credit_sender sender(std::move(ds));
+
+    const int count = 10;
+    int sent = 0;
+    for (auto i = 0; i != count; ++i)
+        sender.async_send(azmq::message(std::to_string(i)), [&](boost::system::error_code const& ec, size_t) {
+            REQUIRE(!ec);
+            ++sent;
+        });
+    REQUIRE(sent == 0);
+    REQUIRE(sender.pending() == count);
+
+    // nothing is sent until the receiver grants the initial window, after
+    // which at most one window is ever in flight
+    int received = 0;
+    while (received != count) {
+        receiver.async_receive([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+            REQUIRE(!ec);
+            REQUIRE(msg.string() == std::to_string(received));
+            ++received;
+        });
+        auto expected = received + 1;
+        run_until(ios, [&] { return received == expected; });
+        auto in_flight = sent - received;
+        REQUIRE(in_flight <= 4);
+    }
+    run_until(ios, [&] { return sent == count; });
+    REQUIRE(sender.pending() == 0);
+}
+
+TEST_CASE( "Byte credit", "[credit]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket rs(ios);
+    rs.bind("inproc://credit-bytes");
+    azmq::credit_receiver receiver(std::move(rs), 100, 10);
+    azmq::pair_socket ps(ios);
+    ps.connect("inproc://credit-bytes");
+    azmq::credit_sender sender(std::move(ps));
+
+    int sent = 0;
+    for (auto i = 0; i != 5; ++i)
+        sender.async_send(azmq::message(std::string("abcd")), [&](boost::system::error_code const&, size_t) {
+            ++sent;
+        });
+
+    int received = 0;
+    receiver.async_receive([&](boost::system::error_code const&, azmq::message &, size_t) {
+        ++received;
+    });
+    run_until(ios, [&] { return received == 1; });
+    // three 4 byte messages exhaust the initial 10 bytes, the first one
+    // consumed returns enough credit for one more
+    run_until(ios, [&] { return sent == 4; });
+    REQUIRE(sender.byte_credit() == -2);
+    REQUIRE(sender.pending() == 1);
+}
+
+TEST_CASE( "Sends fail once grants end", "[credit]" ) {
+    boost::asio::io_service ios;
+    azmq::dealer_socket ds(ios);
+    ds.connect("inproc://credit-ended");
+    azmq::credit_sender sender(std::move(ds));
+
+    boost::system::error_code held;
+    sender.async_send(azmq::message(std::string("A")), [&](boost::system::error_code const& ec, size_t) {
+        held = ec;
+    });
+    REQUIRE(sender.pending() == 1);
+
+    // with no receive outstanding for grants, a send waiting for credit
+    // would never complete
+    sender.get_socket().cancel();
+    run_until(ios, [&] { return !!held; });
+    REQUIRE(held == boost::asio::error::operation_aborted);
+    REQUIRE(sender.pending() == 0);
+
+    boost::system::error_code later;
+    sender.async_send(azmq::message(std::string("B")), [&](boost::system::error_code const& ec, size_t) {
+        later = ec;
+    });
+    run_until(ios, [&] { return !!later; });
+    REQUIRE(later == boost::asio::error::operation_aborted);
+}
+
+TEST_CASE( "Grants which would block", "[credit]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket rs(ios);
+    rs.set_option(azmq::socket::snd_hwm(1));
+    rs.bind("inproc://credit-blocked");
+    azmq::credit_receiver receiver(std::move(rs), 4, 1 << 20);
+
+    // a peer which reads no grants until it has sent everything
+    azmq::pair_socket ps(ios);
+    ps.set_option(azmq::socket::rcv_hwm(1));
+    ps.connect("inproc://credit-blocked");
+    const int count = 20;
+    ps.send(azmq::message());
+    for (auto i = 0; i != count; ++i)
+        ps.send(azmq::message(std::string("x")));
+
+    int received = 0;
+    std::function<void()> receive = [&] {
+        receiver.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+            if (ec)
+                return;
+            ++received;
+            receive();
+        });
+    };
+    receive();
+    run_until(ios, [&] { return received == count; });
+
+    // grants the socket could not take are written once it can, none lost
+    uint64_t messages = 0;
+    std::function<void()> read_grant = [&] {
+        ps.async_receive([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+            if (ec)
+                return;
+            uint64_t g[2];
+            REQUIRE(msg.size() == sizeof(g));
+            std::memcpy(g, boost::asio::buffer_cast<void const*>(msg.cbuffer()), sizeof(g));
+            messages += g[0];
+            read_grant();
+        });
+    };
+    read_grant();
+    run_until(ios, [&] { return messages == 4 + count; });
+}
@@ -0,0 +1,159 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/last_value_cache.hpp>
+#include <azmq/codec.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+namespace {
+    // wait for the subscription to reach the publisher
+    void sync(boost::asio::io_service & ios, azmq::pub_socket & pub,
+              azmq::last_value_cache & lvc) {
+        while (!lvc.version("sync")) {
+            pub.send(boost::asio::buffer("sync", 4));
+            ios.poll();
+            ios.reset();
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename Predicate>
+    void run_until(boost::asio::io_service & ios, Predicate pred) {
+        while (!pred()) {
+            ios.run_one();
+            ios.reset();
+        }
+    }
+}
+
+TEST_CASE( "Latest value per topic", "[last_value_cache]" ) {
+    boost::asio::io_service ios;
+    azmq::pub_socket pub(ios);
+    pub.bind("inproc://lvc-latest");
+    azmq::sub_socket sub(ios);
+    sub.set_option(azmq::socket::subscribe(""));
+    sub.connect("inproc://lvc-latest");
+
+    azmq::last_value_cache lvc(std::move(sub), 4, 16);
+    sync(ios, pub, lvc);
+
+    std::array<boost::asio::const_buffer, 2> a1 = {{ boost::asio::buffer("A", 1), boost::asio::buffer("one", 3) }};
+    std::array<boost::asio::const_buffer, 2> b1 = {{ boost::asio::buffer("B", 1), boost::asio::buffer("uno", 3) }};
+    std::array<boost::asio::const_buffer, 2> a2 = {{ boost::asio::buffer("A", 1), boost::asio::buffer("two", 3) }};
+    std::array<boost::asio::const_buffer, 2> big = {{ boost::asio::buffer("C", 1), boost::asio::buffer("0123456789abcdefX", 17) }};
+    pub.send(a1);
+    pub.send(b1);
+    pub.send(a2);
+    pub.send(big);
+    run_until(ios, [&] { return lvc.dropped() == 1; });
+
+    std::string v;
+    REQUIRE(lvc.read("A", v));
+    REQUIRE(v == "two");
+    REQUIRE(lvc.version("A") == 2);
+    REQUIRE(lvc.read("B", v));
+    REQUIRE(v == "uno");
+    REQUIRE(!lvc.read("C", v));
+    REQUIRE(lvc.dropped() == 1);
+    REQUIRE(lvc.size() == 3);
+
+    std::array<char, 2> small;
+    boost::system::error_code ec;
+    uint64_t version = 0;
+    REQUIRE(lvc.read("A", boost::asio::buffer(small), version, ec) == 3);
+    REQUIRE(ec == boost::system::errc::no_buffer_space);
+
+    ec = boost::system::error_code();
+    lvc.read("missing", boost::asio::buffer(small), version, ec);
+    REQUIRE(ec == boost::asio::error::not_found);
+}
+
+TEST_CASE( "Concurrent readers", "[last_value_cache]" ) {
+    boost::asio::io_service ios;
+    azmq::pub_socket pub(ios);
+    pub.bind("inproc://lvc-readers");
+    azmq::sub_socket sub(ios);
+    sub.set_option(azmq::socket::subscribe(""));
+    sub.connect("inproc://lvc-readers");
+
+    azmq::last_value_cache lvc(std::move(sub), 16, 64);
+    sync(ios, pub, lvc);
+
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+    for (auto i = 0; i != 2; ++i) {
+        readers.emplace_back([&] {
+            std::string v;
+            while (!done) {
+                if (!lvc.read("T", v))
+                    continue;
+                // every value is a run of a single character
+                for (auto c : v)
+                    if (c != v[0])
+                        ++torn;
+            }
+        });
+    }
+
+    const int count = 1000;
+    for (auto i = 0; i != count; ++i) {
+        std::string value(1 + i % 64, static_cast<char>('a' + i % 26));
+        std::array<boost::asio::const_buffer, 2> m = {{ boost::asio::buffer("T", 1), boost::asio::buffer(value) }};
+        pub.send(m);
+        if (i % 100 == 99)
+            run_until(ios, [&] { return lvc.version("T") == uint64_t(i + 1); });
+    }
+    done = true;
+    for (auto& t : readers)
+        t.join();
+
+    REQUIRE(torn == 0);
+    REQUIRE(lvc.version("T") == count);
+}
+
+TEST_CASE( "Receive errors", "[last_value_cache]" ) {
+    boost::asio::io_service ios;
+    azmq::pub_socket pub(ios);
+    azmq::enable_codec(pub);
+    pub.bind("inproc://lvc-errors");
+    azmq::sub_socket sub(ios);
+    sub.set_option(azmq::socket::subscribe(""));
+    azmq::enable_codec(sub);
+    sub.set_option(azmq::codec_max_size(100));
+    sub.connect("inproc://lvc-errors");
+
+    azmq::last_value_cache lvc(std::move(sub), 4, 16);
+    sync(ios, pub, lvc);
+
+    // a frame the codec refuses to decode fails its receive, which is
+    // counted, and the cache carries on
+    pub.send(azmq::message(std::string(1000, 'x')));
+    pub.send(boost::asio::buffer("A", 1));
+    run_until(ios, [&] { return lvc.version("A") == 1; });
+    REQUIRE(lvc.errors() == 1);
+    REQUIRE(lvc.dropped() == 0);
+
+    // the same error again backs off before receiving, but still carries on
+    pub.send(azmq::message(std::string(1000, 'x')));
+    pub.send(azmq::message(std::string(1000, 'x')));
+    pub.send(boost::asio::buffer("B", 1));
+    run_until(ios, [&] { return lvc.version("B") == 1; });
+    REQUIRE(lvc.errors() == 3);
+}
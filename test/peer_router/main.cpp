@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/peer_router.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <string>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+TEST_CASE( "Intern identities", "[peer_router]" ) {
+    boost::asio::io_service ios;
+    azmq::peer_router r{ azmq::router_socket(ios) };
+    auto a = r.intern("A");
+    auto b = r.intern("B");
+    REQUIRE(a != b);
+    REQUIRE(r.intern("A") == a);
+    REQUIRE(r.find("B") == b);
+    REQUIRE(r.find("C") == azmq::peer_router::npos);
+    REQUIRE(r.identity(b) == "B");
+    REQUIRE(r.size() == 2);
+
+    boost::system::error_code ec;
+    REQUIRE(!r.send(a, azmq::message("x"), ec));
+    REQUIRE(ec.value() == EHOSTUNREACH);
+    REQUIRE(r.stats(a).dropped == 1);
+}
+
+TEST_CASE( "Slow peer does not stall others", "[peer_router]" ) {
+    boost::asio::io_service ios;
+    azmq::router_socket rs(ios);
+    rs.set_option(azmq::socket::snd_hwm(2));
+    rs.bind("inproc://peer-router");
+    azmq::peer_router r(std::move(rs), 8);
+
+    azmq::dealer_socket fast(ios);
+    fast.set_option(azmq::socket::identity("fast"));
+    fast.connect("inproc://peer-router");
+    azmq::dealer_socket slow(ios);
+    slow.set_option(azmq::socket::identity("slow"));
+    slow.set_option(azmq::socket::rcv_hwm(2));
+    slow.connect("inproc://peer-router");
+
+    fast.send(boost::asio::buffer("hello", 5));
+    slow.send(boost::asio::buffer("hello", 5));
+    int hellos = 0;
+    for (auto i = 0; i != 2; ++i) {
+        r.async_receive([&](boost::system::error_code const& ec, azmq::peer_router::peer_id, azmq::message & msg) {
+            REQUIRE(!ec);
+            REQUIRE(msg.string() == "hello");
+            ++hellos;
+        });
+        ios.run();
+        ios.reset();
+    }
+    REQUIRE(hellos == 2);
+    auto f = r.find("fast");
+    auto s = r.find("slow");
+
+    const int count = 20;
+    for (auto i = 0; i != count; ++i) {
+        REQUIRE(r.send(f, azmq::message(std::to_string(i))));
+        r.send(s, azmq::message(std::to_string(i)));
+    }
+
+    auto fs = r.stats(f);
+    REQUIRE(fs.sent == count);
+    REQUIRE(fs.dropped == 0);
+    auto ss = r.stats(s);
+    REQUIRE(ss.sent < count);
+    REQUIRE(ss.queued == 8);
+    REQUIRE(ss.dropped == count - ss.sent - ss.queued);
+    REQUIRE(ss.blocked > 0);
+
+    azmq::message msg;
+    for (auto i = 0; i != count; ++i) {
+        fast.receive(msg);
+        REQUIRE(msg.string() == std::to_string(i));
+    }
+
+    // draining the slow peer lets its queue be retried
+    size_t received = 0;
+    while (received != ss.sent + ss.queued) {
+        boost::system::error_code ec;
+        if (slow.receive(msg, ZMQ_DONTWAIT, ec))
+            ++received;
+        ios.run_one();
+        ios.reset();
+    }
+    REQUIRE(r.queue_depth(s) == 0);
+    REQUIRE(r.stats(s).sent == ss.sent + ss.queued);
+}
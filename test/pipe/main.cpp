@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/pipe.hpp>
+#include <azmq/actor.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+TEST_CASE( "Send/Receive synchronous", "[pipe]" ) {
+    boost::asio::io_service ios;
+    auto p = azmq::pipe::create(ios, ios, 4);
+
+    REQUIRE(p.first.send(azmq::message(std::string("hello"))) == 5);
+
+    azmq::message msg;
+    REQUIRE(p.second.receive(msg) == 5);
+    REQUIRE(msg.string() == "hello");
+
+    boost::system::error_code ec;
+    p.second.receive(msg, ZMQ_DONTWAIT, ec);
+    REQUIRE(ec == azmq::make_error_code(EAGAIN));
+}
+
+TEST_CASE( "Full pipe", "[pipe]" ) {
+    boost::asio::io_service ios;
+    auto p = azmq::pipe::create(ios, ios, 2);
+
+    boost::system::error_code ec;
+    p.first.send(azmq::message(std::string("1")), ZMQ_DONTWAIT, ec);
+    REQUIRE(!ec);
+    p.first.send(azmq::message(std::string("2")), ZMQ_DONTWAIT, ec);
+    REQUIRE(!ec);
+    p.first.send(azmq::message(std::string("3")), ZMQ_DONTWAIT, ec);
+    REQUIRE(ec == azmq::make_error_code(EAGAIN));
+
+    boost::system::error_code ecs;
+    size_t bts = 0;
+    p.first.async_send(azmq::message(std::string("4")), [&](boost::system::error_code const& ec, size_t bt) {
+        ecs = ec;
+        bts = bt;
+    });
+
+    std::string res;
+    for (auto i = 0; i < 2; ++i) {
+        azmq::message msg;
+        p.second.receive(msg);
+        res += msg.string();
+        ios.poll();
+        ios.reset();
+    }
+    ios.run();
+    REQUIRE(ecs == boost::system::error_code());
+    REQUIRE(bts == 1);
+
+    azmq::message msg;
+    p.second.receive(msg);
+    res += msg.string();
+    REQUIRE(res == "124");
+}
+
+TEST_CASE( "Async Send/Receive across threads", "[pipe]" ) {
+    boost::asio::io_service ios_a;
+    boost::asio::io_service ios_b;
+    auto p = azmq::pipe::create(ios_a, ios_b, 8);
+
+    const int count = 10000;
+    int received = 0;
+    bool in_order = true;
+    std::function<void()> receive = [&] {
+        p.second.async_receive([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+            if (ec) return;
+            in_order = in_order && msg.buffer_cast<int>() == received;
+            if (++received < count)
+                receive();
+        });
+    };
+    receive();
+    std::thread t([&] { ios_b.run(); });
+
+    int sent = 0;
+    std::function<void()> send = [&] {
+        p.first.async_send(azmq::message(boost::asio::buffer(&sent, sizeof(sent))),
+            [&](boost::system::error_code const& ec, size_t) {
+                if (ec) return;
+                if (++sent < count)
+                    send();
+            });
+    };
+    send();
+    ios_a.run();
+    t.join();
+
+    REQUIRE(sent == count);
+    REQUIRE(received == count);
+    REQUIRE(in_order);
+}
+
+TEST_CASE( "Synchronous and async receive on one end", "[pipe]" ) {
+    // the blocked receive must neither hold up the async one nor consume
+    // the wakeup it waits on. The race is timing dependent, so repeat it
+    for (auto i = 0; i < 200; ++i) {
+        boost::asio::io_service ios;
+        auto p = azmq::pipe::create(ios, ios, 4);
+
+        std::string ra;
+        p.second.async_receive([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+            if (!ec)
+                ra = msg.string();
+        });
+        ios.poll();
+
+        std::string rs;
+        std::thread t([&] {
+            azmq::message msg;
+            p.second.receive(msg);
+            rs = msg.string();
+        });
+        std::this_thread::sleep_for(std::chrono::microseconds(i % 8 * 250));
+        p.first.send(azmq::message(std::string("1")));
+        p.first.send(azmq::message(std::string("2")));
+        ios.reset();
+        ios.run();
+        t.join();
+        auto both = ra + rs;
+        REQUIRE((both == "12" || both == "21"));
+    }
+}
+
+TEST_CASE( "Closed pipe", "[pipe]" ) {
+    boost::asio::io_service ios;
+    auto p = azmq::pipe::create(ios, ios);
+
+    boost::system::error_code ecr;
+    p.second.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+        ecr = ec;
+    });
+
+    {
+        azmq::pipe a(std::move(p.first));
+    }
+    ios.run();
+    REQUIRE(ecr == boost::asio::error::broken_pipe);
+}
+
+TEST_CASE( "Pipe actor", "[pipe]" ) {
+    boost::asio::io_service ios;
+    auto p = azmq::actor::spawn_pipe(ios, [](azmq::pipe & pp) {
+        std::function<void()> echo = [&] {
+            pp.async_receive([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+                if (ec) return;
+                pp.send(std::move(msg));
+                echo();
+            });
+        };
+        echo();
+        pp.get_io_service().run();
+    });
+
+    for (auto i = 0; i < 100; ++i) {
+        p.send(azmq::message(boost::asio::buffer(&i, sizeof(i))));
+        azmq::message msg;
+        p.receive(msg);
+        REQUIRE(msg.buffer_cast<int>() == i);
+    }
+}
@@ -9,6 +9,9 @@
 #include <azmq/signal.hpp>
 
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <array>
 
 #define CATCH_CONFIG_MAIN
 #include "../catch.hpp"
@@ -24,3 +27,71 @@ TEST_CASE( "Send/Receive a signal", "[signal]" ) {
     azmq::signal::send(sb, 123);
     REQUIRE( azmq::signal::wait(sc) == 123);
 }
+
+TEST_CASE( "Wait keeps interleaved messages", "[signal]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+
+    sb.bind("inproc://test-stash");
+    sc.connect("inproc://test-stash");
+
+    sb.send(boost::asio::buffer("A", 1));
+    azmq::signal::send(sb, 7);
+
+    azmq::signal::stash pending;
+    boost::system::error_code ec;
+    REQUIRE( azmq::signal::wait(sc, pending, ec) == 7 );
+    REQUIRE( !ec );
+    REQUIRE( pending.size() == 1 );
+    REQUIRE( pending.front().string() == "A" );
+}
+
+TEST_CASE( "Async wait", "[signal]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+
+    sb.bind("inproc://test-async");
+    sc.connect("inproc://test-async");
+
+    azmq::signal::stash pending;
+    boost::system::error_code ecc;
+    int status = -1;
+    azmq::signal::async_wait(sc, pending, [&](boost::system::error_code const& ec, uint8_t s) {
+        ecc = ec;
+        status = s;
+    });
+
+    std::array<boost::asio::const_buffer, 2> parts = {{
+        boost::asio::buffer("B", 1),
+        boost::asio::buffer("C", 1)
+    }};
+    sb.send(parts);
+    azmq::signal::send(sb, 42);
+    ios.run();
+
+    REQUIRE( !ecc );
+    REQUIRE( status == 42 );
+    REQUIRE( pending.size() == 2 );
+    REQUIRE( pending[0].string() == "B" );
+    REQUIRE( pending[1].string() == "C" );
+}
+
+#if ! defined BOOST_ASIO_WINDOWS
+TEST_CASE( "Signal over a pipe", "[signal]" ) {
+    boost::asio::io_service ios;
+    auto p = azmq::pipe::create(ios, ios);
+
+    azmq::signal::send(p.first, 5);
+    REQUIRE( azmq::signal::wait(p.second) == 5 );
+
+    int status = -1;
+    azmq::signal::async_wait(p.first, [&](boost::system::error_code const&, uint8_t s) {
+        status = s;
+    });
+    azmq::signal::send(p.second, 9);
+    ios.run();
+    REQUIRE( status == 9 );
+}
+#endif // ! defined BOOST_ASIO_WINDOWS
@@ -7,13 +7,18 @@
     file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 */
 #include <azmq/socket.hpp>
+#include <azmq/monitor.hpp>
 #include <azmq/util/scope_guard.hpp>
 
 #include <boost/utility/string_ref.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/asio/buffer.hpp>
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+#include <boost/asio/bind_cancellation_slot.hpp>
+#endif
 
+#include <algorithm>
 #include <array>
 #include <thread>
 #include <iostream>
@@ -21,6 +26,7 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <functional>
 #include <chrono>
 
 #define CATCH_CONFIG_MAIN
@@ -312,6 +318,44 @@ TEST_CASE( "Send/Receive message async", "[socket]" ) {
     REQUIRE(btb == 9);
 }
 
+TEST_CASE( "Send/Receive moved message", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind(subj(BOOST_CURRENT_FUNCTION));
+    sc.connect(subj(BOOST_CURRENT_FUNCTION));
+
+    // a moved message is given up to the operation
+    azmq::message ma("abc");
+    boost::system::error_code ecc;
+    size_t btc = 0;
+    sc.async_send(std::move(ma), [&](boost::system::error_code const& ec, size_t bytes_transferred) {
+        ecc = ec;
+        btc = bytes_transferred;
+    });
+    REQUIRE(ma.size() == 0);
+
+    // a copied message is left untouched
+    azmq::message mb(std::string(100, 'x'));
+    sc.async_send(mb, [&](boost::system::error_code const& ec, size_t) {
+        ecc = ec;
+    });
+    REQUIRE(mb.size() == 100);
+    ios.run();
+    REQUIRE(!ecc);
+    REQUIRE(btc == 3);
+
+    azmq::message msg;
+    sb.receive(msg);
+    REQUIRE(msg.string() == "abc");
+    sb.receive(msg);
+    REQUIRE(msg.size() == 100);
+
+    sc.send(azmq::message("def"));
+    sb.receive(msg);
+    REQUIRE(msg.string() == "def");
+}
+
 TEST_CASE( "Send/Receive message more async", "[socket]" ) {
     boost::asio::io_service ios_b;
     boost::asio::io_service ios_c;
@@ -483,6 +527,866 @@ TEST_CASE( "Socket Monitor", "[socket]" ) {
     CHECK(server_monitor.events_[3].e == ZMQ_EVENT_MONITOR_STOPPED);
 }
 
+TEST_CASE( "Async Monitor", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::dealer_socket client(ios);
+    azmq::dealer_socket server(ios);
+
+    std::vector<uint16_t> client_events;
+    std::string endpoint;
+    REQUIRE(azmq::async_monitor(client, ZMQ_EVENT_ALL,
+        [&](boost::system::error_code const& ec, azmq::monitor_event const& e) {
+            if (ec)
+                return;
+            client_events.push_back(e.id);
+            endpoint = e.endpoint;
+        }));
+    REQUIRE(!azmq::async_monitor(client, ZMQ_EVENT_ALL,
+        [](boost::system::error_code const&, azmq::monitor_event const&) { }));
+
+    boost::system::error_code ec;
+    REQUIRE(azmq::async_monitor(server, ec));
+    REQUIRE(!ec);
+
+    server.bind("tcp://127.0.0.1:9997");
+    client.connect("tcp://127.0.0.1:9997");
+
+    bounce(client, server);
+
+    for (auto i = 0; i < 100 && std::find(std::begin(client_events), std::end(client_events),
+                                          ZMQ_EVENT_CONNECTED) == std::end(client_events); ++i) {
+        ios.poll();
+        ios.reset();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ios.poll();
+
+    REQUIRE(std::find(std::begin(client_events), std::end(client_events),
+                      ZMQ_EVENT_CONNECTED) != std::end(client_events));
+    REQUIRE(endpoint == "tcp://127.0.0.1:9997");
+
+    auto client_stats = azmq::get_monitor_stats(client);
+    REQUIRE(client_stats.count("tcp://127.0.0.1:9997") == 1);
+    CHECK(client_stats["tcp://127.0.0.1:9997"].connects == 1);
+    CHECK(client_stats["tcp://127.0.0.1:9997"].handshake_failures == 0);
+
+    auto server_stats = azmq::get_monitor_stats(server);
+    REQUIRE(server_stats.count("tcp://127.0.0.1:9997") == 1);
+
+    azmq::dealer_socket unmonitored(ios);
+    azmq::get_monitor_stats(unmonitored, ec);
+    REQUIRE(ec);
+}
+
+TEST_CASE( "Context policies", "[socket]" ) {
+    boost::asio::io_service ios_a;
+    boost::asio::io_service ios_b;
+    REQUIRE(azmq::get_context(ios_a) == azmq::get_context(ios_b));
+
+    azmq::set_context_policy(ios_b, azmq::context_policy::per_io_service, 1);
+    REQUIRE(azmq::get_context(ios_a) != azmq::get_context(ios_b));
+
+    boost::system::error_code ec;
+    auto ctx = azmq::make_context(1, ec);
+    REQUIRE(!ec);
+    azmq::set_context(ios_a, ctx);
+    REQUIRE(azmq::get_context(ios_a) == ctx);
+
+    // inproc endpoints are only visible within a context
+    azmq::pair_socket sb(ios_a);
+    azmq::pair_socket sc(ios_b);
+    sb.bind("inproc://context-policies");
+    sc.connect("inproc://context-policies");
+    sb.send(boost::asio::buffer("A", 1), ZMQ_DONTWAIT, ec);
+    REQUIRE(ec.value() == EAGAIN);
+
+    azmq::pair_socket sd(ios_a);
+    sd.connect("inproc://context-policies");
+    sd.send(boost::asio::buffer("A", 1));
+    std::array<char, 1> buf;
+    REQUIRE(sb.receive(boost::asio::buffer(buf)) == 1);
+}
+
+TEST_CASE( "Dedicated io threads", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::dedicate_cpus(ios, { 0 }, 2);
+
+    azmq::io_threads threads;
+    azmq::get_option(ios, threads);
+    REQUIRE(threads.value() == 2);
+
+    azmq::pair_socket sb(ios);
+    sb.set_option(azmq::io_thread_affinity({ 1 }));
+    azmq::socket::affinity a;
+    sb.get_option(a);
+    REQUIRE(a.value() == 2u);
+
+    azmq::pair_socket sc(ios);
+    sc.set_option(azmq::io_thread_affinity({ 0, 1 }));
+    sc.get_option(a);
+    REQUIRE(a.value() == 3u);
+
+    sb.bind("tcp://127.0.0.1:9996");
+    sc.connect("tcp://127.0.0.1:9996");
+    sc.send(boost::asio::buffer("A", 1));
+    std::array<char, 1> buf;
+    REQUIRE(sb.receive(boost::asio::buffer(buf)) == 1);
+}
+
+TEST_CASE( "Poller reactor", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::use_poller(ios);
+    REQUIRE(boost::asio::use_service<azmq::detail::socket_service>(ios).uses_poller());
+
+    constexpr auto count = 64;
+    std::vector<azmq::pair_socket> servers;
+    std::vector<azmq::pair_socket> clients;
+    for (auto i = 0; i < count; ++i) {
+        servers.emplace_back(ios);
+        clients.emplace_back(ios);
+        auto ep = "inproc://poller-" + std::to_string(i);
+        servers.back().bind(ep);
+        clients.back().connect(ep);
+    }
+
+    auto received = 0;
+    std::function<void(azmq::socket &)> receive = [&](azmq::socket & s) {
+        s.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+            if (ec)
+                return;
+            if (++received == 2 * count)
+                ios.stop();
+            else
+                receive(s);
+        });
+    };
+    for (auto& s : servers)
+        receive(s);
+
+    std::thread t([&] {
+        for (auto round = 0; round < 2; ++round)
+            for (auto& c : clients)
+                c.send(boost::asio::buffer("A", 1));
+    });
+    ios.run();
+    t.join();
+    REQUIRE(received == 2 * count);
+}
+
+TEST_CASE( "Poller socket churn", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::use_poller(ios);
+    auto & service = boost::asio::use_service<azmq::detail::socket_service>(ios);
+
+    azmq::pair_socket sb(ios);
+    sb.bind("inproc://poller-churn");
+    for (auto i = 0; i < 32; ++i) {
+        azmq::pair_socket sc(ios);
+        sc.connect("inproc://poller-churn");
+        sc.async_receive([](boost::system::error_code const&, azmq::message &, size_t) { });
+        ios.poll();
+        ios.reset();
+    }
+    // each closed socket left the poller as it was destroyed, rather than
+    // once an event arrived on its descriptor
+    REQUIRE(service.polled() == 0);
+}
+
+TEST_CASE( "Busy poll", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://busy-poll");
+    sc.connect("inproc://busy-poll");
+
+    sb.set_option(azmq::socket::allow_speculative(false));
+    sb.set_option(azmq::socket::busy_poll_spins(1000));
+    sb.set_option(azmq::socket::busy_poll_usec(1000));
+    azmq::socket::busy_poll_usec usec;
+    sb.get_option(usec);
+    REQUIRE(usec.value() == 1000);
+
+    constexpr auto count = 100;
+    auto received = 0;
+    std::function<void()> receive = [&] {
+        sb.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+            if (ec)
+                return;
+            if (++received < count)
+                receive();
+        });
+    };
+    // with two receives queued a single message wakes the reactor and
+    // leaves it a receive to spin for, whatever the timing of the rest
+    receive();
+    receive();
+    ios.poll();
+    sc.send(boost::asio::buffer("A", 1));
+
+    std::thread t([&] {
+        for (auto i = 1; i < count; ++i)
+            sc.send(boost::asio::buffer("A", 1));
+    });
+    while (received < count)
+        ios.run_one();
+    t.join();
+
+    azmq::socket::busy_poll_counters counters;
+    sb.get_option(counters);
+    REQUIRE(counters.value().polls == counters.value().hits + counters.value().misses);
+    REQUIRE(counters.value().polls > 0);
+    REQUIRE(counters.value().probes >= counters.value().polls);
+
+    sb.set_option(azmq::socket::busy_poll_counters());
+    sb.get_option(counters);
+    REQUIRE(counters.value().polls == 0);
+}
+
+TEST_CASE( "Busy poll budget cleared", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://busy-poll-cleared");
+    sc.connect("inproc://busy-poll-cleared");
+
+    sb.set_option(azmq::socket::allow_speculative(false));
+    sb.set_option(azmq::socket::busy_poll_spins(1000));
+    sb.set_option(azmq::socket::busy_poll_usec(1000));
+
+    // the first receive's handler clears both budgets as the reactor is about
+    // to spin for the second, which must then arm the reactor rather than spin
+    // until the next message
+    auto received = 0;
+    for (auto i = 0; i != 2; ++i) {
+        sb.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+            if (ec)
+                return;
+            ++received;
+            sb.set_option(azmq::socket::busy_poll_spins(0));
+            sb.set_option(azmq::socket::busy_poll_usec(0));
+        });
+    }
+    ios.poll();
+    sc.send(boost::asio::buffer("A", 1));
+    while (received < 1)
+        ios.run_one();
+    ios.poll();
+
+    sc.send(boost::asio::buffer("B", 1));
+    while (received < 2)
+        ios.run_one();
+
+    azmq::socket::busy_poll_counters counters;
+    sb.get_option(counters);
+    REQUIRE(counters.value().polls == counters.value().hits + counters.value().misses);
+}
+
+#ifdef ZMQ_BUILD_DRAFT_API
+TEST_CASE( "Thread-safe Server/Client", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::server_socket server(ios);
+    azmq::client_socket client(ios);
+    server.bind("inproc://server-client");
+    client.connect("inproc://server-client");
+
+    client.send(boost::asio::buffer("A", 1));
+
+    azmq::message request;
+    boost::system::error_code ecr;
+    server.async_receive([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+        ecr = ec;
+        request = msg;
+    });
+    ios.run();
+    REQUIRE(!ecr);
+    REQUIRE(request.routing_id() != 0);
+
+    azmq::message reply(boost::asio::buffer("B", 1));
+    reply.set_routing_id(request.routing_id());
+    server.send(reply);
+
+    azmq::message msg;
+    client.receive(msg);
+    REQUIRE(msg.string() == "B");
+}
+#endif
+
+TEST_CASE( "Send/Receive single frame", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://single-frame");
+    sc.connect("inproc://single-frame");
+
+    std::array<boost::asio::const_buffer, 2> snd = {{
+        boost::asio::buffer("HEAD", 4),
+        boost::asio::buffer("BODY!", 5)
+    }};
+    REQUIRE(sc.send(snd, azmq::socket::single_frame) == 9);
+
+    azmq::message msg;
+    sb.receive(msg);
+    REQUIRE(!msg.more());
+    REQUIRE(msg.string() == "HEADBODY!");
+
+    sc.send(snd, azmq::socket::single_frame);
+    std::array<char, 4> head;
+    std::array<char, 5> body;
+    std::array<boost::asio::mutable_buffer, 2> rcv = {{
+        boost::asio::buffer(head),
+        boost::asio::buffer(body)
+    }};
+    REQUIRE(sb.receive(rcv, azmq::socket::single_frame) == 9);
+    REQUIRE(std::string(head.data(), head.size()) == "HEAD");
+    REQUIRE(std::string(body.data(), body.size()) == "BODY!");
+
+    // frame too large for the supplied buffers
+    sc.send(boost::asio::buffer("0123456789", 10));
+    boost::system::error_code ec;
+    sb.receive(rcv, azmq::socket::single_frame, ec);
+    REQUIRE(ec == boost::system::errc::no_buffer_space);
+
+    boost::system::error_code ecc;
+    size_t btc = 0;
+    sc.async_send(snd, [&](boost::system::error_code const& ec, size_t bytes_transferred) {
+        ecc = ec;
+        btc = bytes_transferred;
+    }, azmq::socket::single_frame);
+    ios.run();
+    REQUIRE(!ecc);
+    REQUIRE(btc == 9);
+    sb.receive(msg);
+    REQUIRE(msg.string() == "HEADBODY!");
+}
+
+struct hook_counter {
+    using ptr = std::shared_ptr<hook_counter>;
+    int sends = 0;
+    int receives = 0;
+    int send_completions = 0;
+    int receive_completions = 0;
+};
+
+// upper cases payloads on send, appends '!' on receive and counts completions
+struct hook_ext {
+    hook_counter::ptr counter_;
+
+    void on_install(boost::asio::io_service &, void *) { }
+    void on_remove() { }
+
+    template<typename Option>
+    boost::system::error_code set_option(Option const&, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    template<typename Option>
+    boost::system::error_code get_option(Option &, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    boost::system::error_code on_send(azmq::message & msg, int, boost::system::error_code & ec) {
+        ++counter_->sends;
+        auto s = msg.string();
+        std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+        msg = azmq::message(boost::asio::buffer(s));
+        return ec;
+    }
+
+    boost::system::error_code on_receive(azmq::message & msg, boost::system::error_code & ec) {
+        ++counter_->receives;
+        msg = azmq::message(boost::asio::buffer(msg.string() + "!"));
+        return ec;
+    }
+
+    void on_complete(azmq::detail::socket_ext::hook_op op, boost::system::error_code const& ec, size_t) {
+        if (ec)
+            return;
+        if (op == azmq::detail::socket_ext::hook_op::send)
+            ++counter_->send_completions;
+        else
+            ++counter_->receive_completions;
+    }
+};
+
+// only observes completions
+struct completion_ext {
+    hook_counter::ptr counter_;
+
+    void on_install(boost::asio::io_service &, void *) { }
+    void on_remove() { }
+
+    template<typename Option>
+    boost::system::error_code set_option(Option const&, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    template<typename Option>
+    boost::system::error_code get_option(Option &, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    void on_complete(azmq::detail::socket_ext::hook_op op, boost::system::error_code const&, size_t) {
+        if (op == azmq::detail::socket_ext::hook_op::send)
+            ++counter_->send_completions;
+        else
+            ++counter_->receive_completions;
+    }
+};
+
+// fails sends and receives of empty messages
+struct reject_ext {
+    void on_install(boost::asio::io_service &, void *) { }
+    void on_remove() { }
+
+    template<typename Option>
+    boost::system::error_code set_option(Option const&, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    template<typename Option>
+    boost::system::error_code get_option(Option &, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    boost::system::error_code on_send(azmq::message & msg, int, boost::system::error_code & ec) {
+        if (!msg.size())
+            ec = make_error_code(boost::system::errc::invalid_argument);
+        return ec;
+    }
+
+    boost::system::error_code on_receive(azmq::message & msg, boost::system::error_code & ec) {
+        if (!msg.size())
+            ec = make_error_code(boost::system::errc::invalid_argument);
+        return ec;
+    }
+};
+
+TEST_CASE( "Extension hooks", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://extension-hooks");
+    sc.connect("inproc://extension-hooks");
+
+    auto c = std::make_shared<hook_counter>();
+    auto b = std::make_shared<hook_counter>();
+    REQUIRE(azmq::detail::associate_ext(sc, hook_ext{ c }));
+    REQUIRE(azmq::detail::associate_ext(sb, completion_ext{ b }));
+
+    // synchronous message overloads run the message and completion hooks
+    sc.send(azmq::message("abc"));
+    REQUIRE(c->sends == 1);
+    REQUIRE(c->send_completions == 1);
+    azmq::message msg;
+    sb.receive(msg);
+    REQUIRE(msg.string() == "ABC");
+    REQUIRE(b->receive_completions == 1);
+
+    sb.send(azmq::message("xyz"));
+    REQUIRE(b->send_completions == 1);
+    sc.receive(msg);
+    REQUIRE(msg.string() == "xyz!");
+    REQUIRE(c->receives == 1);
+    REQUIRE(c->receive_completions == 1);
+
+    // buffer overloads only run completion hooks
+    sc.send(boost::asio::buffer("def", 3));
+    REQUIRE(c->sends == 1);
+    REQUIRE(c->send_completions == 2);
+    sb.receive(msg);
+    REQUIRE(msg.string() == "def");
+    REQUIRE(b->receive_completions == 2);
+
+    // asynchronous operations
+    std::string received;
+    sc.async_send(azmq::message("ghi"), [](boost::system::error_code const&, size_t) { });
+    sb.async_receive([&](boost::system::error_code const& ec, azmq::message & m, size_t) {
+        if (!ec)
+            received = m.string();
+    });
+    ios.run();
+    REQUIRE(received == "GHI");
+    REQUIRE(c->sends == 2);
+    REQUIRE(c->send_completions == 3);
+    REQUIRE(b->receive_completions == 3);
+
+    ios.reset();
+    std::array<char, 8> buf;
+    size_t btb = 0;
+    sb.async_send(boost::asio::buffer("jkl", 3), [](boost::system::error_code const&, size_t) { });
+    sc.async_receive(boost::asio::buffer(buf), [&](boost::system::error_code const& ec, size_t bytes_transferred) {
+        if (!ec)
+            btb = bytes_transferred;
+    });
+    ios.run();
+    REQUIRE(btb == 3);
+    REQUIRE(b->send_completions == 2);
+    REQUIRE(c->receive_completions == 2);
+    REQUIRE(c->receives == 1);
+
+    ios.reset();
+    sb.async_send(azmq::message("mno"), [](boost::system::error_code const&, size_t) { });
+    sc.async_receive([&](boost::system::error_code const& ec, azmq::message & m, size_t) {
+        if (!ec)
+            received = m.string();
+    });
+    ios.run();
+    REQUIRE(received == "mno!");
+    REQUIRE(c->receives == 2);
+    REQUIRE(c->receive_completions == 3);
+
+    // removing the extensions removes the hooks
+    auto removed = azmq::detail::remove_ext<azmq::pair_socket, hook_ext>(sc);
+    REQUIRE(removed);
+    sc.send(azmq::message("pqr"));
+    sb.receive(msg);
+    REQUIRE(msg.string() == "pqr");
+    REQUIRE(c->sends == 2);
+    REQUIRE(c->send_completions == 3);
+
+    // a failed send hook fails the send, without sending anything
+    REQUIRE(azmq::detail::associate_ext(sc, reject_ext{ }));
+    boost::system::error_code ec;
+    REQUIRE(sc.send(azmq::message(), 0, ec) == 0);
+    REQUIRE(ec == boost::system::errc::invalid_argument);
+
+    ios.reset();
+    boost::system::error_code aec;
+    auto called = false;
+    sc.async_send(azmq::message(), [&](boost::system::error_code const& ec, size_t) {
+        called = true;
+        aec = ec;
+    });
+    REQUIRE(!called);
+    ios.run();
+    REQUIRE(called);
+    REQUIRE(aec == boost::system::errc::invalid_argument);
+    REQUIRE(sb.receive(msg, ZMQ_DONTWAIT, ec) == 0);
+    REQUIRE(ec.value() == EAGAIN);
+}
+
+// appends its tag to each message sent and received
+template<char Tag>
+struct tag_ext {
+    void on_install(boost::asio::io_service &, void *) { }
+    void on_remove() { }
+
+    template<typename Option>
+    boost::system::error_code set_option(Option const&, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    template<typename Option>
+    boost::system::error_code get_option(Option &, boost::system::error_code & ec) {
+        return ec = make_error_code(boost::system::errc::not_supported);
+    }
+
+    boost::system::error_code on_send(azmq::message & msg, int, boost::system::error_code & ec) {
+        msg = azmq::message(msg.string() + Tag);
+        return ec;
+    }
+
+    boost::system::error_code on_receive(azmq::message & msg, boost::system::error_code & ec) {
+        msg = azmq::message(msg.string() + Tag);
+        return ec;
+    }
+};
+
+TEST_CASE( "Extension hook order", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://extension-hook-order");
+    sc.connect("inproc://extension-hook-order");
+
+    // send hooks run in install order, receive hooks in the reverse
+    REQUIRE(azmq::detail::associate_ext(sc, tag_ext<'a'>{ }));
+    REQUIRE(azmq::detail::associate_ext(sc, tag_ext<'b'>{ }));
+    REQUIRE(azmq::detail::associate_ext(sb, tag_ext<'b'>{ }));
+    REQUIRE(azmq::detail::associate_ext(sb, tag_ext<'a'>{ }));
+
+    azmq::message msg;
+    sc.send(azmq::message("x"));
+    sb.receive(msg);
+    REQUIRE(msg.string() == "xabab");
+
+    sb.send(azmq::message("y"));
+    sc.receive(msg);
+    REQUIRE(msg.string() == "ybaba");
+
+    // reinstalling an extension moves it last
+    auto removed = azmq::detail::remove_ext<azmq::pair_socket, tag_ext<'a'>>(sc);
+    REQUIRE(removed);
+    REQUIRE(azmq::detail::associate_ext(sc, tag_ext<'a'>{ }));
+    sc.send(azmq::message("z"));
+    sb.receive(msg);
+    REQUIRE(msg.string() == "zbaab");
+}
+
+TEST_CASE( "Async wait", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://async-wait");
+    sc.connect("inproc://async-wait");
+
+    // an idle pair socket is writable but not readable
+    boost::system::error_code ecw = make_error_code(boost::system::errc::timed_out);
+    sc.async_wait(azmq::socket::wait_type::write, [&](boost::system::error_code const& ec) {
+        ecw = ec;
+    });
+    auto readable = false;
+    sb.async_wait(azmq::socket::wait_type::read, [&](boost::system::error_code const& ec) {
+        if (ec)
+            return;
+        readable = true;
+        // a single wakeup drains everything queued
+        size_t n = 0;
+        azmq::message msg;
+        boost::system::error_code rec;
+        while (sb.receive(msg, ZMQ_DONTWAIT, rec), !rec)
+            ++n;
+        REQUIRE(rec.value() == EAGAIN);
+        REQUIRE(n == 3);
+    });
+    ios.poll();
+    ios.reset();
+    REQUIRE(!ecw);
+    REQUIRE(!readable);
+
+    sc.send(boost::asio::buffer("1", 1));
+    sc.send(boost::asio::buffer("2", 1));
+    sc.send(boost::asio::buffer("3", 1));
+    while (!readable && ios.run_one())
+        ;
+    REQUIRE(readable);
+
+    // waits are cancelled like any other operation
+    ios.reset();
+    boost::system::error_code ecc;
+    sb.async_wait(azmq::socket::wait_type::read, [&](boost::system::error_code const& ec) {
+        ecc = ec;
+    });
+    sb.cancel();
+    ios.run();
+    REQUIRE(ecc == boost::asio::error::operation_aborted);
+}
+
+TEST_CASE( "Receive loop", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://receive-loop");
+    sc.connect("inproc://receive-loop");
+
+    constexpr auto count = 100;
+    for (auto i = 0; i != count; ++i)
+        sc.send(azmq::message(std::to_string(i)));
+
+    // the handler stops the loop by returning false
+    auto received = 0;
+    auto in_order = true;
+    sb.async_receive_loop([&](boost::system::error_code const& ec, azmq::message & msg, size_t) {
+        REQUIRE(!ec);
+        in_order = in_order && msg.string() == std::to_string(received);
+        return ++received < count / 2;
+    });
+    ios.run();
+    REQUIRE(received == count / 2);
+    REQUIRE(in_order);
+
+    azmq::message msg;
+    sb.receive(msg);
+    REQUIRE(msg.string() == std::to_string(count / 2));
+
+    // cancelling ends the loop with operation_aborted, also when the
+    // handler is running at the time
+    ios.reset();
+    auto calls = 0;
+    boost::system::error_code last;
+    sb.async_receive_loop([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+        ++calls;
+        last = ec;
+        if (!ec)
+            sb.cancel();
+        return true;
+    });
+    ios.run();
+    REQUIRE(calls == 2);
+    REQUIRE(last == boost::asio::error::operation_aborted);
+
+    // a loop waiting for messages
+    ios.reset();
+    calls = 0;
+    azmq::pair_socket sd(ios);
+    sd.async_receive_loop([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+        ++calls;
+        last = ec;
+        return true;
+    });
+    ios.poll();
+    sd.cancel();
+    ios.run();
+    REQUIRE(calls == 1);
+    REQUIRE(last == boost::asio::error::operation_aborted);
+
+    // a receive hook failing a message ends the loop, whatever the handler
+    // returns
+    ios.reset();
+    calls = 0;
+    azmq::pair_socket se(ios);
+    azmq::pair_socket sf(ios);
+    se.bind("inproc://receive-loop-hooked");
+    sf.connect("inproc://receive-loop-hooked");
+    REQUIRE(azmq::detail::associate_ext(se, reject_ext{ }));
+    sf.send(azmq::message());
+    sf.send(azmq::message("not received"));
+    se.async_receive_loop([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+        ++calls;
+        last = ec;
+        return true;
+    });
+    ios.run();
+    REQUIRE(calls == 1);
+    REQUIRE(last == boost::system::errc::invalid_argument);
+}
+
+TEST_CASE( "Operation deadlines", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://deadlines");
+    sc.connect("inproc://deadlines");
+
+    using clock_type = std::chrono::steady_clock;
+    auto start = clock_type::now();
+
+    // only the expired receive is abandoned, those queued behind it remain
+    boost::system::error_code ec1, ec2, ec3;
+    auto t1 = start;
+    sb.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+        ec1 = ec;
+        t1 = clock_type::now();
+    }, start + std::chrono::milliseconds(20));
+
+    std::array<char, 16> buf;
+    size_t n2 = 0;
+    sb.async_receive(boost::asio::buffer(buf), [&](boost::system::error_code const& ec, size_t bytes_transferred) {
+        ec2 = ec;
+        n2 = bytes_transferred;
+    });
+
+    auto done3 = false;
+    sb.async_receive([&](boost::system::error_code const& ec, azmq::message &, size_t) {
+        ec3 = ec;
+        done3 = true;
+    }, start + std::chrono::seconds(30));
+
+    while (ec1 != boost::asio::error::timed_out && ios.run_one())
+        ;
+    REQUIRE(ec1 == boost::asio::error::timed_out);
+    auto elapsed = t1 - start;
+    REQUIRE(elapsed >= std::chrono::milliseconds(20));
+    REQUIRE(n2 == 0);
+
+    sc.send(boost::asio::buffer("abc", 3));
+    while (!n2 && ios.run_one())
+        ;
+    REQUIRE(!ec2);
+    REQUIRE(n2 == 3);
+
+    // cancelling releases the remaining deadline
+    ios.reset();
+    sb.cancel();
+    ios.run();
+    REQUIRE(done3);
+    REQUIRE(ec3 == boost::asio::error::operation_aborted);
+
+    // a pair socket without a peer never becomes writable
+    ios.reset();
+    azmq::pair_socket sd(ios);
+    boost::system::error_code ecs;
+    sd.async_send(azmq::message("xyz"), [&](boost::system::error_code const& ec, size_t) {
+        ecs = ec;
+    }, clock_type::now() + std::chrono::milliseconds(5));
+    ios.run();
+    REQUIRE(ecs == boost::asio::error::timed_out);
+
+    // many outstanding deadlines expire in order
+    ios.reset();
+    std::vector<int> order;
+    start = clock_type::now();
+    for (auto i = 0; i != 200; ++i) {
+        sb.async_receive([&order, i](boost::system::error_code const& ec, azmq::message &, size_t) {
+            if (ec == boost::asio::error::timed_out)
+                order.push_back(i);
+        }, start + std::chrono::milliseconds(i / 10));
+    }
+    ios.run();
+    REQUIRE(order.size() == 200);
+    auto sorted = std::is_sorted(std::begin(order), std::end(order));
+    REQUIRE(sorted);
+}
+
+#ifdef AZMQ_DETAIL_HAS_CANCELLATION_SLOT
+TEST_CASE( "Cancellation slots", "[socket]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://cancellation-slots");
+    sc.connect("inproc://cancellation-slots");
+
+    // emitting a slot cancels only the op bound to it
+    boost::asio::cancellation_signal sig;
+    boost::system::error_code ec1;
+    auto done1 = false;
+    sb.async_receive(boost::asio::bind_cancellation_slot(sig.slot(),
+        [&](boost::system::error_code const& ec, azmq::message &, size_t) {
+            ec1 = ec;
+            done1 = true;
+        }));
+    size_t n2 = 0;
+    sb.async_receive([&](boost::system::error_code const&, azmq::message &, size_t bytes_transferred) {
+        n2 = bytes_transferred;
+    });
+    ios.poll();
+    REQUIRE(!done1);
+
+    sig.emit(boost::asio::cancellation_type::terminal);
+    while (!done1 && ios.run_one())
+        ;
+    REQUIRE(ec1 == boost::asio::error::operation_aborted);
+
+    sc.send(boost::asio::buffer("abc", 3));
+    while (!n2 && ios.run_one())
+        ;
+    REQUIRE(n2 == 3);
+
+    // once the op has completed its slot is free
+    auto connected = sig.slot().has_handler();
+    REQUIRE(!connected);
+
+    // a loop whose slot is emitted from its handler ends with
+    // operation_aborted rather than being requeued
+    ios.reset();
+    boost::asio::cancellation_signal lsig;
+    auto calls = 0;
+    boost::system::error_code last;
+    sc.send(boost::asio::buffer("def", 3));
+    sb.async_receive_loop(boost::asio::bind_cancellation_slot(lsig.slot(),
+        [&](boost::system::error_code const& ec, azmq::message &, size_t) {
+            ++calls;
+            last = ec;
+            if (!ec)
+                lsig.emit(boost::asio::cancellation_type::terminal);
+            return true;
+        }));
+    ios.run();
+    REQUIRE(calls == 2);
+    REQUIRE(last == boost::asio::error::operation_aborted);
+}
+#endif
+
 TEST_CASE( "Attach Method", "[socket]" ) {
     using namespace boost::algorithm;
     boost::asio::io_service ios;
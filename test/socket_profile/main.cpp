@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/socket_profile.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+TEST_CASE( "Profile set replaces", "[socket_profile]" ) {
+    azmq::socket_profile p;
+    REQUIRE(p.empty());
+    p.set(azmq::socket::snd_hwm(10))
+     .set(azmq::socket::rcv_hwm(20))
+     .set(azmq::socket::snd_hwm(30));
+    REQUIRE(p.size() == 2);
+    REQUIRE(p.begin()->name() == ZMQ_SNDHWM);
+    REQUIRE(*static_cast<int const*>(p.begin()->data()) == 30);
+}
+
+TEST_CASE( "Profile apply", "[socket_profile]" ) {
+    boost::asio::io_service ios;
+    azmq::socket_profile p;
+    p.set(azmq::socket::snd_hwm(42))
+     .set(azmq::socket::linger(7))
+     .set(azmq::socket::identity("peer-1"))
+     .set(azmq::socket::allow_speculative(false));
+
+    azmq::dealer_socket s(ios);
+    p.apply(s);
+
+    azmq::socket::snd_hwm hwm;
+    s.get_option(hwm);
+    REQUIRE(hwm.value() == 42);
+    azmq::socket::linger linger;
+    s.get_option(linger);
+    REQUIRE(linger.value() == 7);
+    azmq::socket::allow_speculative spec;
+    s.get_option(spec);
+    REQUIRE(!spec.value());
+
+    // the first failing option stops the rest
+    azmq::socket_profile bad;
+    bad.set(azmq::socket::rcv_hwm(5))
+       .set(azmq::opt::integer<9999>(1))
+       .set(azmq::socket::snd_hwm(6));
+    boost::system::error_code ec;
+    bad.apply(s, ec);
+    REQUIRE(ec);
+    azmq::socket::rcv_hwm rhwm;
+    s.get_option(rhwm);
+    REQUIRE(rhwm.value() == 5);
+    s.get_option(hwm);
+    REQUIRE(hwm.value() == 42);
+}
+
+TEST_CASE( "Presets", "[socket_profile]" ) {
+    boost::asio::io_service ios;
+    azmq::dealer_socket s(ios);
+    azmq::socket_profile::low_latency().apply(s);
+    azmq::socket::immediate imm;
+    s.get_option(imm);
+    REQUIRE(imm.value());
+    azmq::socket::tcp_keepalive ka;
+    s.get_option(ka);
+    REQUIRE(ka.value() == 1);
+
+    azmq::socket_profile::high_throughput().apply(s);
+    azmq::socket::rcv_hwm hwm;
+    s.get_option(hwm);
+    REQUIRE(hwm.value() == 100000);
+    s.get_option(imm);
+    REQUIRE(!imm.value());
+}
+
+TEST_CASE( "Factory", "[socket_profile]" ) {
+    boost::asio::io_service ios;
+    auto profile = azmq::socket_profile::low_latency();
+    profile.set(azmq::socket::rcv_hwm(123));
+    azmq::socket_factory f(ios, ZMQ_PAIR, profile);
+
+    auto sockets = f.create(16);
+    REQUIRE(sockets.size() == 16);
+    for (auto & s : sockets) {
+        azmq::socket::rcv_hwm hwm;
+        s.get_option(hwm);
+        REQUIRE(hwm.value() == 123);
+    }
+
+    auto sb = f.create();
+    auto sc = f.create();
+    sb.bind("inproc://socket-factory");
+    sc.connect("inproc://socket-factory");
+    sc.send(boost::asio::buffer("hello", 5));
+    std::array<char, 5> buf;
+    REQUIRE(sb.receive(boost::asio::buffer(buf)) == 5);
+
+    // validation happens once, at construction
+    azmq::socket_profile bad;
+    bad.set(azmq::socket::subscribe("topic"));
+    REQUIRE_THROWS(azmq::socket_factory(ios, ZMQ_DEALER, bad));
+    azmq::socket_factory ok(ios, ZMQ_SUB, bad);
+    REQUIRE(ok.create(2).size() == 2);
+}
@@ -0,0 +1,139 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/spill.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+namespace {
+    struct temp_dir {
+        std::string path;
+
+        temp_dir() {
+            char tmpl[] = "/tmp/azmq-spill-XXXXXX";
+            path = ::mkdtemp(tmpl);
+        }
+
+        ~temp_dir() { ::rmdir(path.c_str()); }
+
+        size_t files() const {
+            size_t res = 0;
+            if (auto d = ::opendir(path.c_str())) {
+                while (auto e = ::readdir(d)) {
+                    if (e->d_name[0] != '.')
+                        ++res;
+                }
+                ::closedir(d);
+            }
+            return res;
+        }
+    };
+
+    std::string payload(size_t i) {
+        auto res = std::to_string(i);
+        res.resize(1000, '.');
+        return res;
+    }
+}
+
+TEST_CASE( "Spill log", "[spill]" ) {
+    temp_dir dir;
+    {
+        azmq::detail::spill_log log(dir.path, 4096);
+        boost::system::error_code ec;
+        for (size_t i = 0; i != 20; ++i)
+            log.push(boost::asio::buffer(payload(i)), ec);
+        REQUIRE(!ec);
+        REQUIRE(log.size() == 20);
+        REQUIRE(log.bytes() == 20000);
+        REQUIRE(log.segments() > 1);
+        REQUIRE(dir.files() == log.segments());
+
+        for (size_t i = 0; i != 20; ++i) {
+            auto b = log.front();
+            REQUIRE(std::string(boost::asio::buffer_cast<char const*>(b), boost::asio::buffer_size(b)) == payload(i));
+            log.pop(ec);
+            REQUIRE(!ec);
+        }
+        REQUIRE(log.empty());
+        REQUIRE(log.segments() == 1);
+
+        // an oversized frame gets a segment to itself
+        std::string big(10000, 'x');
+        log.push(boost::asio::buffer(big), ec);
+        log.push(boost::asio::buffer(payload(0)), ec);
+        REQUIRE(boost::asio::buffer_size(log.front()) == big.size());
+        log.pop(ec);
+        REQUIRE(boost::asio::buffer_size(log.front()) == 1000);
+    }
+    REQUIRE(dir.files() == 0);
+}
+
+TEST_CASE( "Spill when the consumer stalls", "[spill]" ) {
+    temp_dir dir;
+    boost::asio::io_service ios;
+    azmq::pull_socket pull(ios);
+    pull.set_option(azmq::socket::rcv_hwm(10));
+    pull.bind("inproc://spill-stall");
+
+    azmq::push_socket push(ios);
+    push.set_option(azmq::socket::snd_hwm(10));
+    push.connect("inproc://spill-stall");
+
+    size_t const count = 500;
+    {
+        azmq::spill_sender s(std::move(push), dir.path, 10 * 1000, 16 * 1024);
+        for (size_t i = 0; i != count; ++i)
+            s.send(azmq::message(payload(i)));
+
+        auto st = s.stats();
+        REQUIRE(st.sent > 0);
+        REQUIRE(st.memory_messages > 0);
+        REQUIRE(st.memory_bytes <= 10 * 1000);
+        REQUIRE(st.disk_messages > 0);
+        REQUIRE(st.segments > 1);
+        REQUIRE(st.spilled == st.disk_messages);
+        REQUIRE(s.depth() == count - st.sent);
+        REQUIRE(dir.files() == st.segments);
+
+        // the consumer resumes, everything arrives in order
+        std::vector<std::string> received;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (received.size() < count && std::chrono::steady_clock::now() < deadline) {
+            ios.poll();
+            ios.reset();
+            azmq::message msg;
+            boost::system::error_code ec;
+            pull.receive(msg, ZMQ_DONTWAIT, ec);
+            if (!ec)
+                received.push_back(msg.string());
+        }
+        REQUIRE(received.size() == count);
+        for (size_t i = 0; i != count; ++i)
+            REQUIRE(received[i] == payload(i));
+
+        st = s.stats();
+        REQUIRE(st.sent == count);
+        REQUIRE(st.dropped == 0);
+        REQUIRE(s.depth() == 0);
+        REQUIRE(st.segments <= 1);
+    }
+    REQUIRE(dir.files() == 0);
+}
@@ -0,0 +1,116 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/stream.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+TEST_CASE( "Stream a buffer", "[stream]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://stream-buffer");
+    sc.connect("inproc://stream-buffer");
+
+    std::string object;
+    for (auto i = 0; i != 1000; ++i)
+        object += std::to_string(i);
+
+    boost::system::error_code ecs;
+    size_t sent = 0;
+    azmq::async_send_stream(sc, azmq::buffer_source(boost::asio::buffer(object)),
+                            [&](boost::system::error_code const& ec, size_t bytes_transferred) {
+                                ecs = ec;
+                                sent = bytes_transferred;
+                            }, 100, 2);
+
+    std::string result;
+    size_t chunks = 0;
+    size_t largest = 0;
+    boost::system::error_code ecr;
+    size_t received = 0;
+    azmq::async_receive_stream(sb, [&](boost::asio::const_buffer chunk) {
+                                   ++chunks;
+                                   largest = std::max(largest, boost::asio::buffer_size(chunk));
+                                   result.append(boost::asio::buffer_cast<char const*>(chunk),
+                                                 boost::asio::buffer_size(chunk));
+                               },
+                               [&](boost::system::error_code const& ec, size_t bytes_transferred) {
+                                   ecr = ec;
+                                   received = bytes_transferred;
+                               });
+    ios.run();
+
+    REQUIRE(!ecs);
+    REQUIRE(!ecr);
+    REQUIRE(sent == object.size());
+    REQUIRE(received == object.size());
+    REQUIRE(result == object);
+    REQUIRE(largest == 100);
+    REQUIRE(chunks == (object.size() + 99) / 100);
+}
+
+TEST_CASE( "Stream a file", "[stream]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://stream-file");
+    sc.connect("inproc://stream-file");
+
+    std::vector<char> data(10000);
+    for (size_t i = 0; i != data.size(); ++i)
+        data[i] = static_cast<char>(i * 7);
+    auto f = std::tmpfile();
+    REQUIRE(f);
+    REQUIRE(std::fwrite(data.data(), 1, data.size(), f) == data.size());
+    std::fflush(f);
+    std::rewind(f);
+
+    size_t sent = 0;
+    azmq::async_send_stream(sc, azmq::descriptor_source(::fileno(f)),
+                            [&](boost::system::error_code const&, size_t bytes_transferred) {
+                                sent = bytes_transferred;
+                            }, 4096);
+
+    std::vector<char> result;
+    azmq::async_receive_stream(sb, [&](boost::asio::const_buffer chunk) {
+                                   auto p = boost::asio::buffer_cast<char const*>(chunk);
+                                   result.insert(result.end(), p, p + boost::asio::buffer_size(chunk));
+                               },
+                               [](boost::system::error_code const&, size_t) { });
+    ios.run();
+    std::fclose(f);
+
+    REQUIRE(sent == data.size());
+    REQUIRE(result == data);
+}
+
+TEST_CASE( "Stream protocol error", "[stream]" ) {
+    boost::asio::io_service ios;
+    azmq::pair_socket sb(ios);
+    azmq::pair_socket sc(ios);
+    sb.bind("inproc://stream-error");
+    sc.connect("inproc://stream-error");
+
+    sc.send(boost::asio::buffer("not a stream", 12));
+    boost::system::error_code ecr;
+    azmq::async_receive_stream(sb, [](boost::asio::const_buffer) { },
+                               [&](boost::system::error_code const& ec, size_t) { ecr = ec; });
+    ios.run();
+    REQUIRE(ecr == boost::system::errc::protocol_error);
+}
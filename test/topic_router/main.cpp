@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2013-2014 Contributors as noted in the AUTHORS file
+
+    This file is part of azmq
+
+    Distributed under the Boost Software License, Version 1.0. (See accompanying
+    file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+#include <azmq/topic_router.hpp>
+#include <azmq/codec.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/buffer.hpp>
+
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+
+TEST_CASE( "Longest prefix match", "[topic_router]" ) {
+    azmq::detail::topic_trie<int> t;
+    REQUIRE(t.insert("a", 1));
+    REQUIRE(t.insert("abc", 2));
+    REQUIRE(t.insert("b", 3));
+    REQUIRE(!t.insert("abc", 4));
+    REQUIRE(t.size() == 3);
+
+    auto match = [&](std::string const& s) {
+        auto p = t.match(s.data(), s.size());
+        return p ? *p : 0;
+    };
+    REQUIRE(match("a") == 1);
+    REQUIRE(match("ab") == 1);
+    REQUIRE(match("abcd") == 4);
+    REQUIRE(match("bz") == 3);
+    REQUIRE(match("c") == 0);
+
+    REQUIRE(t.erase("abc"));
+    REQUIRE(!t.erase("abc"));
+    REQUIRE(match("abcd") == 1);
+
+    REQUIRE(t.insert("", 5));
+    REQUIRE(match("c") == 5);
+}
+
+TEST_CASE( "Dispatch by topic", "[topic_router]" ) {
+    boost::asio::io_service ios;
+    azmq::pub_socket pub(ios);
+    pub.bind("inproc://topic-router");
+    azmq::sub_socket sub(ios);
+    sub.connect("inproc://topic-router");
+
+    azmq::topic_router router(std::move(sub));
+    std::vector<std::string> prices;
+    std::vector<std::string> trades;
+    bool synced = false;
+    router.add("sync", [&](azmq::message &) { synced = true; });
+    router.add("price.", [&](azmq::message & msg) {
+        azmq::message body;
+        router.get_socket().receive(body);
+        prices.push_back(msg.string() + "=" + body.string());
+    });
+    router.add("trade.", [&](azmq::message & msg) { trades.push_back(msg.string()); });
+    REQUIRE(router.size() == 3);
+
+    while (!synced) {
+        pub.send(boost::asio::buffer("sync", 4));
+        ios.poll();
+        ios.reset();
+        std::this_thread::yield();
+    }
+    REQUIRE(router.remove("sync"));
+    REQUIRE(!router.remove("sync"));
+
+    std::array<boost::asio::const_buffer, 2> p1 = {{ boost::asio::buffer("price.A", 7), boost::asio::buffer("10", 2) }};
+    std::array<boost::asio::const_buffer, 2> t1 = {{ boost::asio::buffer("trade.A", 7), boost::asio::buffer("ignored", 7) }};
+    pub.send(p1);
+    pub.send(t1);
+    pub.send(boost::asio::buffer("other", 5));
+    pub.send(p1);
+
+    while (prices.size() < 2) {
+        ios.run_one();
+        ios.reset();
+    }
+    REQUIRE(prices[0] == "price.A=10");
+    REQUIRE(prices[1] == "price.A=10");
+    REQUIRE(trades.size() == 1);
+    REQUIRE(trades[0] == "trade.A");
+}
+
+TEST_CASE( "Receive errors", "[topic_router]" ) {
+    boost::asio::io_service ios;
+    azmq::pub_socket pub(ios);
+    azmq::enable_codec(pub);
+    pub.bind("inproc://topic-router-errors");
+    azmq::sub_socket sub(ios);
+    azmq::enable_codec(sub);
+    sub.set_option(azmq::codec_max_size(100));
+    sub.connect("inproc://topic-router-errors");
+
+    azmq::topic_router router(std::move(sub));
+    std::vector<std::string> received;
+    router.add("", [&](azmq::message & msg) { received.push_back(msg.string()); });
+    while (received.empty()) {
+        pub.send(boost::asio::buffer("sync", 4));
+        ios.poll();
+        ios.reset();
+        std::this_thread::yield();
+    }
+
+    // frames the codec refuses to decode fail their receives, the router
+    // counts them and carries on, backing off once the error repeats
+    pub.send(azmq::message(std::string(1000, 'x')));
+    pub.send(azmq::message(std::string(1000, 'x')));
+    pub.send(boost::asio::buffer("A", 1));
+    while (received.empty() || received.back() != "A") {
+        ios.run_one();
+        ios.reset();
+    }
+    REQUIRE(router.errors() == 2);
+}